@@ -0,0 +1,115 @@
+#include "logging/Logger.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+ // Вывод справки по использованию
+void showUsage(const std::string& programName) {
+    std::cout << "Использование: " << programName << " [параметры] [файл...]\n\n";
+    std::cout << "Преобразует двоичный журнал (RecordFormat::BINARY) в текстовый формат.\n";
+    std::cout << "Без файлов читает стандартный ввод.\n\n";
+    std::cout << "Параметры:\n";
+    std::cout << "  --time-format <формат>  - формат strftime (по умолчанию: %Y-%m-%d %H:%M:%S)\n";
+    std::cout << "  --precision <0|3|6>     - знаков после секунд (по умолчанию: 3)\n";
+    std::cout << "  --min-level <УРОВЕНЬ>   - выводить записи не ниже уровня\n";
+}
+
+ // Декодирование одного потока; возвращает false при повреждённых данных
+bool decodeStream(std::istream& input, const std::string& name, logging::BinaryLogDecoder& decoder,
+                  logging::LogLevel minLevel) {
+    std::vector<char> chunk(256 * 1024);
+    std::string line;
+    logging::BinaryLogDecoder::Record record;
+
+    while (input) {
+        input.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        std::streamsize count = input.gcount();
+        if (count <= 0) {
+            break;
+        }
+        decoder.append(std::string_view(chunk.data(), static_cast<size_t>(count)));
+
+        for (;;) {
+            auto status = decoder.next(record);
+            if (status == logging::BinaryLogDecoder::Status::NEED_MORE) {
+                break;
+            }
+            if (status == logging::BinaryLogDecoder::Status::CORRUPT) {
+                std::cerr << "Ошибка: повреждённые данные в " << name << std::endl;
+                return false;
+            }
+            if (static_cast<int>(record.level) < static_cast<int>(minLevel)) {
+                continue;
+            }
+            line.clear();
+            decoder.render(line, record);
+            line.push_back('\n');
+            std::cout.write(line.data(), static_cast<std::streamsize>(line.size()));
+        }
+    }
+
+    if (decoder.hasPendingData()) {
+        std::cerr << "Предупреждение: " << name << " обрывается на середине записи" << std::endl;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::string timeFormat = "%Y-%m-%d %H:%M:%S";
+    logging::TimestampPrecision precision = logging::TimestampPrecision::MILLISECONDS;
+    logging::LogLevel minLevel = logging::LogLevel::TRACE;
+    std::vector<std::string> files;
+
+    // Парсинг аргументов командной строки
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "--time-format" || arg == "--precision" || arg == "--min-level") && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (arg == "--time-format") {
+                timeFormat = value;
+            } else if (arg == "--precision") {
+                if (value == "0") {
+                    precision = logging::TimestampPrecision::SECONDS;
+                } else if (value == "6") {
+                    precision = logging::TimestampPrecision::MICROSECONDS;
+                } else {
+                    precision = logging::TimestampPrecision::MILLISECONDS;
+                }
+            } else {
+                minLevel = logging::stringToLogLevel(value);
+            }
+        } else if (arg == "-h" || arg == "--help") {
+            showUsage(argv[0]);
+            return 0;
+        } else if (!arg.empty() && arg[0] == '-') {
+            showUsage(argv[0]);
+            return 1;
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    std::ios::sync_with_stdio(false);
+    bool ok = true;
+
+    if (files.empty()) {
+        logging::BinaryLogDecoder decoder(timeFormat, precision);
+        ok = decodeStream(std::cin, "<stdin>", decoder, minLevel);
+    }
+
+    // Каждый файл — отдельный поток со своими определениями форматов
+    for (const auto& file : files) {
+        std::ifstream input(file, std::ios::binary);
+        if (!input.is_open()) {
+            std::cerr << "Ошибка: не удалось открыть " << file << std::endl;
+            ok = false;
+            continue;
+        }
+        logging::BinaryLogDecoder decoder(timeFormat, precision);
+        ok = decodeStream(input, file, decoder, minLevel) && ok;
+    }
+
+    std::cout.flush();
+    return ok ? 0 : 1;
+}
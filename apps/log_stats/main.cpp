@@ -1,128 +1,812 @@
 #include "logging/Logger.h"
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <map>
+#include <array>
+#include <sstream>
 #include <chrono>
 #include <vector>
 #include <algorithm>
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <unordered_map>
+#include <csignal>
+#include <cerrno>
 #include <sys/socket.h>
+#include <sys/epoll.h>
+#include <poll.h>
+#include <sys/resource.h>
 #include <netinet/in.h>
+#include <arpa/inet.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <cstring>
 #include <iomanip>
+#include <cmath>
 
- // Структура для хранения статистики
+ using LevelCounts = std::array<uint64_t, logging::kLogLevelCount>;
+
+ // Счётчик одного писателя: без атомарного RMW, читатели видят значение целиком
+inline void bump(std::atomic<uint64_t>& counter, uint64_t delta) {
+    counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+ // Счётчики сообщений в скользящих окнах (например, 1 мин, 5 мин, 1 ч):
+ // кольцо посекундных корзин с разбивкой по уровням на длину самого длинного окна.
+ // Пишет один поток за O(1), память фиксирована и не зависит от потока сообщений;
+ // читатель в любой момент складывает корзины, попавшие в окна.
+class SlidingWindowCounters {
+public:
+    explicit SlidingWindowCounters(size_t longestWindow) : ring_(std::max<size_t>(longestWindow, 1)) {}
+    
+    void add(int64_t second, logging::LogLevel level) {
+        Bucket& bucket = ring_[static_cast<size_t>(second) % ring_.size()];
+        if (bucket.second.load(std::memory_order_relaxed) != second) {
+            // Корзина переходит к новой секунде; пока идёт сброс, читатель её пропускает
+            bucket.second.store(kResetting, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (auto& count : bucket.counts) {
+                count.store(0, std::memory_order_relaxed);
+            }
+            bucket.second.store(second, std::memory_order_release);
+        }
+        bump(bucket.counts[static_cast<size_t>(level)], 1);
+    }
+    
+    // Добавляет к totals[i] сообщения за windows[i] секунд, закончившихся секундой now
+    void collect(int64_t now, const std::vector<int>& windows, std::vector<LevelCounts>& totals) const {
+        for (const Bucket& bucket : ring_) {
+            int64_t second = bucket.second.load(std::memory_order_acquire);
+            if (second < 0) {
+                continue;
+            }
+            LevelCounts counts;
+            for (size_t level = 0; level < logging::kLogLevelCount; ++level) {
+                counts[level] = bucket.counts[level].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (bucket.second.load(std::memory_order_relaxed) != second) {
+                continue; // корзину переписали во время чтения, её секунда уже вне окон
+            }
+            
+            int64_t age = std::max<int64_t>(now - second, 0);
+            for (size_t i = 0; i < windows.size(); ++i) {
+                if (age < windows[i]) {
+                    for (size_t level = 0; level < logging::kLogLevelCount; ++level) {
+                        totals[i][level] += counts[level];
+                    }
+                }
+            }
+        }
+    }
+    
+private:
+    static constexpr int64_t kEmpty = -1;
+    static constexpr int64_t kResetting = -2;
+    
+    struct Bucket {
+        std::atomic<int64_t> second{kEmpty};
+        std::atomic<uint64_t> counts[logging::kLogLevelCount] = {};
+    };
+    
+    std::vector<Bucket> ring_;
+};
+
+ // Текущая секунда монотонных часов — номер корзины скользящих окон
+int64_t currentSecond() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ // Время прихода сообщений в микросекундах тех же часов
+int64_t currentMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ // Логарифмические корзины как в HDR-гистограмме: значения до 16 точные, дальше
+ // 16 корзин на степень двойки — относительная ошибка квантиля не больше ~3%.
+ // Набор корзин один для всех эскизов, поэтому эскизы складываются поэлементно.
+namespace sketch {
+    constexpr int kSubBucketBits = 4;
+    constexpr uint64_t kSubBuckets = 1u << kSubBucketBits;
+    constexpr size_t kBucketCount = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+    inline size_t bucketIndex(uint64_t value) {
+        if (value < kSubBuckets) {
+            return static_cast<size_t>(value);
+        }
+        int exponent = 63 - __builtin_clzll(value);
+        uint64_t mantissa = (value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+        return static_cast<size_t>(exponent - kSubBucketBits + 1) * kSubBuckets + mantissa;
+    }
+
+    // Середина корзины — оценка значения при подсчёте квантиля
+    inline uint64_t bucketValue(size_t index) {
+        if (index < kSubBuckets) {
+            return index;
+        }
+        int shift = static_cast<int>(index / kSubBuckets) - 1;
+        uint64_t low = (kSubBuckets + index % kSubBuckets) << shift;
+        return low + ((uint64_t{1} << shift) >> 1);
+    }
+}
+
+ // Гистограмма снимка: результат сложения эскизов, из неё читаются квантили.
+ // Середина корзины может выйти за наблюдённые значения, поэтому квантиль
+ // ограничивается наименьшим и наибольшим из них
+class Histogram {
+public:
+    void add(size_t bucket, uint64_t count) {
+        if (count == 0) return;
+        if (counts_.empty()) counts_.resize(sketch::kBucketCount);
+        counts_[bucket] += count;
+        total_ += count;
+    }
+    
+    // Наименьшее, наибольшее и сумма значений — для ограничения квантилей и _sum в Prometheus
+    void observeRange(uint64_t minValue, uint64_t maxValue, uint64_t sum) {
+        min_ = std::min(min_, minValue);
+        max_ = std::max(max_, maxValue);
+        sum_ += sum;
+    }
+    
+    void merge(const Histogram& other) {
+        for (size_t i = 0; i < other.counts_.size(); ++i) {
+            add(i, other.counts_[i]);
+        }
+        observeRange(other.min_, other.max_, other.sum_);
+    }
+    
+    uint64_t count() const { return total_; }
+    uint64_t sum() const { return sum_; }
+    
+    uint64_t quantile(double q) const {
+        if (total_ == 0) return 0;
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(total_))));
+        uint64_t seen = 0;
+        size_t bucket = counts_.size() - 1;
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            seen += counts_[i];
+            if (seen >= rank) {
+                bucket = i;
+                break;
+            }
+        }
+        uint64_t value = sketch::bucketValue(bucket);
+        return min_ <= max_ ? std::clamp(value, min_, max_) : value;
+    }
+    
+private:
+    std::vector<uint64_t> counts_;
+    uint64_t total_ = 0;
+    uint64_t min_ = UINT64_MAX;
+    uint64_t max_ = 0;
+    uint64_t sum_ = 0;
+};
+
+ // Эскиз распределения постоянного размера; пишет один поток, читатели складывают
+ // корзины в Histogram в любой момент
+class QuantileSketch {
+public:
+    void add(uint64_t value) {
+        bump(buckets_[sketch::bucketIndex(value)], 1);
+        if (value < min_.load(std::memory_order_relaxed)) min_.store(value, std::memory_order_relaxed);
+        if (value > max_.load(std::memory_order_relaxed)) max_.store(value, std::memory_order_relaxed);
+        bump(sum_, value);
+    }
+    
+    void addTo(Histogram& histogram) const {
+        for (size_t i = 0; i < sketch::kBucketCount; ++i) {
+            histogram.add(i, buckets_[i].load(std::memory_order_relaxed));
+        }
+        histogram.observeRange(min_.load(std::memory_order_relaxed), max_.load(std::memory_order_relaxed),
+                               sum_.load(std::memory_order_relaxed));
+    }
+    
+private:
+    std::atomic<uint64_t> buckets_[sketch::kBucketCount] = {};
+    std::atomic<uint64_t> min_{UINT64_MAX};
+    std::atomic<uint64_t> max_{0};
+    std::atomic<uint64_t> sum_{0};
+};
+
+ // Распределения одного клиента (адреса): длина сообщений и интервалы между ними
+struct ClientStats {
+    std::atomic<uint64_t> messages{0};
+    QuantileSketch length;
+    QuantileSketch gapMicros;
+};
+
+ // Сводка клиента в снимке
+struct ClientSummary {
+    uint64_t messages = 0;
+    Histogram length;
+    Histogram gapMicros;
+};
+
+ // Сообщения с одним значением тега группировки (--group-by): по уровням и длина
+struct GroupStats {
+    std::atomic<uint64_t> messages{0};
+    std::atomic<uint64_t> messagesByLevel[logging::kLogLevelCount] = {};
+    QuantileSketch length;
+};
+
+ // Сводка значения тега в снимке
+struct GroupSummary {
+    uint64_t messages = 0;
+    LevelCounts messagesByLevel{};
+    Histogram length;
+};
+
+ // Строка в кавычках для JSON и меток Prometheus: экранируются '\\' и '"'
+std::string quotedString(std::string_view text) {
+    std::string result = "\"";
+    for (char c : text) {
+        if (c == '\\' || c == '"') result.push_back('\\');
+        result.push_back(c);
+    }
+    result.push_back('"');
+    return result;
+}
+
+ // Подпись окна: 45 с, 5 мин, 1 ч
+std::string formatWindow(int seconds) {
+    if (seconds % 3600 == 0) return std::to_string(seconds / 3600) + " ч";
+    if (seconds % 60 == 0) return std::to_string(seconds / 60) + " мин";
+    return std::to_string(seconds) + " с";
+}
+
+ // Снимок статистики, сложенный из долей всех потоков приёма
 struct LogStatistics {
     // Счетчики сообщений
-    size_t totalMessages = 0;
-    std::map<logging::LogLevel, size_t> messagesByLevel;
-    size_t messagesLastHour = 0;
+    uint64_t totalMessages = 0;
+    LevelCounts messagesByLevel{};
+    
+    // Сообщения за последние минуты и часы: recent[i] — за windows[i] секунд
+    std::vector<int> windows;
+    std::vector<LevelCounts> recent;
     
     // Статистика длин сообщений
-    size_t minLength = SIZE_MAX;
-    size_t maxLength = 0;
-    double avgLength = 0.0;
-    size_t totalLength = 0;
+    uint64_t minLength = UINT64_MAX;
+    uint64_t maxLength = 0;
+    uint64_t totalLength = 0;
     
-    // Временные метки для подсчета сообщений за последний час
-    std::vector<std::chrono::system_clock::time_point> timestamps;
+    // Распределения длин и интервалов прихода (мкс) по уровням и по клиентам
+    std::array<Histogram, logging::kLogLevelCount> lengthByLevel;
+    std::array<Histogram, logging::kLogLevelCount> gapByLevel;
+    std::map<std::string, ClientSummary> clients;
     
-    // Время последней выдачи статистики
-    std::chrono::system_clock::time_point lastStatsOutput = std::chrono::system_clock::now();
-    bool statsChanged = false;
-
-    void addMessage(const std::string& message, logging::LogLevel level) {
-        auto now = std::chrono::system_clock::now();
+    // Группировка по значению тега контекста; groupKey пуст — группировка выключена
+    std::string groupKey;
+    std::map<std::string, GroupSummary> groups;
+    
+    static void printQuantiles(std::ostream& out, const std::string& name, const Histogram& histogram) {
+        if (histogram.count() == 0) return;
+        out << "  " << name << ": " << histogram.quantile(0.5) << " / " << histogram.quantile(0.9)
+                  << " / " << histogram.quantile(0.99) << " / " << histogram.quantile(0.999) << '\n';
+    }
+    
+    // Квантили по уровням и итог по всем уровням
+    static void printLevelQuantiles(std::ostream& out, const std::string& title,
+                                    const std::array<Histogram, logging::kLogLevelCount>& byLevel,
+                                    const Histogram& overall) {
+        if (overall.count() == 0) return;
+        out << title << " (p50 / p90 / p99 / p99.9):" << '\n';
+        printQuantiles(out, "все", overall);
+        for (size_t level = 0; level < logging::kLogLevelCount; ++level) {
+            printQuantiles(out, logging::logLevelToString(static_cast<logging::LogLevel>(level)), byLevel[level]);
+        }
+    }
+    
+    // Текст собирается целиком и выводится одной записью
+    void printStatistics() const {
+        std::ostringstream out;
+        out << "\n=== СТАТИСТИКА ЛОГОВ ===" << '\n';
+        out << "Всего сообщений: " << totalMessages << '\n';
+        
+        out << "По уровням важности:" << '\n';
+        for (size_t level = 0; level < logging::kLogLevelCount; ++level) {
+            if (messagesByLevel[level] > 0) {
+                out << "  " << logging::logLevelToString(static_cast<logging::LogLevel>(level))
+                          << ": " << messagesByLevel[level] << '\n';
+            }
+        }
+        
+        for (size_t i = 0; i < windows.size(); ++i) {
+            uint64_t total = 0;
+            for (uint64_t count : recent[i]) {
+                total += count;
+            }
+            out << "За последние " << formatWindow(windows[i]) << ": " << total;
+            const char* separator = " (";
+            for (size_t level = 0; level < logging::kLogLevelCount; ++level) {
+                if (recent[i][level] > 0) {
+                    out << separator << logging::logLevelToString(static_cast<logging::LogLevel>(level))
+                              << ": " << recent[i][level];
+                    separator = ", ";
+                }
+            }
+            out << (total > 0 ? ")" : "") << '\n';
+        }
+        
+        if (totalMessages > 0) {
+            double avgLength = static_cast<double>(totalLength) / static_cast<double>(totalMessages);
+            out << "Длины сообщений:" << '\n';
+            out << "  Минимум: " << (minLength == UINT64_MAX ? 0 : minLength) << '\n';
+            out << "  Максимум: " << maxLength << '\n';
+            out << "  Среднее: " << std::fixed << std::setprecision(2) << avgLength << '\n';
+        }
+        
+        printLevelQuantiles(out, "Квантили длины", lengthByLevel, allLengths());
+        printLevelQuantiles(out, "Интервалы между чтениями с сообщениями клиента, мкс", gapByLevel, allGaps());
+        
+        printClients(out);
+        printGroups(out);
         
-        // Обновляем общую статистику
-        totalMessages++;
-        messagesByLevel[level]++;
+        out << "========================\n" << '\n';
         
-        // Обновляем статистику длин
-        size_t messageLength = message.length();
-        totalLength += messageLength;
-        minLength = std::min(minLength, messageLength);
-        maxLength = std::max(maxLength, messageLength);
-        avgLength = static_cast<double>(totalLength) / totalMessages;
+        std::string text = out.str();
+        std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+        std::cout.flush();
+    }
+    
+    // Самые активные клиенты: длина и интервал (p50 / p99)
+    void printClients(std::ostream& out) const {
+        constexpr size_t kMaxClientsShown = 10;
+        if (clients.empty()) return;
         
-        // Добавляем временную метку
-        timestamps.push_back(now);
+        std::vector<const std::pair<const std::string, ClientSummary>*> busiest;
+        for (const auto& entry : clients) {
+            busiest.push_back(&entry);
+        }
+        std::sort(busiest.begin(), busiest.end(), [](const auto* a, const auto* b) {
+            return a->second.messages > b->second.messages;
+        });
         
-        // Очищаем старые метки (старше часа)
-        auto hourAgo = now - std::chrono::hours(1);
-        timestamps.erase(
-            std::remove_if(timestamps.begin(), timestamps.end(),
-                [hourAgo](const auto& timestamp) { return timestamp < hourAgo; }),
-            timestamps.end()
-        );
+        out << "По клиентам (длина p50 / p99, интервал мкс p50 / p99):" << '\n';
+        for (size_t i = 0; i < std::min(busiest.size(), kMaxClientsShown); ++i) {
+            const auto& [name, client] = *busiest[i];
+            out << "  " << name << ": " << client.messages << " сообщ., длина "
+                      << client.length.quantile(0.5) << " / " << client.length.quantile(0.99) << ", интервал "
+                      << client.gapMicros.quantile(0.5) << " / " << client.gapMicros.quantile(0.99) << '\n';
+        }
+        if (busiest.size() > kMaxClientsShown) {
+            out << "  ... и ещё " << (busiest.size() - kMaxClientsShown) << '\n';
+        }
+    }
+    
+    // Самые частые значения тега: сообщения, ошибки и длина (p50 / p99)
+    void printGroups(std::ostream& out) const {
+        constexpr size_t kMaxGroupsShown = 10;
+        if (groupKey.empty() || groups.empty()) return;
         
-        messagesLastHour = timestamps.size();
-        statsChanged = true;
+        std::vector<const std::pair<const std::string, GroupSummary>*> busiest;
+        for (const auto& entry : groups) {
+            busiest.push_back(&entry);
+        }
+        std::sort(busiest.begin(), busiest.end(), [](const auto* a, const auto* b) {
+            return a->second.messages > b->second.messages;
+        });
+        
+        const size_t error = static_cast<size_t>(logging::LogLevel::ERROR);
+        const size_t fatal = static_cast<size_t>(logging::LogLevel::FATAL);
+        out << "По тегу " << groupKey << " (сообщ., ERROR и выше, длина p50 / p99):" << '\n';
+        for (size_t i = 0; i < std::min(busiest.size(), kMaxGroupsShown); ++i) {
+            const auto& [value, group] = *busiest[i];
+            out << "  " << value << ": " << group.messages << " сообщ., ошибок "
+                      << group.messagesByLevel[error] + group.messagesByLevel[fatal] << ", длина "
+                      << group.length.quantile(0.5) << " / " << group.length.quantile(0.99) << '\n';
+        }
+        if (busiest.size() > kMaxGroupsShown) {
+            out << "  ... и ещё " << (busiest.size() - kMaxGroupsShown) << '\n';
+        }
+    }
+    
+    Histogram allLengths() const {
+        Histogram result;
+        for (const auto& histogram : lengthByLevel) {
+            result.merge(histogram);
+        }
+        return result;
+    }
+    
+    Histogram allGaps() const {
+        Histogram result;
+        for (const auto& [name, client] : clients) {
+            result.merge(client.gapMicros);
+        }
+        return result;
     }
     
-    void printStatistics() {
-        std::cout << "\n=== СТАТИСТИКА ЛОГОВ ===" << std::endl;
-        std::cout << "Всего сообщений: " << totalMessages << std::endl;
+    // Текстовый формат Prometheus (версия 0.0.4)
+    std::string renderPrometheus() const {
+        static const std::pair<const char*, double> kQuantiles[] = {
+            {"0.5", 0.5}, {"0.9", 0.9}, {"0.99", 0.99}, {"0.999", 0.999}};
+        std::ostringstream out;
+        auto levelName = [](size_t level) { return logging::logLevelToString(static_cast<logging::LogLevel>(level)); };
+        // Сводка (summary): квантили с меткой quantile и рядом с ними _sum и _count
+        auto quantiles = [&](const char* metric, const std::string& labels, const Histogram& histogram) {
+            for (const auto& [name, q] : kQuantiles) {
+                out << metric << "{" << labels << "quantile=\"" << name << "\"} " << histogram.quantile(q) << '\n';
+            }
+            const std::string series = labels.empty() ? std::string() : "{" + labels.substr(0, labels.size() - 1) + "}";
+            out << metric << "_sum" << series << ' ' << histogram.sum() << '\n'
+                << metric << "_count" << series << ' ' << histogram.count() << '\n';
+        };
+        
+        out << "# HELP log_stats_messages_total Received log messages by level.\n"
+            << "# TYPE log_stats_messages_total counter\n";
+        for (size_t level = 0; level < logging::kLogLevelCount; ++level) {
+            out << "log_stats_messages_total{level=\"" << levelName(level) << "\"} " << messagesByLevel[level] << '\n';
+        }
         
-        std::cout << "По уровням важности:" << std::endl;
-        for (const auto& [level, count] : messagesByLevel) {
-            std::cout << "  " << logging::logLevelToString(level) << ": " << count << std::endl;
+        out << "# HELP log_stats_window_messages Messages received in the last window_seconds.\n"
+            << "# TYPE log_stats_window_messages gauge\n";
+        for (size_t i = 0; i < windows.size(); ++i) {
+            for (size_t level = 0; level < logging::kLogLevelCount; ++level) {
+                out << "log_stats_window_messages{window_seconds=\"" << windows[i] << "\",level=\""
+                    << levelName(level) << "\"} " << recent[i][level] << '\n';
+            }
         }
         
-        std::cout << "За последний час: " << messagesLastHour << std::endl;
+        out << "# HELP log_stats_message_length_bytes Message length statistics.\n"
+            << "# TYPE log_stats_message_length_bytes gauge\n"
+            << "log_stats_message_length_bytes{stat=\"min\"} " << (minLength == UINT64_MAX ? 0 : minLength) << '\n'
+            << "log_stats_message_length_bytes{stat=\"max\"} " << maxLength << '\n'
+            << "log_stats_message_length_bytes{stat=\"sum\"} " << totalLength << '\n';
         
-        if (totalMessages > 0) {
-            std::cout << "Длины сообщений:" << std::endl;
-            std::cout << "  Минимум: " << (minLength == SIZE_MAX ? 0 : minLength) << std::endl;
-            std::cout << "  Максимум: " << maxLength << std::endl;
-            std::cout << "  Среднее: " << std::fixed << std::setprecision(2) << avgLength << std::endl;
+        out << "# HELP log_stats_message_length_quantile_bytes Message length quantiles.\n"
+            << "# TYPE log_stats_message_length_quantile_bytes summary\n";
+        quantiles("log_stats_message_length_quantile_bytes", "", allLengths());
+        for (size_t level = 0; level < logging::kLogLevelCount; ++level) {
+            if (lengthByLevel[level].count() > 0) {
+                quantiles("log_stats_message_length_quantile_bytes",
+                          std::string("level=\"") + levelName(level) + "\",", lengthByLevel[level]);
+            }
         }
         
-        std::cout << "========================\n" << std::endl;
+        out << "# HELP log_stats_interarrival_quantile_microseconds Gaps between reads carrying messages of a client.\n"
+            << "# TYPE log_stats_interarrival_quantile_microseconds summary\n";
+        quantiles("log_stats_interarrival_quantile_microseconds", "", allGaps());
+        for (size_t level = 0; level < logging::kLogLevelCount; ++level) {
+            if (gapByLevel[level].count() > 0) {
+                quantiles("log_stats_interarrival_quantile_microseconds",
+                          std::string("level=\"") + levelName(level) + "\",", gapByLevel[level]);
+            }
+        }
         
-        lastStatsOutput = std::chrono::system_clock::now();
-        statsChanged = false;
+        out << "# HELP log_stats_client_messages_total Received log messages by client address.\n"
+            << "# TYPE log_stats_client_messages_total counter\n";
+        for (const auto& [name, client] : clients) {
+            out << "log_stats_client_messages_total{client=\"" << name << "\"} " << client.messages << '\n';
+        }
+        out << "# TYPE log_stats_client_message_length_quantile_bytes summary\n";
+        for (const auto& [name, client] : clients) {
+            quantiles("log_stats_client_message_length_quantile_bytes", "client=\"" + name + "\",", client.length);
+        }
+        out << "# TYPE log_stats_client_interarrival_quantile_microseconds summary\n";
+        for (const auto& [name, client] : clients) {
+            quantiles("log_stats_client_interarrival_quantile_microseconds", "client=\"" + name + "\",",
+                      client.gapMicros);
+        }
+        
+        if (!groupKey.empty()) {
+            out << "# HELP log_stats_tag_messages_total Received log messages by value of the grouping tag.\n"
+                << "# TYPE log_stats_tag_messages_total counter\n";
+            for (const auto& [value, group] : groups) {
+                for (size_t level = 0; level < logging::kLogLevelCount; ++level) {
+                    out << "log_stats_tag_messages_total{tag=" << quotedString(groupKey)
+                        << ",value=" << quotedString(value) << ",level=\"" << levelName(level) << "\"} " << group.messagesByLevel[level] << '\n';
+                }
+            }
+            out << "# TYPE log_stats_tag_message_length_quantile_bytes summary\n";
+            for (const auto& [value, group] : groups) {
+                quantiles("log_stats_tag_message_length_quantile_bytes",
+                          "tag=" + quotedString(groupKey) + ",value=" + quotedString(value) + ",", group.length);
+            }
+        }
+        return out.str();
     }
     
-    bool shouldPrintStats(size_t messagesInterval, int timeoutSeconds) const {
-        if (totalMessages % messagesInterval == 0 && totalMessages > 0) {
-            return true;
+    // Тот же снимок в JSON
+    std::string renderJson() const {
+        std::ostringstream out;
+        auto levelName = [](size_t level) { return logging::logLevelToString(static_cast<logging::LogLevel>(level)); };
+        auto levelCounts = [&](const LevelCounts& counts) {
+            out << "{";
+            for (size_t level = 0; level < logging::kLogLevelCount; ++level) {
+                out << (level ? "," : "") << "\"" << levelName(level) << "\":" << counts[level];
+            }
+            out << "}";
+        };
+        auto quantiles = [&](const Histogram& histogram) {
+            out << "{\"count\":" << histogram.count() << ",\"p50\":" << histogram.quantile(0.5)
+                << ",\"p90\":" << histogram.quantile(0.9) << ",\"p99\":" << histogram.quantile(0.99)
+                << ",\"p999\":" << histogram.quantile(0.999) << "}";
+        };
+        auto byLevel = [&](const Histogram& overall, const std::array<Histogram, logging::kLogLevelCount>& levels) {
+            out << "{\"all\":";
+            quantiles(overall);
+            for (size_t level = 0; level < logging::kLogLevelCount; ++level) {
+                if (levels[level].count() > 0) {
+                    out << ",\"" << levelName(level) << "\":";
+                    quantiles(levels[level]);
+                }
+            }
+            out << "}";
+        };
+        
+        out << "{\"totalMessages\":" << totalMessages << ",\"levels\":";
+        levelCounts(messagesByLevel);
+        out << ",\"windows\":[";
+        for (size_t i = 0; i < windows.size(); ++i) {
+            out << (i ? "," : "") << "{\"seconds\":" << windows[i] << ",\"levels\":";
+            levelCounts(recent[i]);
+            out << "}";
+        }
+        out << "],\"length\":{\"min\":" << (minLength == UINT64_MAX ? 0 : minLength) << ",\"max\":" << maxLength
+            << ",\"sum\":" << totalLength << ",\"quantiles\":";
+        byLevel(allLengths(), lengthByLevel);
+        out << "},\"gapMicros\":";
+        byLevel(allGaps(), gapByLevel);
+        out << ",\"clients\":{";
+        bool first = true;
+        for (const auto& [name, client] : clients) {
+            out << (first ? "" : ",") << "\"" << name << "\":{\"messages\":" << client.messages << ",\"length\":";
+            quantiles(client.length);
+            out << ",\"gapMicros\":";
+            quantiles(client.gapMicros);
+            out << "}";
+            first = false;
+        }
+        out << "}";
+        if (!groupKey.empty()) {
+            out << ",\"groups\":{\"tag\":" << quotedString(groupKey) << ",\"values\":{";
+            first = true;
+            for (const auto& [value, group] : groups) {
+                out << (first ? "" : ",") << quotedString(value) << ":{\"messages\":" << group.messages
+                    << ",\"levels\":";
+                levelCounts(group.messagesByLevel);
+                out << ",\"length\":";
+                quantiles(group.length);
+                out << "}";
+                first = false;
+            }
+            out << "}}";
+        }
+        out << "}\n";
+        return out.str();
+    }
+};
+
+ // Доля статистики одного потока приёма. Выровнена по кэш-линии, чтобы доли соседних
+ // потоков не делили линии. Пишет только владелец, без блокировок; сводные счётчики
+ // под seqlock, поэтому читатель получает их согласованный снимок, не останавливая приём.
+struct alignas(64) StatsShard {
+    std::atomic<uint64_t> sequence{0}; // нечётное — идёт запись
+    std::atomic<uint64_t> totalMessages{0};
+    std::atomic<uint64_t> messagesByLevel[logging::kLogLevelCount] = {};
+    std::atomic<uint64_t> totalLength{0};
+    std::atomic<uint64_t> minLength{UINT64_MAX};
+    std::atomic<uint64_t> maxLength{0};
+    SlidingWindowCounters recent;
+    QuantileSketch lengthByLevel[logging::kLogLevelCount];
+    QuantileSketch gapByLevel[logging::kLogLevelCount];
+    
+    // Клиенты по адресу. Блокировка берётся только при подключении и при чтении;
+    // записи не удаляются, поэтому указатель на них действителен всё время работы
+    static constexpr size_t kMaxClients = 1024;
+    mutable std::mutex clientsMutex;
+    std::unordered_map<std::string, std::unique_ptr<ClientStats>> clients;
+    
+    // Значения тега группировки, так же под блокировкой и без удаления; поток приёма
+    // держит свой кэш указателей, поэтому блокировка берётся только на новом значении
+    static constexpr size_t kMaxGroups = 1024;
+    std::unordered_map<std::string, std::unique_ptr<GroupStats>> groups;
+    
+    explicit StatsShard(size_t longestWindow) : recent(longestWindow) {}
+    
+    ClientStats* client(const std::string& address) {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        // Сверх предела новые адреса учитываются вместе
+        const std::string& key = clients.size() < kMaxClients || clients.count(address) ? address : "прочие";
+        auto& entry = clients[key];
+        if (!entry) {
+            entry = std::make_unique<ClientStats>();
         }
+        return entry.get();
+    }
+    
+    GroupStats* group(const std::string& value) {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        const std::string& key = groups.size() < kMaxGroups || groups.count(value) ? value : "прочие";
+        auto& entry = groups[key];
+        if (!entry) {
+            entry = std::make_unique<GroupStats>();
+        }
+        return entry.get();
+    }
+    
+    // gapMicros < 0 — предыдущего сообщения этого уровня от клиента не было
+    void addMessage(std::string_view message, logging::LogLevel level, int64_t second, int64_t gapMicros) {
+        const uint64_t length = message.length();
+        const uint64_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
         
-        auto now = std::chrono::system_clock::now();
-        auto timeSinceLastOutput = std::chrono::duration_cast<std::chrono::seconds>(
-            now - lastStatsOutput).count();
-            
-        return statsChanged && (timeSinceLastOutput >= timeoutSeconds);
+        bump(totalMessages, 1);
+        bump(messagesByLevel[static_cast<size_t>(level)], 1);
+        bump(totalLength, length);
+        if (length < minLength.load(std::memory_order_relaxed)) {
+            minLength.store(length, std::memory_order_relaxed);
+        }
+        if (length > maxLength.load(std::memory_order_relaxed)) {
+            maxLength.store(length, std::memory_order_relaxed);
+        }
+        
+        sequence.store(seq + 2, std::memory_order_release);
+        recent.add(second, level);
+        lengthByLevel[static_cast<size_t>(level)].add(length);
+        if (gapMicros >= 0) {
+            gapByLevel[static_cast<size_t>(level)].add(static_cast<uint64_t>(gapMicros));
+        }
+    }
+    
+    // Добавление доли к снимку; повторяет чтение, если попало на запись
+    void collect(LogStatistics& snapshot, int64_t now) const {
+        uint64_t total, length, shortest, longest;
+        LevelCounts byLevel;
+        for (;;) {
+            uint64_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            total = totalMessages.load(std::memory_order_relaxed);
+            for (size_t level = 0; level < logging::kLogLevelCount; ++level) {
+                byLevel[level] = messagesByLevel[level].load(std::memory_order_relaxed);
+            }
+            length = totalLength.load(std::memory_order_relaxed);
+            shortest = minLength.load(std::memory_order_relaxed);
+            longest = maxLength.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) {
+                break;
+            }
+        }
+        
+        snapshot.totalMessages += total;
+        for (size_t level = 0; level < logging::kLogLevelCount; ++level) {
+            snapshot.messagesByLevel[level] += byLevel[level];
+        }
+        snapshot.totalLength += length;
+        snapshot.minLength = std::min(snapshot.minLength, shortest);
+        snapshot.maxLength = std::max(snapshot.maxLength, longest);
+        recent.collect(now, snapshot.windows, snapshot.recent);
+        for (size_t level = 0; level < logging::kLogLevelCount; ++level) {
+            lengthByLevel[level].addTo(snapshot.lengthByLevel[level]);
+            gapByLevel[level].addTo(snapshot.gapByLevel[level]);
+        }
+        
+        // Один адрес может быть подключён к нескольким потокам: эскизы складываются
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        for (const auto& [address, stats] : clients) {
+            ClientSummary& summary = snapshot.clients[address];
+            summary.messages += stats->messages.load(std::memory_order_relaxed);
+            stats->length.addTo(summary.length);
+            stats->gapMicros.addTo(summary.gapMicros);
+        }
+        for (const auto& [value, stats] : groups) {
+            GroupSummary& summary = snapshot.groups[value];
+            summary.messages += stats->messages.load(std::memory_order_relaxed);
+            for (size_t level = 0; level < logging::kLogLevelCount; ++level) {
+                summary.messagesByLevel[level] += stats->messagesByLevel[level].load(std::memory_order_relaxed);
+            }
+            stats->length.addTo(summary.length);
+        }
     }
 };
 
- // Парсинг полученного лог-сообщения
-bool parseLogMessage(const std::string& rawMessage, std::string& message, logging::LogLevel& level) {
-    // Ожидаемый формат: [YYYY-MM-DD HH:MM:SS.mmm] [LEVEL] message
+ // Сравнение с эталоном в верхнем регистре без учёта регистра и без копирования
+bool equalsUpper(std::string_view text, std::string_view upper) {
+    for (size_t i = 0; i < upper.size(); ++i) {
+        char c = text[i];
+        if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+        if (c != upper[i]) return false;
+    }
+    return true;
+}
+
+ // Уровень по имени: выбор по длине и первой букве, как stringToLogLevel, но без аллокаций
+logging::LogLevel parseLevel(std::string_view name) {
+    switch (name.size()) {
+        case 4:
+            return logging::LogLevel::INFO; // единственный уровень из 4 букв, иначе тоже INFO
+        case 5:
+            switch (name[0] | 0x20) {
+                case 't': if (equalsUpper(name, "TRACE")) return logging::LogLevel::TRACE; break;
+                case 'd': if (equalsUpper(name, "DEBUG")) return logging::LogLevel::DEBUG; break;
+                case 'e': if (equalsUpper(name, "ERROR")) return logging::LogLevel::ERROR; break;
+                case 'f': if (equalsUpper(name, "FATAL")) return logging::LogLevel::FATAL; break;
+            }
+            break;
+        case 7:
+            if (equalsUpper(name, "WARNING")) return logging::LogLevel::WARNING;
+            break;
+    }
+    return logging::LogLevel::INFO; // По умолчанию
+}
+
+ // Поле контекста "[k=v k2=v2]": непустые пары через пробел, в каждой есть '=' не первым символом
+bool isContextField(std::string_view field) {
+    if (field.empty()) return false;
+    size_t start = 0;
+    while (start <= field.size()) {
+        size_t end = std::min(field.find(' ', start), field.size());
+        size_t equals = field.find('=', start);
+        if (equals == std::string_view::npos || equals == start || equals >= end) return false;
+        start = end + 1;
+    }
+    return true;
+}
+
+ // Значение тега key в поле контекста; false — тега нет
+bool findTag(std::string_view context, std::string_view key, std::string_view& value) {
+    size_t start = 0;
+    while (start < context.size()) {
+        size_t end = std::min(context.find(' ', start), context.size());
+        std::string_view pair = context.substr(start, end - start);
+        if (pair.size() > key.size() && pair[key.size()] == '=' && pair.substr(0, key.size()) == key) {
+            value = pair.substr(key.size() + 1);
+            return true;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+ // Парсинг полученного лог-сообщения; message и context указывают внутрь rawMessage
+bool parseLogMessage(std::string_view rawMessage, std::string_view& message, logging::LogLevel& level,
+                     std::string_view& context) {
+    // Ожидаемый формат: [YYYY-MM-DD HH:MM:SS.mmm] [LEVEL] [k=v ...] message,
+    // поле контекста (имя логгера, tid, теги потока) необязательно
     
     size_t firstBracket = rawMessage.find('[');
-    if (firstBracket == std::string::npos) return false;
+    if (firstBracket == std::string_view::npos) return false;
     
     size_t secondBracket = rawMessage.find(']', firstBracket);
-    if (secondBracket == std::string::npos) return false;
+    if (secondBracket == std::string_view::npos) return false;
     
     size_t thirdBracket = rawMessage.find('[', secondBracket);
-    if (thirdBracket == std::string::npos) return false;
+    if (thirdBracket == std::string_view::npos) return false;
     
     size_t fourthBracket = rawMessage.find(']', thirdBracket);
-    if (fourthBracket == std::string::npos) return false;
+    if (fourthBracket == std::string_view::npos) return false;
     
     // Извлекаем уровень
-    std::string levelStr = rawMessage.substr(thirdBracket + 1, fourthBracket - thirdBracket - 1);
-    level = logging::stringToLogLevel(levelStr);
+    level = parseLevel(rawMessage.substr(thirdBracket + 1, fourthBracket - thirdBracket - 1));
     
-    // Извлекаем сообщение
+    // Извлекаем поле контекста, если оно есть, и сообщение
     size_t messageStart = rawMessage.find_first_not_of(" \t", fourthBracket + 1);
-    if (messageStart == std::string::npos) {
-        message = "";
+    context = std::string_view();
+    if (messageStart != std::string_view::npos && rawMessage[messageStart] == '[') {
+        size_t contextEnd = rawMessage.find(']', messageStart);
+        std::string_view field = contextEnd == std::string_view::npos
+            ? std::string_view() : rawMessage.substr(messageStart + 1, contextEnd - messageStart - 1);
+        if (isContextField(field)) {
+            context = field;
+            messageStart = rawMessage.find_first_not_of(" \t", contextEnd + 1);
+        }
+    }
+    if (messageStart == std::string_view::npos) {
+        message = std::string_view();
     } else {
         message = rawMessage.substr(messageStart);
     }
@@ -130,9 +814,51 @@ bool parseLogMessage(const std::string& rawMessage, std::string& message, loggin
     return true;
 }
 
-// Создание серверного сокета для прослушивания
-int createServerSocket(const std::string& host, int port) {
-    int server_fd = socket(AF_INET, SOCK_STREAM, 0);
+ // Подсчёт по значениям тега группировки для одного потока: свой кэш указателей на
+ // GroupStats доли, блокировка доли берётся только на новом значении. Сообщения без
+ // тега собираются под значением "(нет)". Доля принадлежит одному потоку, поэтому кэш
+ // знает те же значения, что и она, и заполняется ровно тогда, когда доля начинает
+ // сводить новые значения в "прочие": дальше кэш не растёт
+class GroupCounter {
+public:
+    GroupCounter(StatsShard& shard, std::string key) : shard_(shard), key_(std::move(key)) {}
+    
+    void count(std::string_view context, std::string_view message, logging::LogLevel level) {
+        std::string_view value;
+        if (!findTag(context, key_, value)) {
+            value = "(нет)";
+        }
+        value_.assign(value);
+        GroupStats* group = nullptr;
+        auto found = groups_.find(value_);
+        if (found != groups_.end()) {
+            group = found->second;
+        } else if (groups_.size() < StatsShard::kMaxGroups) {
+            group = shard_.group(value_);
+            groups_.emplace(value_, group);
+        } else {
+            if (!overflow_) {
+                overflow_ = shard_.group(value_);
+            }
+            group = overflow_;
+        }
+        bump(group->messages, 1);
+        bump(group->messagesByLevel[static_cast<size_t>(level)], 1);
+        group->length.add(message.length());
+    }
+    
+private:
+    StatsShard& shard_;
+    std::string key_;
+    std::unordered_map<std::string, GroupStats*> groups_;
+    GroupStats* overflow_ = nullptr; // "прочие" доли
+    std::string value_; // ключ поиска без выделений
+};
+
+// Создание неблокирующего серверного сокета для прослушивания.
+// С reusePort несколько потоков слушают один порт, ядро распределяет подключения между ними.
+int createServerSocket(int port, bool reusePort) {
+    int server_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (server_fd < 0) {
         std::cerr << "Ошибка создания сокета" << std::endl;
         return -1;
@@ -140,13 +866,14 @@ int createServerSocket(const std::string& host, int port) {
     
     // Позволяем переиспользовать адрес
     int opt = 1;
-    if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+    if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0 ||
+        (reusePort && setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0)) {
         std::cerr << "Ошибка установки опций сокета" << std::endl;
         close(server_fd);
         return -1;
     }
     
-    struct sockaddr_in address;
+    struct sockaddr_in address{};
     address.sin_family = AF_INET;
     address.sin_addr.s_addr = INADDR_ANY;
     address.sin_port = htons(port);
@@ -157,7 +884,7 @@ int createServerSocket(const std::string& host, int port) {
         return -1;
     }
     
-    if (listen(server_fd, 3) < 0) {
+    if (listen(server_fd, SOMAXCONN) < 0) {
         std::cerr << "Ошибка прослушивания сокета" << std::endl;
         close(server_fd);
         return -1;
@@ -166,33 +893,958 @@ int createServerSocket(const std::string& host, int port) {
     return server_fd;
 }
 
-// Функция для периодической проверки вывода статистики по таймауту
-void timeoutChecker(LogStatistics& stats, int timeoutSeconds, size_t messagesInterval, 
-                   std::atomic<bool>& running) {
-    while (running.load()) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+ // Статистика всех потоков приёма: по доле на поток и поток вывода, который
+ // складывает доли каждые N сообщений или по таймауту T
+class SharedStatistics {
+private:
+    std::vector<std::unique_ptr<StatsShard>> shards_;
+    std::vector<int> windows_;
+    std::string groupKey_;
+    size_t messagesInterval_;
+    int timeoutSeconds_;
+    
+    // Общий счётчик только для правила «каждые N»: обновляется раз на пачку строк
+    std::atomic<uint64_t> ingested_{0};
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool printRequested_ = false;
+    
+public:
+    SharedStatistics(size_t interval, int timeout, std::vector<int> windowSeconds, size_t shardCount,
+                     std::string groupKey)
+        : windows_(std::move(windowSeconds)), groupKey_(std::move(groupKey)), messagesInterval_(interval),
+          timeoutSeconds_(timeout) {
+        size_t longest = static_cast<size_t>(*std::max_element(windows_.begin(), windows_.end()));
+        for (size_t i = 0; i < shardCount; ++i) {
+            shards_.push_back(std::make_unique<StatsShard>(longest));
+        }
+    }
+    
+    StatsShard& shard(size_t index) { return *shards_[index]; }
+    const std::string& groupKey() const { return groupKey_; }
+    
+    // Учёт пачки разобранных сообщений; на каждой N-й границе будит поток вывода
+    void countIngested(uint64_t count) {
+        if (count == 0) {
+            return;
+        }
+        uint64_t before = ingested_.fetch_add(count, std::memory_order_relaxed);
+        if (before / messagesInterval_ != (before + count) / messagesInterval_) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            printRequested_ = true;
+            wake_.notify_one();
+        }
+    }
+    
+    LogStatistics snapshot() const {
+        LogStatistics result;
+        result.windows = windows_;
+        result.recent.resize(windows_.size());
+        result.groupKey = groupKey_;
+        int64_t now = currentSecond();
+        for (const auto& shard : shards_) {
+            shard->collect(result, now);
+        }
+        return result;
+    }
+    
+    // Поток вывода: печатает снимок по запросу или если статистика изменилась за T секунд
+    void runReporter(std::atomic<bool>& running) {
+        uint64_t printedTotal = 0;
+        auto lastOutput = std::chrono::steady_clock::now();
         
-        if (stats.shouldPrintStats(messagesInterval, timeoutSeconds)) {
-            stats.printStatistics();
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (running.load()) {
+            wake_.wait_for(lock, std::chrono::seconds(1), [this] { return printRequested_; });
+            bool requested = printRequested_;
+            printRequested_ = false;
+            lock.unlock();
+            
+            auto now = std::chrono::steady_clock::now();
+            bool timedOut = now - lastOutput >= std::chrono::seconds(timeoutSeconds_);
+            if (requested || timedOut) {
+                LogStatistics stats = snapshot();
+                if (requested || stats.totalMessages != printedTotal) {
+                    stats.printStatistics();
+                    printedTotal = stats.totalMessages;
+                    lastOutput = now;
+                }
+            }
+            
+            lock.lock();
         }
     }
+};
+
+ // Подключённый клиент: сокет и линейный буфер приёма.
+ // [begin, end) — ещё не разобранные данные, перед scanned перевода строки нет.
+struct Connection {
+    int fd;
+    ClientStats* client = nullptr;
+    int64_t lastArrival = -1;      // мкс, для интервалов между сообщениями
+    int64_t lastArrivalByLevel[logging::kLogLevelCount] = {-1, -1, -1, -1, -1, -1};
+    std::vector<char> buffer;
+    size_t begin = 0;
+    size_t end = 0;
+    size_t scanned = 0;
+    bool skippingLine = false; // хвост слишком длинной строки отбрасывается до '\n'
+    bool firstLine = true;     // первая строка может быть приветствием кадрового протокола
+    // Кадровый режим: байты из сокета идут в decoder, текст кадров — в buffer;
+    // handoff — байты, пришедшие вслед за приветствием в одном чтении
+    std::unique_ptr<logging::framed::FrameDecoder> decoder;
+    std::string handoff;
+};
+
+ // Поток приёма: свой epoll и свой слушающий сокет, тысячи клиентов без блокировок
+class Reactor {
+private:
+    int epoll_fd_ = -1;
+    int listen_fd_ = -1;
+    SharedStatistics& shared_;
+    StatsShard& shard_;
+    std::atomic<bool>& running_;
+    bool echo_enabled_;
+    std::string echo_; // эхо строк копится за чтение и выводится одной записью
+    std::unordered_map<int, std::unique_ptr<Connection>> connections_;
+    GroupCounter groups_;
+    // Кадровый режим: чтение из сокета и распакованный текст, общие для всех клиентов потока
+    std::vector<char> wire_;
+    std::string decoded_;
+    
+    static constexpr int kMaxEvents = 256;
+    static constexpr size_t kInitialBufferSize = 64 * 1024;
+    static constexpr size_t kMaxLineSize = 1024 * 1024;
+    static constexpr int kWaitTimeoutMs = 200;
+    
+    void acceptClients() {
+        for (;;) {
+            struct sockaddr_in peer{};
+            socklen_t peerLength = sizeof(peer);
+            int client = accept4(listen_fd_, reinterpret_cast<struct sockaddr*>(&peer), &peerLength,
+                                 SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (client < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) {
+                    continue;
+                }
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    std::cerr << "Ошибка принятия соединения: " << std::strerror(errno) << std::endl;
+                }
+                return;
+            }
+            
+            auto connection = std::make_unique<Connection>();
+            connection->fd = client;
+            connection->buffer.resize(kInitialBufferSize);
+            char address[INET_ADDRSTRLEN] = "?";
+            inet_ntop(AF_INET, &peer.sin_addr, address, sizeof(address));
+            connection->client = shard_.client(address);
+            struct epoll_event event{};
+            event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+            event.data.ptr = connection.get();
+            if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client, &event) < 0) {
+                close(client);
+                continue;
+            }
+            connections_[client] = std::move(connection);
+        }
+    }
+    
+    // Чтение до EAGAIN (edge-triggered) прямо в буфер клиента (в кадровом режиме — через
+    // распаковку); false — клиент отключился или прислал повреждённый кадр
+    bool readClient(Connection& connection) {
+        uint64_t messages = 0;
+        bool alive = true;
+        for (;;) {
+            ssize_t bytesRead;
+            if (connection.decoder) {
+                bytesRead = recv(connection.fd, wire_.data(), wire_.size(), 0);
+            } else {
+                reserveSpace(connection);
+                bytesRead = recv(connection.fd, connection.buffer.data() + connection.end,
+                                 connection.buffer.size() - connection.end, 0);
+            }
+            if (bytesRead > 0) {
+                bool ok = true;
+                if (connection.decoder) {
+                    ok = feedFrames(connection, wire_.data(), static_cast<size_t>(bytesRead), currentMicros(),
+                                    messages);
+                } else {
+                    connection.end += static_cast<size_t>(bytesRead);
+                    messages += consumeLines(connection, currentMicros());
+                    if (connection.decoder && !connection.handoff.empty()) {
+                        std::string rest;
+                        rest.swap(connection.handoff);
+                        ok = feedFrames(connection, rest.data(), rest.size(), currentMicros(), messages);
+                    }
+                }
+                flushEcho();
+                if (!ok) {
+                    std::cerr << "Повреждённый кадр от клиента, соединение закрыто" << std::endl;
+                    alive = false;
+                    break;
+                }
+                continue;
+            }
+            if (bytesRead < 0 && errno == EINTR) {
+                continue;
+            }
+            if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            if (bytesRead < 0) {
+                std::cerr << "Ошибка чтения из сокета" << std::endl;
+            }
+            alive = false;
+            break;
+        }
+        shared_.countIngested(messages);
+        return alive;
+    }
+    
+    // Обработка одной полученной строки; возвращает true, если это сообщение журнала
+    bool handleLine(Connection& connection, std::string_view line, int64_t arrival) {
+        if (echo_enabled_) {
+            echo_.append("Получено: ").append(line).push_back('\n');
+        }
+        
+        // Парсинг и обработка сообщения
+        std::string_view message;
+        std::string_view context;
+        logging::LogLevel level;
+        if (!parseLogMessage(line, message, level, context)) {
+            std::cerr << "Не удалось распарсить сообщение: " << line << std::endl;
+            return false;
+        }
+        if (!shared_.groupKey().empty()) {
+            groups_.count(context, message, level);
+        }
+        
+        // Время прихода одно на чтение: записи одного чтения (или кадра) приходят вместе,
+        // и интервал считается между чтениями, а не между записями внутри чтения
+        auto& lastOfLevel = connection.lastArrivalByLevel[static_cast<size_t>(level)];
+        shard_.addMessage(message, level, arrival / 1000000,
+                          lastOfLevel >= 0 && lastOfLevel != arrival ? arrival - lastOfLevel : -1);
+        lastOfLevel = arrival;
+        
+        ClientStats& client = *connection.client;
+        bump(client.messages, 1);
+        client.length.add(message.length());
+        if (connection.lastArrival >= 0 && connection.lastArrival != arrival) {
+            client.gapMicros.add(static_cast<uint64_t>(arrival - connection.lastArrival));
+        }
+        connection.lastArrival = arrival;
+        return true;
+    }
+    
+    // Приветствие кадрового протокола: ответ с выбранным кодеком, дальше байты клиента —
+    // кадры. Что пришло после приветствия в том же чтении, разбирается как кадры
+    bool startFrames(Connection& connection, std::string_view hello) {
+        logging::framed::Codec codec;
+        if (!logging::framed::chooseCodec(hello, codec)) {
+            return false;
+        }
+        const std::string reply = logging::framed::replyLine(codec);
+        if (send(connection.fd, reply.data(), reply.size(), MSG_NOSIGNAL | MSG_DONTWAIT) !=
+            static_cast<ssize_t>(reply.size())) {
+            return false; // клиент не получит ответ и будет писать текстом
+        }
+        connection.decoder = std::make_unique<logging::framed::FrameDecoder>();
+        connection.handoff.assign(connection.buffer.data() + connection.begin, connection.end - connection.begin);
+        connection.begin = connection.end = connection.scanned = 0;
+        return true;
+    }
+    
+    // Распаковка кадров и разбор их строк тем же consumeLines; false — поток повреждён
+    bool feedFrames(Connection& connection, const char* data, size_t size, int64_t arrival, uint64_t& messages) {
+        decoded_.clear();
+        if (!connection.decoder->feed(data, size, decoded_)) {
+            return false;
+        }
+        const char* text = decoded_.data();
+        size_t left = decoded_.size();
+        while (left > 0) {
+            reserveSpace(connection);
+            size_t chunk = std::min(left, connection.buffer.size() - connection.end);
+            std::memcpy(connection.buffer.data() + connection.end, text, chunk);
+            connection.end += chunk;
+            text += chunk;
+            left -= chunk;
+            messages += consumeLines(connection, arrival);
+        }
+        return true;
+    }
+    
+    void flushEcho() {
+        if (!echo_.empty()) {
+            std::cout.write(echo_.data(), static_cast<std::streamsize>(echo_.size()));
+            std::cout.flush();
+            echo_.clear();
+        }
+    }
+    
+    // Место в конце буфера: сдвиг незаконченной строки в начало или рост до kMaxLineSize
+    void reserveSpace(Connection& connection) {
+        if (connection.end < connection.buffer.size()) {
+            return;
+        }
+        if (connection.begin > 0) {
+            size_t pending = connection.end - connection.begin;
+            std::memmove(connection.buffer.data(), connection.buffer.data() + connection.begin, pending);
+            connection.scanned -= connection.begin;
+            connection.begin = 0;
+            connection.end = pending;
+        } else if (connection.buffer.size() < kMaxLineSize) {
+            connection.buffer.resize(std::min(connection.buffer.size() * 2, kMaxLineSize));
+        } else {
+            if (!connection.skippingLine) {
+                std::cerr << "Строка длиннее " << kMaxLineSize << " байт отброшена" << std::endl;
+            }
+            connection.begin = connection.end = connection.scanned = 0;
+            connection.skippingLine = true;
+        }
+    }
+    
+    // Разбор всех законченных строк без копирования: memchr и string_view на буфер.
+    // Возвращает число учтённых сообщений.
+    uint64_t consumeLines(Connection& connection, int64_t arrival) {
+        uint64_t messages = 0;
+        const char* data = connection.buffer.data();
+        while (connection.scanned < connection.end) {
+            const char* newline = static_cast<const char*>(
+                std::memchr(data + connection.scanned, '\n', connection.end - connection.scanned));
+            if (!newline) {
+                connection.scanned = connection.end;
+                break;
+            }
+            
+            size_t lineEnd = static_cast<size_t>(newline - data);
+            std::string_view line(data + connection.begin, lineEnd - connection.begin);
+            connection.begin = connection.scanned = lineEnd + 1;
+            
+            if (connection.skippingLine) {
+                connection.skippingLine = false;
+                continue;
+            }
+            
+            // Удаляем символ возврата каретки если есть
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (line.empty()) continue;
+            
+            if (connection.firstLine) {
+                connection.firstLine = false;
+                if (!connection.decoder && line.substr(0, logging::framed::kHelloPrefix.size()) ==
+                                               logging::framed::kHelloPrefix && startFrames(connection, line)) {
+                    return messages; // остаток буфера — уже кадры, их разберёт readClient
+                }
+            }
+            
+            messages += handleLine(connection, line, arrival) ? 1 : 0;
+        }
+        
+        if (connection.begin == connection.end) {
+            connection.begin = connection.end = connection.scanned = 0;
+        }
+        return messages;
+    }
+    
+    void closeClient(Connection& connection) {
+        int fd = connection.fd;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        connections_.erase(fd);
+    }
+    
+public:
+    Reactor(int listenFd, SharedStatistics& shared, StatsShard& shard, bool echo, std::atomic<bool>& running)
+        : listen_fd_(listenFd), shared_(shared), shard_(shard), running_(running), echo_enabled_(echo),
+          groups_(shard, shared.groupKey()), wire_(kInitialBufferSize) {}
+    
+    ~Reactor() {
+        for (auto& [fd, connection] : connections_) {
+            close(fd);
+        }
+        if (epoll_fd_ >= 0) close(epoll_fd_);
+        if (listen_fd_ >= 0) close(listen_fd_);
+    }
+    
+    bool init() {
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0) {
+            return false;
+        }
+        struct epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr; // nullptr — слушающий сокет
+        return epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event) == 0;
+    }
+    
+    void run() {
+        struct epoll_event events[kMaxEvents];
+        while (running_.load()) {
+            int ready = epoll_wait(epoll_fd_, events, kMaxEvents, kWaitTimeoutMs);
+            if (ready < 0) {
+                if (errno == EINTR) continue;
+                std::cerr << "Ошибка epoll_wait: " << std::strerror(errno) << std::endl;
+                break;
+            }
+            for (int i = 0; i < ready; ++i) {
+                if (events[i].data.ptr == nullptr) {
+                    acceptClients();
+                    continue;
+                }
+                auto* connection = static_cast<Connection*>(events[i].data.ptr);
+                bool alive = (events[i].events & EPOLLIN) ? readClient(*connection) : true;
+                if (!alive || (events[i].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+                    closeClient(*connection);
+                }
+            }
+        }
+    }
+};
+
+ // HTTP-точка для сбора статистики: GET /metrics (Prometheus) и GET /stats (JSON).
+ // Один поток, соединение на запрос; снимок собирается из долей, приём не останавливается.
+class StatsEndpoint {
+private:
+    int listen_fd_;
+    const SharedStatistics& shared_;
+    std::atomic<bool>& running_;
+    
+    static constexpr size_t kMaxRequestSize = 8 * 1024;
+    static constexpr int kPollTimeoutMs = 200;
+    
+    static void sendAll(int fd, const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t result = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (result < 0 && errno == EINTR) continue;
+            if (result <= 0) return;
+            sent += static_cast<size_t>(result);
+        }
+    }
+    
+    static void respond(int fd, const char* status, const char* contentType, const std::string& body) {
+        std::string response = std::string("HTTP/1.1 ") + status + "\r\n" +
+            "Content-Type: " + contentType + "\r\n" +
+            "Content-Length: " + std::to_string(body.size()) + "\r\n" +
+            "Connection: close\r\n\r\n" + body;
+        sendAll(fd, response);
+    }
+    
+    void handleClient(int fd) {
+        // Медленный клиент не задерживает точку дольше секунды
+        struct timeval timeout{1, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        
+        std::string request;
+        char buffer[1024];
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < kMaxRequestSize) {
+            ssize_t bytesRead = recv(fd, buffer, sizeof(buffer), 0);
+            if (bytesRead < 0 && errno == EINTR) continue;
+            if (bytesRead <= 0) break;
+            request.append(buffer, static_cast<size_t>(bytesRead));
+        }
+        
+        // Строка запроса: МЕТОД ПУТЬ ВЕРСИЯ
+        std::string_view line(request);
+        line = line.substr(0, line.find("\r\n"));
+        size_t methodEnd = line.find(' ');
+        size_t pathEnd = methodEnd == std::string_view::npos ? methodEnd : line.find(' ', methodEnd + 1);
+        if (pathEnd == std::string_view::npos) {
+            respond(fd, "400 Bad Request", "text/plain; charset=utf-8", "bad request\n");
+            return;
+        }
+        std::string_view method = line.substr(0, methodEnd);
+        std::string_view path = line.substr(methodEnd + 1, pathEnd - methodEnd - 1);
+        path = path.substr(0, path.find('?'));
+        
+        if (method != "GET") {
+            respond(fd, "405 Method Not Allowed", "text/plain; charset=utf-8", "only GET is supported\n");
+        } else if (path == "/metrics") {
+            respond(fd, "200 OK", "text/plain; version=0.0.4; charset=utf-8", shared_.snapshot().renderPrometheus());
+        } else if (path == "/stats" || path == "/stats.json") {
+            respond(fd, "200 OK", "application/json; charset=utf-8", shared_.snapshot().renderJson());
+        } else {
+            respond(fd, "404 Not Found", "text/plain; charset=utf-8", "try /metrics or /stats\n");
+        }
+    }
+    
+public:
+    StatsEndpoint(int listenFd, const SharedStatistics& shared, std::atomic<bool>& running)
+        : listen_fd_(listenFd), shared_(shared), running_(running) {}
+    
+    ~StatsEndpoint() {
+        close(listen_fd_);
+    }
+    
+    void run() {
+        while (running_.load()) {
+            struct pollfd waiting{listen_fd_, POLLIN, 0};
+            if (poll(&waiting, 1, kPollTimeoutMs) <= 0) {
+                continue;
+            }
+            int client = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client < 0) {
+                continue;
+            }
+            handleClient(client);
+            close(client);
+        }
+    }
+};
+
+ // Разбор готовых журналов (--files): та же статистика, что у сервера, по файлам на диске.
+ // Обычные файлы отображаются в память и режутся на куски по границам строк, куски
+ // разбирает пул потоков. Сегменты .gz от LogRotator распаковываются последовательно,
+ // как и двоичные журналы: один файл — одна задача. У каждого потока своя доля
+ // StatsShard, в конце доли складываются так же, как в SharedStatistics::snapshot().
+class FileAnalyzer {
+private:
+    static constexpr size_t kChunkSize = 64 * 1024 * 1024;
+    static constexpr size_t kReadSize = 4 * 1024 * 1024;
+    static constexpr size_t kMaxLineSize = 1024 * 1024;
+    
+    // Файл журнала. data — отображение обычного файла; nullptr — файл читается через
+    // LogSegmentReader. Последний закончивший кусок поток снимает отображение
+    struct Source {
+        std::string path;
+        const char* data = nullptr;
+        size_t size = 0;
+        bool binary = false;
+        std::atomic<size_t> remaining{0};
+        std::string error;                  // пишет единственный поток последовательной задачи
+    };
+    
+    // Кусок [begin, end) в номинальных смещениях: поток сам сдвигает обе границы на
+    // начало следующей строки, поэтому каждая строка достаётся ровно одному куску
+    struct Task {
+        Source* source;
+        size_t begin;
+        size_t end;
+    };
+    
+    struct Worker {
+        StatsShard shard{1};
+        GroupCounter groups;
+        uint64_t unparsed = 0;
+        uint64_t bytes = 0;
+        std::vector<char> buffer;
+        logging::BinaryLogDecoder::Record record;
+        
+        explicit Worker(const std::string& groupKey) : groups(shard, groupKey) {}
+    };
+    
+    std::string groupKey_;
+    size_t threadCount_;
+    std::vector<std::unique_ptr<Source>> sources_;
+    std::vector<Task> tasks_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t> next_{0};
+    double seconds_ = 0;
+    
+    static bool isBinary(const char* data, size_t size) {
+        return size >= logging::binary::kFrameHeaderSize + 6 &&
+               static_cast<uint8_t>(data[0]) == logging::binary::kStreamTag &&
+               std::memcmp(data + logging::binary::kFrameHeaderSize, logging::binary::kStreamMagic, 6) == 0;
+    }
+    
+    // Начало первой строки, которая начинается не раньше offset
+    static size_t lineStart(const Source& source, size_t offset) {
+        if (offset == 0 || offset >= source.size) {
+            return std::min(offset, source.size);
+        }
+        const void* newline = std::memchr(source.data + offset - 1, '\n', source.size - offset + 1);
+        return newline ? static_cast<size_t>(static_cast<const char*>(newline) - source.data) + 1 : source.size;
+    }
+    
+    void countMessage(Worker& worker, std::string_view context, std::string_view message, logging::LogLevel level) {
+        // Время прихода офлайн не определено: окна и интервалы не считаются
+        worker.shard.addMessage(message, level, 0, -1);
+        if (!groupKey_.empty()) {
+            worker.groups.count(context, message, level);
+        }
+    }
+    
+    // Разбор целых строк текста тем же парсером, что и у сервера
+    void consumeText(Worker& worker, const char* data, size_t size) {
+        const char* end = data + size;
+        while (data < end) {
+            const char* newline = static_cast<const char*>(std::memchr(data, '\n', static_cast<size_t>(end - data)));
+            std::string_view line(data, static_cast<size_t>((newline ? newline : end) - data));
+            data = newline ? newline + 1 : end;
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (line.empty()) {
+                continue;
+            }
+            std::string_view message;
+            std::string_view context;
+            logging::LogLevel level;
+            if (parseLogMessage(line, message, level, context)) {
+                countMessage(worker, context, message, level);
+            } else {
+                ++worker.unparsed;
+            }
+        }
+    }
+    
+    // false — двоичный поток повреждён
+    bool consumeBinary(Worker& worker, logging::BinaryLogDecoder& decoder, std::string_view data) {
+        decoder.append(data);
+        for (;;) {
+            auto status = decoder.next(worker.record);
+            if (status == logging::BinaryLogDecoder::Status::NEED_MORE) {
+                return true;
+            }
+            if (status == logging::BinaryLogDecoder::Status::CORRUPT) {
+                return false;
+            }
+            countMessage(worker, std::string_view(), worker.record.message, worker.record.level);
+        }
+    }
+    
+    void processChunk(Worker& worker, const Task& task) {
+        Source& source = *task.source;
+        size_t begin = lineStart(source, task.begin);
+        size_t end = lineStart(source, task.end);
+        if (begin < end) {
+            consumeText(worker, source.data + begin, end - begin);
+            worker.bytes += end - begin;
+        }
+    }
+    
+    // Двоичный журнал из отображения: декодер читает его кусками по kReadSize
+    void processMappedBinary(Worker& worker, Source& source) {
+        logging::BinaryLogDecoder decoder;
+        for (size_t offset = 0; offset < source.size; offset += kReadSize) {
+            size_t length = std::min(kReadSize, source.size - offset);
+            if (!consumeBinary(worker, decoder, std::string_view(source.data + offset, length))) {
+                source.error = "повреждённые двоичные данные";
+                return;
+            }
+            worker.bytes += length;
+        }
+        if (decoder.hasPendingData()) {
+            source.error = "журнал обрывается на середине записи";
+        }
+    }
+    
+    // Сжатый сегмент: распаковка блоками, целые строки разбираются сразу, хвост
+    // незаконченной строки переносится в начало буфера
+    void processCompressed(Worker& worker, Source& source) {
+        logging::LogSegmentReader reader;
+        if (!reader.open(source.path)) {
+            source.error = logging::framed::compressionAvailable()
+                ? "не удалось открыть" : "сжатый журнал, а библиотека собрана без zlib";
+            return;
+        }
+        std::vector<char>& buffer = worker.buffer;
+        std::unique_ptr<logging::BinaryLogDecoder> decoder;
+        size_t carried = 0;
+        bool first = true;
+        bool skipping = false; // строка длиннее kMaxLineSize пропускается до '\n'
+        for (;;) {
+            if (buffer.size() < carried + kReadSize) {
+                buffer.resize(carried + kReadSize);
+            }
+            int64_t count = reader.read(buffer.data() + carried, kReadSize);
+            if (count < 0) {
+                source.error = "повреждённые сжатые данные";
+                return;
+            }
+            worker.bytes += static_cast<uint64_t>(count);
+            if (first) {
+                first = false;
+                if (isBinary(buffer.data(), static_cast<size_t>(count))) {
+                    decoder = std::make_unique<logging::BinaryLogDecoder>();
+                }
+            }
+            if (decoder) {
+                if (!consumeBinary(worker, *decoder, std::string_view(buffer.data(), static_cast<size_t>(count)))) {
+                    source.error = "повреждённые двоичные данные";
+                    return;
+                }
+                if (count == 0) {
+                    break;
+                }
+                continue;
+            }
+            
+            const char* data = buffer.data();
+            size_t filled = carried + static_cast<size_t>(count);
+            size_t start = 0;
+            if (skipping) {
+                const void* newline = std::memchr(data, '\n', filled);
+                if (!newline) {
+                    carried = 0;
+                    if (count == 0) break;
+                    continue;
+                }
+                start = static_cast<size_t>(static_cast<const char*>(newline) - data) + 1;
+                skipping = false;
+            }
+            if (count == 0) {
+                consumeText(worker, data + start, filled - start);
+                break;
+            }
+            const void* last = memrchr(data + start, '\n', filled - start);
+            size_t complete = last ? static_cast<size_t>(static_cast<const char*>(last) - data) + 1 : start;
+            consumeText(worker, data + start, complete - start);
+            carried = filled - complete;
+            if (carried > kMaxLineSize) {
+                ++worker.unparsed;
+                carried = 0;
+                skipping = true;
+            }
+            std::memmove(buffer.data(), data + complete, carried);
+        }
+        if (decoder && decoder->hasPendingData()) {
+            source.error = "журнал обрывается на середине записи";
+        }
+    }
+    
+    void process(Worker& worker, const Task& task) {
+        Source& source = *task.source;
+        if (!source.data) {
+            processCompressed(worker, source);
+            return;
+        }
+        if (source.binary) {
+            processMappedBinary(worker, source);
+        } else {
+            processChunk(worker, task);
+        }
+        if (source.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            munmap(const_cast<char*>(source.data), source.size);
+        }
+    }
+    
+    void runWorker(Worker& worker) {
+        for (size_t index = next_.fetch_add(1, std::memory_order_relaxed); index < tasks_.size();
+             index = next_.fetch_add(1, std::memory_order_relaxed)) {
+            process(worker, tasks_[index]);
+        }
+    }
+    
+public:
+    FileAnalyzer(size_t threadCount, std::string groupKey)
+        : groupKey_(std::move(groupKey)), threadCount_(std::max<size_t>(threadCount, 1)) {}
+    
+    ~FileAnalyzer() {
+        // Отображения, до которых run() не дошёл
+        for (const auto& source : sources_) {
+            if (source->data && source->remaining.load() > 0) {
+                munmap(const_cast<char*>(source->data), source->size);
+            }
+        }
+    }
+    
+    // Обычный файл отображается и режется на куски, сжатый ставится одной задачей;
+    // false — файл не открыть
+    bool addFile(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat info{};
+        if (fd < 0 || fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+            std::cerr << "Ошибка: не удалось открыть " << path << std::endl;
+            if (fd >= 0) close(fd);
+            return false;
+        }
+        auto source = std::make_unique<Source>();
+        source->path = path;
+        source->size = static_cast<size_t>(info.st_size);
+        
+        unsigned char magic[2] = {0, 0};
+        bool compressed = pread(fd, magic, sizeof(magic), 0) == 2 && magic[0] == 0x1f && magic[1] == 0x8b;
+        if (compressed) {
+            close(fd);
+            tasks_.push_back(Task{source.get(), 0, source->size});
+            sources_.push_back(std::move(source));
+            return true;
+        }
+        if (source->size == 0) {
+            close(fd);
+            sources_.push_back(std::move(source));
+            return true;
+        }
+        
+        void* mapping = mmap(nullptr, source->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            std::cerr << "Ошибка: не удалось отобразить " << path << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        madvise(mapping, source->size, MADV_SEQUENTIAL);
+        source->data = static_cast<const char*>(mapping);
+        source->binary = isBinary(source->data, source->size);
+        
+        // Двоичный журнал не режется: записи не выровнены по строкам
+        size_t chunks = source->binary ? 1 : (source->size + kChunkSize - 1) / kChunkSize;
+        source->remaining.store(chunks);
+        for (size_t i = 0; i < chunks; ++i) {
+            tasks_.push_back(Task{source.get(), i * kChunkSize, std::min(source->size, (i + 1) * kChunkSize)});
+        }
+        sources_.push_back(std::move(source));
+        return true;
+    }
+    
+    LogStatistics run() {
+        // Последовательные задачи самые долгие — они раздаются первыми
+        std::stable_partition(tasks_.begin(), tasks_.end(), [](const Task& task) {
+            return !task.source->data || task.source->binary;
+        });
+        
+        auto started = std::chrono::steady_clock::now();
+        size_t threads = std::min(threadCount_, std::max<size_t>(tasks_.size(), 1));
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.push_back(std::make_unique<Worker>(groupKey_));
+        }
+        std::vector<std::thread> pool;
+        for (auto& worker : workers_) {
+            pool.emplace_back(&FileAnalyzer::runWorker, this, std::ref(*worker));
+        }
+        for (auto& thread : pool) {
+            thread.join();
+        }
+        seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        
+        LogStatistics result;
+        result.groupKey = groupKey_;
+        for (const auto& worker : workers_) {
+            worker->shard.collect(result, 0);
+        }
+        return result;
+    }
+    
+    // Ошибки файлов и сводка разбора; false — хотя бы один файл прочитан не полностью
+    bool printSummary(std::ostream& out) const {
+        bool ok = true;
+        for (const auto& source : sources_) {
+            if (!source->error.empty()) {
+                std::cerr << "Ошибка: " << source->path << ": " << source->error << std::endl;
+                ok = false;
+            }
+        }
+        uint64_t bytes = 0;
+        uint64_t unparsed = 0;
+        for (const auto& worker : workers_) {
+            bytes += worker->bytes;
+            unparsed += worker->unparsed;
+        }
+        double mebibytes = static_cast<double>(bytes) / (1024.0 * 1024.0);
+        out << "Файлов: " << sources_.size() << ", потоков: " << workers_.size() << ", прочитано "
+            << std::fixed << std::setprecision(1) << mebibytes << " МиБ за " << std::setprecision(2) << seconds_
+            << " с (" << std::setprecision(1) << (seconds_ > 0 ? mebibytes / seconds_ : 0.0) << " МиБ/с)"
+            << ", не разобрано строк: " << unparsed << std::endl;
+        return ok;
+    }
+};
+
+std::atomic<bool> serverRunning{true};
+
+void handleStopSignal(int) {
+    serverRunning.store(false);
+}
+
+// Лимит открытых файлов поднимается до максимума: каждый клиент — дескриптор
+void raiseFileLimit() {
+    struct rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
 }
 
 // Отображение справки по использованию
 void showUsage(const std::string& programName) {
-    std::cout << "Использование: " << programName << " <порт> <N> <T>\n\n";
+    std::cout << "Использование: " << programName << " <порт> <N> <T> [параметры]\n\n";
     std::cout << "Параметры:\n";
     std::cout << "  порт  - порт для прослушивания подключений\n";
     std::cout << "  N     - выводить статистику после каждого N-го сообщения\n";
-    std::cout << "  T     - таймаут в секундах для вывода статистики\n\n";
+    std::cout << "  T     - таймаут в секундах для вывода статистики\n";
+    std::cout << "  --threads K - число потоков приёма (по умолчанию: 1)\n";
+    std::cout << "  --windows С,С,... - скользящие окна в секундах (по умолчанию: 60,300,3600)\n";
+    std::cout << "  --no-echo   - не выводить каждую полученную строку\n";
+    std::cout << "  --quiet     - не выводить ни строки, ни статистику (только HTTP)\n";
+    std::cout << "  --http-port P - статистика по HTTP: /metrics (Prometheus) и /stats (JSON)\n";
+    std::cout << "  --group-by КЛЮЧ - статистика по значениям тега КЛЮЧ из поля контекста записи\n";
+    std::cout << "                    ([logger=... tid=... КЛЮЧ=значение]; logger и tid тоже ключи)\n\n";
+    std::cout << "Разбор готовых журналов: " << programName << " --files [параметры] файл...\n";
+    std::cout << "  файлы .gz (сегменты ротации) распаковываются, двоичные журналы декодируются\n";
+    std::cout << "  --threads K - число потоков разбора (по умолчанию: число ядер)\n";
+    std::cout << "  --group-by КЛЮЧ - как у сервера\n";
+    std::cout << "  --json | --prometheus - вывести снимок в этом формате вместо текста\n\n";
     std::cout << "Пример: " << programName << " 12345 10 30\n";
     std::cout << "  - слушает порт 12345\n";
     std::cout << "  - выводит статистику каждые 10 сообщений\n";
     std::cout << "  - выводит статистику каждые 30 секунд, если она изменилась\n";
 }
 
+// Режим --files: статистика по файлам журнала вместо приёма по сети
+int runFileMode(int argc, char* argv[]) {
+    size_t threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    std::string groupKey;
+    std::string format = "text";
+    std::vector<std::string> files;
+    
+    for (int i = 2; i < argc; ++i) {
+        std::string option = argv[i];
+        if (option == "--threads" && i + 1 < argc) {
+            int value = std::atoi(argv[++i]);
+            if (value <= 0) {
+                std::cerr << "Ошибка: число потоков должно быть больше 0" << std::endl;
+                return 1;
+            }
+            threadCount = static_cast<size_t>(value);
+        } else if (option == "--group-by" && i + 1 < argc) {
+            groupKey = argv[++i];
+            if (groupKey.empty()) {
+                std::cerr << "Ошибка: пустой ключ группировки" << std::endl;
+                return 1;
+            }
+        } else if (option == "--json" || option == "--prometheus") {
+            format = option.substr(2);
+        } else if (!option.empty() && option[0] == '-') {
+            showUsage(argv[0]);
+            return 1;
+        } else {
+            files.push_back(option);
+        }
+    }
+    if (files.empty()) {
+        showUsage(argv[0]);
+        return 1;
+    }
+    
+    FileAnalyzer analyzer(threadCount, groupKey);
+    bool ok = true;
+    for (const auto& file : files) {
+        ok = analyzer.addFile(file) && ok;
+    }
+    LogStatistics stats = analyzer.run();
+    
+    // Снимок в JSON или Prometheus идёт в stdout без примесей, сводка — в stderr
+    if (format == "text") {
+        ok = analyzer.printSummary(std::cout) && ok;
+        stats.printStatistics();
+    } else {
+        ok = analyzer.printSummary(std::cerr) && ok;
+        std::string text = format == "json" ? stats.renderJson() : stats.renderPrometheus();
+        std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+    std::cout.flush();
+    return ok ? 0 : 1;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 4) {
+    if (argc >= 2 && std::string(argv[1]) == "--files") {
+        return runFileMode(argc, argv);
+    }
+    
+    if (argc < 4) {
         showUsage(argv[0]);
         return 1;
     }
@@ -200,6 +1852,46 @@ int main(int argc, char* argv[]) {
     int port = std::atoi(argv[1]);
     size_t messagesInterval = std::atoi(argv[2]);
     int timeoutSeconds = std::atoi(argv[3]);
+    int threadCount = 1;
+    std::vector<int> windowSeconds = {60, 300, 3600};
+    bool echo = true;
+    bool report = true;
+    int httpPort = 0;
+    std::string groupKey;
+    
+    for (int i = 4; i < argc; ++i) {
+        std::string option = argv[i];
+        if (option == "--threads" && i + 1 < argc) {
+            threadCount = std::atoi(argv[++i]);
+        } else if (option == "--windows" && i + 1 < argc) {
+            windowSeconds.clear();
+            std::istringstream list(argv[++i]);
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                windowSeconds.push_back(std::atoi(item.c_str()));
+            }
+        } else if (option == "--group-by" && i + 1 < argc) {
+            groupKey = argv[++i];
+            if (groupKey.empty()) {
+                std::cerr << "Ошибка: пустой ключ группировки" << std::endl;
+                return 1;
+            }
+        } else if (option == "--no-echo") {
+            echo = false;
+        } else if (option == "--quiet") {
+            echo = false;
+            report = false;
+        } else if (option == "--http-port" && i + 1 < argc) {
+            httpPort = std::atoi(argv[++i]);
+            if (httpPort <= 0 || httpPort > 65535) {
+                std::cerr << "Ошибка: неверный порт HTTP " << httpPort << std::endl;
+                return 1;
+            }
+        } else {
+            showUsage(argv[0]);
+            return 1;
+        }
+    }
     
     if (port <= 0 || port > 65535) {
         std::cerr << "Ошибка: неверный порт " << port << std::endl;
@@ -216,102 +1908,86 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    if (threadCount <= 0) {
+        std::cerr << "Ошибка: число потоков должно быть больше 0" << std::endl;
+        return 1;
+    }
+    
+    // Сутки — предел окна: кольцо корзин занимает около 60 байт на секунду
+    if (windowSeconds.empty() || std::any_of(windowSeconds.begin(), windowSeconds.end(),
+                                             [](int seconds) { return seconds <= 0 || seconds > 86400; })) {
+        std::cerr << "Ошибка: окна должны быть от 1 до 86400 секунд" << std::endl;
+        return 1;
+    }
+    
     std::cout << "Запуск сервера статистики логов..." << std::endl;
     std::cout << "Порт: " << port << std::endl;
     std::cout << "Интервал сообщений: " << messagesInterval << std::endl;
     std::cout << "Таймаут: " << timeoutSeconds << " секунд" << std::endl;
-    
-    // Создание серверного сокета
-    int server_fd = createServerSocket("0.0.0.0", port);
-    if (server_fd < 0) {
-        return 1;
+    std::cout << "Потоков приёма: " << threadCount << std::endl;
+    if (httpPort > 0) {
+        std::cout << "HTTP-статистика: порт " << httpPort << " (/metrics, /stats)" << std::endl;
+    }
+    if (!groupKey.empty()) {
+        std::cout << "Группировка по тегу: " << groupKey << std::endl;
     }
     
-    std::cout << "Сервер запущен и ожидает подключений на порту " << port << "..." << std::endl;
-    
-    LogStatistics stats;
-    std::atomic<bool> running{true};
+    raiseFileLimit();
+    std::signal(SIGINT, handleStopSignal);
+    std::signal(SIGTERM, handleStopSignal);
+    std::signal(SIGPIPE, SIG_IGN);
     
-    // Запуск потока для проверки таймаута
-    std::thread timeoutThread(timeoutChecker, std::ref(stats), timeoutSeconds, 
-                             messagesInterval, std::ref(running));
+    SharedStatistics shared(messagesInterval, timeoutSeconds, windowSeconds, static_cast<size_t>(threadCount),
+                            groupKey);
     
-    while (true) {
-        struct sockaddr_in address;
-        int addrlen = sizeof(address);
-        
-        int client_socket = accept(server_fd, (struct sockaddr*)&address, 
-                                 (socklen_t*)&addrlen);
-        
-        if (client_socket < 0) {
-            std::cerr << "Ошибка принятия соединения" << std::endl;
-            continue;
+    // Каждому потоку — свой слушающий сокет на том же порту (SO_REUSEPORT)
+    std::vector<std::unique_ptr<Reactor>> reactors;
+    for (int i = 0; i < threadCount; ++i) {
+        int server_fd = createServerSocket(port, threadCount > 1);
+        if (server_fd < 0) {
+            return 1;
         }
-        
-        std::cout << "Клиент подключился" << std::endl;
-        
-        char buffer[4096];
-        std::string partialMessage;
-        
-        while (true) {
-            ssize_t bytesRead = recv(client_socket, buffer, sizeof(buffer) - 1, 0);
-            
-            if (bytesRead <= 0) {
-                if (bytesRead == 0) {
-                    std::cout << "Клиент отключился" << std::endl;
-                } else {
-                    std::cerr << "Ошибка чтения из сокета" << std::endl;
-                }
-                break;
-            }
-            
-            buffer[bytesRead] = '\0';
-            std::string data = partialMessage + std::string(buffer);
-            partialMessage.clear();
-            
-            // Обработка полученных данных построчно
-            size_t pos = 0;
-            while ((pos = data.find('\n')) != std::string::npos) {
-                std::string line = data.substr(0, pos);
-                data.erase(0, pos + 1);
-                
-                if (line.empty()) continue;
-                
-                // Удаляем символ возврата каретки если есть
-                if (!line.empty() && line.back() == '\r') {
-                    line.pop_back();
-                }
-                
-                std::cout << "Получено: " << line << std::endl;
-                
-                // Парсинг и обработка сообщения
-                std::string message;
-                logging::LogLevel level;
-                
-                if (parseLogMessage(line, message, level)) {
-                    stats.addMessage(message, level);
-                    
-                    // Проверяем, нужно ли вывести статистику
-                    if (stats.shouldPrintStats(messagesInterval, timeoutSeconds)) {
-                        stats.printStatistics();
-                    }
-                } else {
-                    std::cerr << "Не удалось распарсить сообщение: " << line << std::endl;
-                }
-            }
-            
-            // Сохраняем неполное сообщение
-            if (!data.empty()) {
-                partialMessage = data;
-            }
+        auto reactor = std::make_unique<Reactor>(server_fd, shared, shared.shard(reactors.size()), echo,
+                                                 serverRunning);
+        if (!reactor->init()) {
+            std::cerr << "Ошибка создания epoll" << std::endl;
+            return 1;
         }
-        
-        close(client_socket);
+        reactors.push_back(std::move(reactor));
+    }
+    
+    std::unique_ptr<StatsEndpoint> endpoint;
+    if (httpPort > 0) {
+        int http_fd = createServerSocket(httpPort, false);
+        if (http_fd < 0) {
+            return 1;
+        }
+        endpoint = std::make_unique<StatsEndpoint>(http_fd, shared, serverRunning);
+    }
+    
+    std::cout << "Сервер запущен и ожидает подключений на порту " << port << "..." << std::endl;
+    
+    // Поток вывода статистики: каждые N сообщений и по таймауту
+    std::thread reporterThread;
+    if (report) {
+        reporterThread = std::thread(&SharedStatistics::runReporter, &shared, std::ref(serverRunning));
+    }
+    std::thread endpointThread;
+    if (endpoint) {
+        endpointThread = std::thread(&StatsEndpoint::run, endpoint.get());
+    }
+    
+    std::vector<std::thread> threads;
+    for (auto& reactor : reactors) {
+        threads.emplace_back(&Reactor::run, reactor.get());
+    }
+    for (auto& thread : threads) {
+        thread.join();
     }
     
-    running.store(false);
-    timeoutThread.join();
-    close(server_fd);
+    if (reporterThread.joinable()) reporterThread.join();
+    if (endpointThread.joinable()) endpointThread.join();
+    reactors.clear();
     
     return 0;
 }
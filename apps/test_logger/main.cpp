@@ -89,7 +89,10 @@ logging::LogLevel parseLogLevel(const std::string& input, bool& hasLevel) {
     std::string levelStr = input.substr(0, separatorPos);
     
     // Проверяем, является ли это валидным уровнем
-    if (levelStr == "DEBUG" || levelStr == "debug") {
+    if (levelStr == "TRACE" || levelStr == "trace") {
+        hasLevel = true;
+        return logging::LogLevel::TRACE;
+    } else if (levelStr == "DEBUG" || levelStr == "debug") {
         hasLevel = true;
         return logging::LogLevel::DEBUG;
     } else if (levelStr == "INFO" || levelStr == "info") {
@@ -98,6 +101,12 @@ logging::LogLevel parseLogLevel(const std::string& input, bool& hasLevel) {
     } else if (levelStr == "WARNING" || levelStr == "warning" || levelStr == "WARN" || levelStr == "warn") {
         hasLevel = true;
         return logging::LogLevel::WARNING;
+    } else if (levelStr == "ERROR" || levelStr == "error") {
+        hasLevel = true;
+        return logging::LogLevel::ERROR;
+    } else if (levelStr == "FATAL" || levelStr == "fatal") {
+        hasLevel = true;
+        return logging::LogLevel::FATAL;
     }
     
     return logging::LogLevel::INFO;
@@ -142,7 +151,7 @@ void showUsage(const std::string& programName) {
     std::cout << "Использование: " << programName << " <файл_журнала> [уровень_по_умолчанию]\n\n";
     std::cout << "Параметры:\n";
     std::cout << "  файл_журнала          - имя файла для записи журнала\n";
-    std::cout << "  уровень_по_умолчанию  - DEBUG, INFO или WARNING (по умолчанию: INFO)\n\n";
+    std::cout << "  уровень_по_умолчанию  - TRACE, DEBUG, INFO, WARNING, ERROR или FATAL (по умолчанию: INFO)\n\n";
     std::cout << "Формат ввода сообщений:\n";
     std::cout << "  <сообщение>                    - использует уровень по умолчанию\n";
     std::cout << "  <УРОВЕНЬ>: <сообщение>        - использует указанный уровень\n";
@@ -0,0 +1,238 @@
+#include "logging/Logger.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+// Замеры пропускной способности (сообщений/с) и задержки одного вызова (p50/p99/p99.9)
+// для синхронного и асинхронного режима, файла и сокета, отфильтрованных и
+// записываемых уровней, разного числа потоков-производителей и размеров сообщений.
+//
+// Файловые замеры пишут в /dev/null: измеряется стоимость логгера, а не диска.
+// Другой путь можно задать переменной окружения LOGGING_BENCH_FILE.
+
+namespace {
+
+    // Сервер, принимающий подключения и отбрасывающий всё полученное
+    class DiscardServer {
+    private:
+        int listen_fd_ = -1;
+        int port_ = 0;
+        std::atomic<bool> running_{true};
+        std::thread thread_;
+
+        void run() {
+            std::vector<struct pollfd> fds;
+            fds.push_back({listen_fd_, POLLIN, 0});
+            char buffer[64 * 1024];
+            while (running_.load()) {
+                if (poll(fds.data(), fds.size(), 100) <= 0) {
+                    continue;
+                }
+                if (fds[0].revents & POLLIN) {
+                    int client = accept(listen_fd_, nullptr, nullptr);
+                    if (client >= 0) {
+                        fds.push_back({client, POLLIN, 0});
+                    }
+                }
+                for (size_t i = 1; i < fds.size();) {
+                    if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                        if (recv(fds[i].fd, buffer, sizeof(buffer), 0) <= 0) {
+                            close(fds[i].fd);
+                            fds.erase(fds.begin() + static_cast<std::ptrdiff_t>(i));
+                            continue;
+                        }
+                    }
+                    ++i;
+                }
+            }
+            for (auto& pfd : fds) {
+                close(pfd.fd);
+            }
+        }
+
+    public:
+        DiscardServer() {
+            listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+            struct sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            address.sin_port = 0;
+            bind(listen_fd_, reinterpret_cast<struct sockaddr*>(&address), sizeof(address));
+            listen(listen_fd_, 16);
+            socklen_t length = sizeof(address);
+            getsockname(listen_fd_, reinterpret_cast<struct sockaddr*>(&address), &length);
+            port_ = ntohs(address.sin_port);
+            thread_ = std::thread(&DiscardServer::run, this);
+        }
+
+        ~DiscardServer() {
+            running_.store(false);
+            thread_.join();
+        }
+
+        int port() const { return port_; }
+    };
+
+    DiscardServer& discardServer() {
+        static DiscardServer server;
+        return server;
+    }
+
+    std::string benchFile() {
+        const char* path = std::getenv("LOGGING_BENCH_FILE");
+        return path ? path : "/dev/null";
+    }
+
+    enum class Sink { FILE, SOCKET };
+
+    // Логгер общий для всех потоков замера: создаёт его поток 0 до цикла,
+    // удаляет после (начало и конец цикла в Google Benchmark — барьер для потоков)
+    std::unique_ptr<logging::Logger> sharedLogger;
+
+    void setUp(const benchmark::State& state, Sink sink, logging::LoggerConfig config) {
+        if (state.thread_index() != 0) {
+            return;
+        }
+        config.enableRotation = false;
+        if (sink == Sink::SOCKET) {
+            sharedLogger = std::make_unique<logging::Logger>("127.0.0.1", discardServer().port(), config);
+        } else {
+            sharedLogger = std::make_unique<logging::Logger>(benchFile(), config);
+        }
+    }
+
+    void tearDown(const benchmark::State& state) {
+        if (state.thread_index() != 0) {
+            return;
+        }
+        sharedLogger->flush();
+        sharedLogger.reset();
+    }
+
+    // Задержки вызовов одного потока; в отчёт идут квантили, усреднённые по потокам
+    class LatencyRecorder {
+    private:
+        static constexpr size_t kMaxSamples = 1 << 22;
+        std::vector<int64_t> samples_;
+
+    public:
+        LatencyRecorder() { samples_.reserve(1 << 16); }
+
+        void add(std::chrono::steady_clock::duration elapsed) {
+            if (samples_.size() < kMaxSamples) {
+                samples_.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+            }
+        }
+
+        void report(benchmark::State& state) {
+            if (samples_.empty()) {
+                return;
+            }
+            std::sort(samples_.begin(), samples_.end());
+            auto quantile = [this](double q) {
+                size_t index = std::min(samples_.size() - 1, static_cast<size_t>(q * static_cast<double>(samples_.size())));
+                return static_cast<double>(samples_[index]);
+            };
+            state.counters["p50_ns"] = benchmark::Counter(quantile(0.5), benchmark::Counter::kAvgThreads);
+            state.counters["p99_ns"] = benchmark::Counter(quantile(0.99), benchmark::Counter::kAvgThreads);
+            state.counters["p999_ns"] = benchmark::Counter(quantile(0.999), benchmark::Counter::kAvgThreads);
+        }
+    };
+
+    // Один замер: state.range(0) — размер сообщения в байтах
+    void runMessages(benchmark::State& state, Sink sink, logging::LoggerConfig config,
+                     logging::LogLevel level = logging::LogLevel::INFO) {
+        setUp(state, sink, config);
+        const std::string message(static_cast<size_t>(state.range(0)), 'x');
+        LatencyRecorder latency;
+
+        for (auto _ : state) {
+            auto start = std::chrono::steady_clock::now();
+            benchmark::DoNotOptimize(sharedLogger->log(message, level));
+            latency.add(std::chrono::steady_clock::now() - start);
+        }
+
+        state.SetItemsProcessed(state.iterations());
+        state.SetBytesProcessed(state.iterations() * state.range(0));
+        latency.report(state);
+        tearDown(state);
+    }
+
+    logging::LoggerConfig syncConfig() {
+        logging::LoggerConfig config;
+        config.defaultLevel = logging::LogLevel::INFO;
+        return config;
+    }
+
+    logging::LoggerConfig asyncConfig() {
+        logging::LoggerConfig config = syncConfig();
+        config.enableAsync = true;
+        config.asyncQueueSize = 1 << 16;
+        return config;
+    }
+
+}
+
+static void BM_FileSync(benchmark::State& state) { runMessages(state, Sink::FILE, syncConfig()); }
+static void BM_FileAsync(benchmark::State& state) { runMessages(state, Sink::FILE, asyncConfig()); }
+static void BM_SocketSync(benchmark::State& state) { runMessages(state, Sink::SOCKET, syncConfig()); }
+static void BM_SocketAsync(benchmark::State& state) { runMessages(state, Sink::SOCKET, asyncConfig()); }
+
+// Уровень ниже порога: стоимость проверки уровня
+static void BM_FilteredOut(benchmark::State& state) {
+    runMessages(state, Sink::FILE, syncConfig(), logging::LogLevel::DEBUG);
+}
+
+// Форматированная запись: отфильтрованная (аргументы не форматируются) и записываемая
+static void BM_FormatFilteredOut(benchmark::State& state) {
+    setUp(state, Sink::FILE, syncConfig());
+    int64_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sharedLogger->debug("request {} from {} took {} ms", ++i, "client", 3.25));
+    }
+    state.SetItemsProcessed(state.iterations());
+    tearDown(state);
+}
+
+static void BM_FormatEnabled(benchmark::State& state, logging::LoggerConfig config) {
+    setUp(state, Sink::FILE, config);
+    LatencyRecorder latency;
+    int64_t i = 0;
+    for (auto _ : state) {
+        auto start = std::chrono::steady_clock::now();
+        benchmark::DoNotOptimize(sharedLogger->info("request {} from {} took {} ms", ++i, "client", 3.25));
+        latency.add(std::chrono::steady_clock::now() - start);
+    }
+    state.SetItemsProcessed(state.iterations());
+    latency.report(state);
+    tearDown(state);
+}
+
+static void BM_FormatText(benchmark::State& state) { BM_FormatEnabled(state, syncConfig()); }
+
+static void BM_FormatBinary(benchmark::State& state) {
+    logging::LoggerConfig config = syncConfig();
+    config.recordFormat = logging::RecordFormat::BINARY;
+    BM_FormatEnabled(state, config);
+}
+
+BENCHMARK(BM_FileSync)->Arg(16)->Arg(256)->Arg(4096)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_FileAsync)->Arg(16)->Arg(256)->Arg(4096)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_SocketSync)->Arg(256)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_SocketAsync)->Arg(256)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_FilteredOut)->Arg(256)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_FormatFilteredOut)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_FormatText)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_FormatBinary)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "logging/Format.h"
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace logging {
+namespace binary {
+
+     // Двоичный формат журнала (LoggerConfig::recordFormat = RecordFormat::BINARY).
+     // Поток состоит из кадров: u8 тег, u32 длина полезной части, полезная часть.
+     // Все числа — little-endian. Неизвестные теги читатель пропускает по длине.
+     //
+     //   STREAM  "LOGBIN" u8 версия        — начало потока (файла или сегмента ротации)
+     //   FORMAT  u64 id, байты строки      — определение строки формата, один раз на поток
+     //   EVENT   u8 уровень, i64 нс от эпохи, u64 id формата, u16 число аргументов, аргументы
+     //
+     // Аргумент: u8 тип и значение. id формата 0 — сообщение без формата, его текст
+     // передаётся единственным строковым аргументом.
+    constexpr uint8_t kStreamTag = 0x7f;
+    constexpr uint8_t kFormatTag = 0x01;
+    constexpr uint8_t kEventTag = 0x02;
+
+    constexpr char kStreamMagic[] = "LOGBIN";
+    constexpr uint8_t kVersion = 1;
+
+    constexpr size_t kFrameHeaderSize = 5;
+    constexpr size_t kEventFixedSize = 1 + 8 + 8 + 2;
+
+    constexpr uint64_t kPlainMessageId = 0;
+
+    enum class ArgType : uint8_t {
+        INT = 1,      // i64
+        UINT = 2,     // u64
+        FLOAT = 3,    // u32, биты float
+        DOUBLE = 4,   // u64, биты double
+        STRING = 5,   // u32 длина, байты
+        BOOL = 6,     // u8
+        CHAR = 7,     // u8
+        POINTER = 8   // u64
+    };
+
+    inline void appendLE(std::string& out, uint64_t value, size_t bytes) {
+        char buffer[8];
+        for (size_t i = 0; i < bytes; ++i) {
+            buffer[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+        }
+        out.append(buffer, bytes);
+    }
+
+    inline void storeLE(char* destination, uint64_t value, size_t bytes) {
+        for (size_t i = 0; i < bytes; ++i) {
+            destination[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+        }
+    }
+
+    inline uint64_t loadLE(const char* source, size_t bytes) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+            value |= static_cast<uint64_t>(static_cast<unsigned char>(source[i])) << (8 * i);
+        }
+        return value;
+    }
+
+     // Идентификатор строки формата: FNV-1a, 0 зарезервирован за сообщениями без формата
+    constexpr uint64_t formatId(std::string_view format) {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (char c : format) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 0x100000001b3ULL;
+        }
+        return hash == kPlainMessageId ? 1 : hash;
+    }
+
+    inline void appendStringArg(std::string& out, std::string_view value) {
+        out.push_back(static_cast<char>(ArgType::STRING));
+        appendLE(out, value.size(), 4);
+        out.append(value);
+    }
+
+     // Упаковка аргумента; типы и их текстовое представление совпадают с detail::appendArg
+    inline void encodeArg(std::string& out, std::string_view value) { appendStringArg(out, value); }
+    inline void encodeArg(std::string& out, const std::string& value) { appendStringArg(out, value); }
+    inline void encodeArg(std::string& out, const char* value) { appendStringArg(out, value ? value : "(null)"); }
+    inline void encodeArg(std::string& out, char* value) { encodeArg(out, static_cast<const char*>(value)); }
+
+    inline void encodeArg(std::string& out, char value) {
+        out.push_back(static_cast<char>(ArgType::CHAR));
+        out.push_back(value);
+    }
+
+    inline void encodeArg(std::string& out, bool value) {
+        out.push_back(static_cast<char>(ArgType::BOOL));
+        out.push_back(value ? 1 : 0);
+    }
+
+    template<typename T>
+    void encodeArg(std::string& out, const T& value) {
+        if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            out.push_back(static_cast<char>(ArgType::INT));
+            appendLE(out, static_cast<uint64_t>(static_cast<int64_t>(value)), 8);
+        } else if constexpr (std::is_integral_v<T>) {
+            out.push_back(static_cast<char>(ArgType::UINT));
+            appendLE(out, static_cast<uint64_t>(value), 8);
+        } else if constexpr (std::is_same_v<T, float>) {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            out.push_back(static_cast<char>(ArgType::FLOAT));
+            appendLE(out, bits, 4);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            double widened = static_cast<double>(value);
+            uint64_t bits;
+            std::memcpy(&bits, &widened, sizeof(bits));
+            out.push_back(static_cast<char>(ArgType::DOUBLE));
+            appendLE(out, bits, 8);
+        } else if constexpr (std::is_enum_v<T> && !detail::IsStreamable<T>::value) {
+            encodeArg(out, static_cast<std::underlying_type_t<T>>(value));
+        } else if constexpr (std::is_pointer_v<T>) {
+            out.push_back(static_cast<char>(ArgType::POINTER));
+            appendLE(out, reinterpret_cast<std::uintptr_t>(value), 8);
+        } else {
+            // Прочие типы рендерятся сразу, как и в текстовом режиме
+            std::string rendered;
+            detail::appendArg(rendered, value);
+            appendStringArg(out, rendered);
+        }
+    }
+
+     // Подготовленная запись, которую производитель передаёт пишущему потоку:
+     //   u32 длина формата, строка формата, кадр EVENT.
+     // Строка формата нужна пишущему, чтобы выдать FORMAT при первом использовании id;
+     // на диск попадает только кадр EVENT. Уровень и время заполняет finishStagedEvent.
+    template<typename... Args>
+    void stageEvent(std::string& out, uint64_t id, std::string_view format, const Args&... args) {
+        out.clear();
+        appendLE(out, format.size(), 4);
+        out.append(format);
+        out.push_back(static_cast<char>(kEventTag));
+        out.append(4 + 1 + 8, '\0'); // длина, уровень и время — заполняются позже
+        appendLE(out, id, 8);
+        appendLE(out, sizeof...(Args), 2);
+        (encodeArg(out, args), ...);
+    }
+
+    template<typename... Args>
+    void stageEvent(std::string& out, std::string_view format, const Args&... args) {
+        stageEvent(out, formatId(format), format, args...);
+    }
+
+    inline void stageMessage(std::string& out, std::string_view message) {
+        stageEvent(out, kPlainMessageId, std::string_view(), message);
+    }
+
+    inline size_t stagedEventOffset(std::string_view staged) {
+        return 4 + static_cast<size_t>(loadLE(staged.data(), 4));
+    }
+
+    inline void finishStagedEvent(std::string& staged, uint8_t level, int64_t timestampNs) {
+        char* frame = &staged[stagedEventOffset(staged)];
+        const size_t payloadSize = staged.size() - stagedEventOffset(staged) - kFrameHeaderSize;
+        storeLE(frame + 1, payloadSize, 4);
+        frame[kFrameHeaderSize] = static_cast<char>(level);
+        storeLE(frame + kFrameHeaderSize + 1, static_cast<uint64_t>(timestampNs), 8);
+    }
+
+}
+}
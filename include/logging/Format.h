@@ -0,0 +1,105 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <sstream>
+#include <charconv>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace logging {
+namespace detail {
+
+     // Буфер для форматирования сообщений, свой у каждого потока.
+     // Переиспользуется между вызовами, поэтому после прогрева не выделяет память.
+    inline std::string& threadMessageBuffer() {
+        thread_local std::string buffer;
+        return buffer;
+    }
+
+    template<typename T, typename = void>
+    struct IsStreamable : std::false_type {};
+
+    template<typename T>
+    struct IsStreamable<T, std::void_t<decltype(std::declval<std::ostream&>() << std::declval<const T&>())>>
+        : std::true_type {};
+
+     // Добавление одного аргумента в буфер. Числа пишутся через std::to_chars,
+     // строки копируются как есть; прочие типы — через operator<< (с выделением памяти).
+    inline void appendArg(std::string& out, std::string_view value) { out.append(value); }
+    inline void appendArg(std::string& out, const std::string& value) { out.append(value); }
+    inline void appendArg(std::string& out, const char* value) { out.append(value ? value : "(null)"); }
+    inline void appendArg(std::string& out, char* value) { appendArg(out, static_cast<const char*>(value)); }
+    inline void appendArg(std::string& out, char value) { out.push_back(value); }
+    inline void appendArg(std::string& out, bool value) { out.append(value ? "true" : "false"); }
+
+    template<typename T>
+    void appendArg(std::string& out, const T& value) {
+        if constexpr (std::is_integral_v<T>) {
+            char buffer[24];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            out.append(buffer, result.ptr);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            char buffer[32];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            out.append(buffer, result.ptr);
+        } else if constexpr (std::is_enum_v<T> && !IsStreamable<T>::value) {
+            appendArg(out, static_cast<std::underlying_type_t<T>>(value));
+        } else if constexpr (std::is_pointer_v<T>) {
+            char buffer[24];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer),
+                                        reinterpret_cast<std::uintptr_t>(value), 16);
+            out.append("0x", 2);
+            out.append(buffer, result.ptr);
+        } else {
+            static_assert(IsStreamable<T>::value, "logging: argument type is not formattable");
+            std::ostringstream oss;
+            oss << value;
+            out.append(oss.str());
+        }
+    }
+
+     // Копирует литеральную часть формата до следующего "{}" и отдаёт остаток.
+     // "{{" и "}}" выводятся как одиночные скобки. Возвращает false, если "{}" не найдено.
+    inline bool appendUntilPlaceholder(std::string& out, std::string_view& format) {
+        size_t i = 0;
+        while (i < format.size()) {
+            char c = format[i];
+            if (c == '{' || c == '}') {
+                if (i + 1 < format.size() && format[i + 1] == c) {
+                    out.append(format.data(), i + 1);
+                    format.remove_prefix(i + 2);
+                    i = 0;
+                    continue;
+                }
+                if (c == '{' && i + 1 < format.size() && format[i + 1] == '}') {
+                    out.append(format.data(), i);
+                    format.remove_prefix(i + 2);
+                    return true;
+                }
+            }
+            ++i;
+        }
+        out.append(format.data(), format.size());
+        format = std::string_view();
+        return false;
+    }
+
+    inline void formatTo(std::string& out, std::string_view format) {
+        while (appendUntilPlaceholder(out, format)) {
+            out.append("{}", 2); // аргументов меньше, чем мест подстановки
+        }
+    }
+
+    template<typename Arg, typename... Args>
+    void formatTo(std::string& out, std::string_view format, const Arg& arg, const Args&... args) {
+        if (!appendUntilPlaceholder(out, format)) {
+            return; // лишние аргументы игнорируются
+        }
+        appendArg(out, arg);
+        formatTo(out, format, args...);
+    }
+
+}
+}
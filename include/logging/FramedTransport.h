@@ -0,0 +1,106 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+namespace logging {
+namespace framed {
+
+     // Кадровый протокол между EnhancedSocketOutput и log_stats (LoggerConfig::socketCompression).
+     // Согласуется при подключении: клиент посылает строку приветствия со списком кодеков,
+     // сервер отвечает выбранным. Без ответа (старый сервер) клиент пишет обычный текст.
+     //
+     //   клиент -> "#LOGFRAME/1 deflate,none\n"
+     //   сервер -> "#LOGFRAME/1 deflate\n"
+     //
+     // Дальше клиент шлёт кадры: u32 длина полезной части (little-endian), u8 кодек,
+     // полезная часть. Внутри — целые строки журнала с '\n'. Кадры DEFLATE — один поток
+     // raw deflate на соединение (Z_SYNC_FLUSH в конце кадра), поэтому словарь общий для
+     // всех кадров; кадры NONE (например, аварийный сброс) передают текст как есть.
+    constexpr std::string_view kHelloPrefix = "#LOGFRAME/1 ";
+    constexpr size_t kHeaderSize = 5;
+    constexpr size_t kMaxFramePayload = 16 * 1024 * 1024;
+    constexpr size_t kMaxFrameText = 256 * 1024;   // текст одного кадра при кодировании
+
+    enum class Codec : uint8_t {
+        NONE = 0,
+        DEFLATE = 1
+    };
+
+     // true, если библиотека собрана с zlib и умеет DEFLATE
+    bool compressionAvailable();
+
+     // Приветствие клиента с кодеками в порядке предпочтения
+    std::string helloLine(bool compress);
+     // Разбор приветствия (без '\n'): лучший из предложенных кодеков, который мы поддерживаем
+    bool chooseCodec(std::string_view hello, Codec& codec);
+     // Ответ сервера и его разбор клиентом
+    std::string replyLine(Codec codec);
+    bool parseReply(std::string_view reply, Codec& codec);
+
+    inline void storeHeader(char* destination, size_t payloadSize, Codec codec) {
+        for (size_t i = 0; i < 4; ++i) {
+            destination[i] = static_cast<char>((payloadSize >> (8 * i)) & 0xff);
+        }
+        destination[4] = static_cast<char>(codec);
+    }
+
+     // Кодирование текста соединения в кадры. Состояние deflate живёт всё соединение;
+     // при переподключении создаётся новый кодировщик.
+    class FrameEncoder {
+    public:
+        // Кадр в out: wireEnd — конец кадра в out, textEnd — конец его текста во входе
+        struct Boundary {
+            size_t wireEnd;
+            size_t textEnd;
+        };
+
+        explicit FrameEncoder(Codec codec);
+        ~FrameEncoder();
+
+        FrameEncoder(const FrameEncoder&) = delete;
+        FrameEncoder& operator=(const FrameEncoder&) = delete;
+
+        // Дописывает к out кадры с text (кадры режутся по '\n' не больше kMaxFrameText),
+        // границы кадров — в boundaries. false — ошибка сжатия
+        bool encode(std::string_view text, std::string& out, std::vector<Boundary>& boundaries);
+        Codec codec() const { return codec_; }
+
+    private:
+        struct Stream;
+        Codec codec_;
+        std::unique_ptr<Stream> stream_;
+
+        bool appendFrame(std::string_view text, std::string& out);
+    };
+
+     // Разбор кадров на стороне сервера: байты из сокета любыми кусками, на выходе текст
+    class FrameDecoder {
+    public:
+        FrameDecoder();
+        ~FrameDecoder();
+
+        FrameDecoder(const FrameDecoder&) = delete;
+        FrameDecoder& operator=(const FrameDecoder&) = delete;
+
+        // Дописывает к out текст всех законченных кадров; незаконченный кадр ждёт
+        // следующих байтов. false — поток повреждён, соединение нужно закрыть
+        bool feed(const char* data, size_t size, std::string& out);
+        uint64_t wireBytes() const { return wire_bytes_; }
+        uint64_t textBytes() const { return text_bytes_; }
+
+    private:
+        struct Stream;
+        std::unique_ptr<Stream> stream_;
+        std::string partial_;               // начало незаконченного кадра
+        uint64_t wire_bytes_ = 0;
+        uint64_t text_bytes_ = 0;
+
+        bool decodeFrame(Codec codec, const char* payload, size_t size, std::string& out);
+    };
+
+}
+}
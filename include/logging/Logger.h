@@ -1,25 +1,56 @@
 #pragma once
 
+#include "logging/Format.h"
+#include "logging/BinaryFormat.h"
+#include "logging/FramedTransport.h"
+
 #include <string>
+#include <string_view>
 #include <fstream>
 #include <mutex>
 #include <chrono>
 #include <memory>
-#include <queue>
+#include <deque>
 #include <condition_variable>
+#include <shared_mutex>
 #include <thread>
 #include <atomic>
+#include <future>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace logging {
 
     
      // Уровни важности логируемых сообщений
     enum class LogLevel : int {
-        DEBUG = 0,    // Отладочные сообщения
-        INFO = 1,     // Информационные сообщения
-        WARNING = 2   // Предупреждения и ошибки
+        TRACE = 0,    // Трассировочные сообщения
+        DEBUG = 1,    // Отладочные сообщения
+        INFO = 2,     // Информационные сообщения
+        WARNING = 3,  // Предупреждения
+        ERROR = 4,    // Ошибки
+        FATAL = 5     // Критические ошибки
     };
 
+     // Количество уровней (для массивов счётчиков, индексируемых уровнем)
+    constexpr size_t kLogLevelCount = 6;
+
+     // Минимальный уровень, вызовы LOG_* ниже которого удаляются при компиляции.
+     // Задаётся опцией CMake LOGGING_ACTIVE_LEVEL (0 = TRACE ... 5 = FATAL, 6 = всё выключено).
+#ifndef LOGGING_ACTIVE_LEVEL
+#define LOGGING_ACTIVE_LEVEL 0
+#endif
+
+    constexpr int kActiveLevel = LOGGING_ACTIVE_LEVEL;
+
+    constexpr bool isLevelCompiled(LogLevel level) {
+        return static_cast<int>(level) >= kActiveLevel;
+    }
+
     
      // Преобразование уровня логирования в строку
     std::string logLevelToString(LogLevel level);
@@ -33,23 +64,74 @@ namespace logging {
     class LogOutput {
     public:
         virtual ~LogOutput() = default;
-        virtual bool writeLog(const std::string& formattedMessage) = 0;
+        virtual bool writeLog(std::string_view formattedMessage) = 0;
         virtual bool isValid() const = 0;
+        // Сброс буферизованных данных; для небуферизованных выводов ничего не делает
+        virtual bool flush() { return true; }
+        // Запись байтов как есть, без разделителя строк (для двоичного формата).
+        // Выводы, не поддерживающие её, возвращают false из supportsRaw().
+        virtual bool supportsRaw() const { return false; }
+        virtual bool writeRaw(std::string_view data) { (void)data; return false; }
+        // Меняется, когда вывод начинает новый физический поток (например, после ротации)
+        virtual uint64_t streamGeneration() const { return 0; }
+        // Пачка записей одним вызовом, каждая — как в writeLog. По умолчанию writeLog
+        // по очереди; встроенные выводы отдают пачку ОС одним write/sendmsg.
+        virtual bool writeBatch(const std::string_view* records, size_t count) {
+            bool ok = true;
+            for (size_t i = 0; i < count; ++i) {
+                ok = writeLog(records[i]) && ok;
+            }
+            return ok;
+        }
+        // Пачка текстовых записей вместе с их уровнями — для выводов, которые сами решают,
+        // когда сбрасываться (общий вывод LoggerRegistry). По умолчанию уровни не нужны
+        virtual bool writeLeveledBatch(const std::string_view* records, const LogLevel* levels, size_t count) {
+            (void)levels;
+            return writeBatch(records, count);
+        }
+        // Сброс после записи уровня flushLevel и выше. Вывод со своим потоком записи
+        // сбрасывается там сам и не ждёт его; по умолчанию — обычный flush()
+        virtual bool flushForLevel() { return flush(); }
+        // Аварийная запись из обработчика сигнала или std::terminate: сначала всё, что вывод
+        // ещё держит в буфере, затем records (как writeRaw при raw, иначе как writeLog).
+        // Только async-signal-safe вызовы: без блокировок, выделения памяти и исключений.
+        // Выводы без такой поддержки возвращают false.
+        virtual bool emergencyWrite(const std::string_view* records, size_t count, bool raw) noexcept {
+            (void)records;
+            (void)count;
+            (void)raw;
+            return false;
+        }
     };
 
     
-     // Вывод логов в файл
+     // Вывод логов в файл.
+     // Записи копятся в собственном буфере и попадают в файл одним write при заполнении
+     // буфера, по истечении интервала или по flush(). bufferSize == 0 — запись сразу.
     class FileOutput : public LogOutput {
     private:
         std::ofstream file_;
         std::string filename_;
+        std::string buffer_;
+        size_t buffer_size_;
+        std::chrono::milliseconds flush_interval_;
+        std::chrono::steady_clock::time_point last_flush_;
+        int crash_fd_ = -1;                 // opened by emergencyWrite: ofstream has no usable fd
+
+        bool writeBuffer();
+        bool append(std::string_view data, bool newline);
 
     public:
-        explicit FileOutput(const std::string& filename);
+        explicit FileOutput(const std::string& filename, size_t bufferSize = 0, int flushIntervalMs = 0);
         ~FileOutput() override;
         
-        bool writeLog(const std::string& formattedMessage) override;
+        bool writeLog(std::string_view formattedMessage) override;
         bool isValid() const override;
+        bool flush() override;
+        bool supportsRaw() const override { return true; }
+        bool writeRaw(std::string_view data) override;
+        bool writeBatch(const std::string_view* records, size_t count) override;
+        bool emergencyWrite(const std::string_view* records, size_t count, bool raw) noexcept override;
     };
 
      // Вывод логов в сокет (дополнительная функциональность)
@@ -64,8 +146,10 @@ namespace logging {
         SocketOutput(const std::string& host, int port);
         ~SocketOutput() override;
         
-        bool writeLog(const std::string& formattedMessage) override;
+        bool writeLog(std::string_view formattedMessage) override;
+        bool writeBatch(const std::string_view* records, size_t count) override;
         bool isValid() const override;
+        bool emergencyWrite(const std::string_view* records, size_t count, bool raw) noexcept override;
         
     private:
         bool connect();
@@ -80,61 +164,361 @@ namespace logging {
         SOCKET_CONNECTION_FAILED = 2001,
         SOCKET_WRITE_FAILED = 2002,
         CONFIG_PARSE_ERROR = 3001,
+        OUTPUT_NOT_SUPPORTED = 4001,
         QUEUE_OVERFLOW = 5001,
         ROTATION_FAILED = 6001
     };
 
+     // What the async queue does when it is full
+    enum class OverflowPolicy : int {
+        BLOCK = 0,        // producer waits until the worker frees a slot
+        DROP_NEWEST = 1,  // the new record is discarded
+        DROP_OLDEST = 2,  // the oldest queued record is discarded to make room
+        SAMPLE = 3        // near the limit records below WARNING are kept 1-in-N, WARNING+ blocks
+    };
+
+     // How records are stored by the sink
+    enum class RecordFormat : int {
+        TEXT = 0,    // "[timestamp] [LEVEL] message" lines
+        BINARY = 1   // packed records (see BinaryFormat.h), rendered offline by log_decode
+    };
+
+     // Fractional part appended to the timestamp
+    enum class TimestampPrecision : int {
+        SECONDS = 0,
+        MILLISECONDS = 3,
+        MICROSECONDS = 6
+    };
+
      // Configuration structure for logger
     struct LoggerConfig {
         LogLevel defaultLevel = LogLevel::INFO;
+        std::string filename;               // sink of Logger(const LoggerConfig&) and LoggerRegistry: a file,
+        std::string host;                   // or the collector at host:port when filename is empty
+        int port = 0;
+        bool lazyOpen = false;              // open the file / socket on the first record that passes the level check
         bool enableAsync = false;
         size_t asyncQueueSize = 10000;
+        OverflowPolicy overflowPolicy = OverflowPolicy::BLOCK;
+        size_t overflowSampleRate = 10;     // for SAMPLE: keep every N-th low-level record
+        size_t fileBufferSize = 64 * 1024;  // bytes buffered by FileOutput; 0 = write immediately
+        int flushIntervalMs = 1000;         // max age of buffered data; 0 = no timed flush
+        LogLevel flushLevel = LogLevel::WARNING; // records at this level or higher are flushed at once
         size_t maxFileSizeMB = 100;
         size_t maxFiles = 10;
         bool enableRotation = true;
         bool compressOldLogs = false;
-        std::string timestampFormat = "%Y-%m-%d %H:%M:%S";
+        std::string timestampFormat = "%Y-%m-%d %H:%M:%S"; // strftime format of the per-second part
+        TimestampPrecision timestampPrecision = TimestampPrecision::MILLISECONDS;
+        RecordFormat recordFormat = RecordFormat::TEXT; // BINARY needs a file sink
+        std::string loggerName;             // "logger=name" context field of text records; empty = none
+        bool threadIdField = false;         // "tid=N" context field (kernel thread id) of text records
+        bool memoryMappedFile = false;      // MappedFileOutput; segments of maxFileSizeMB (64 if 0)
+        bool ioUring = false;               // IoUringOutput for file sinks when the kernel allows it;
+                                            // host/port sinks ignore it and stay EnhancedSocketOutput
+                                            // (reconnect, compression, background connect). An io_uring
+                                            // socket comes from IoUringOutput::connect() via addOutput
         int reconnectIntervalMs = 5000;
-        int maxReconnectAttempts = 10;
+        int maxReconnectAttempts = 10;      // 0 = retry forever
+        size_t socketBufferBytes = 4 * 1024 * 1024; // unsent data kept while the collector is away
+        bool socketCompression = false;     // deflate-compressed frames to log_stats, negotiated on connect
+        bool connectInBackground = false;   // first connect on the I/O thread: construction never waits for the collector
+        size_t rateLimitPerSecond = 0;      // per call site (format) or message text; 0 = no limit
+        size_t rateLimitBurst = 0;          // records let through at once; 0 = rateLimitPerSecond
+        bool collapseRepeats = false;       // identical consecutive records -> "last message repeated N times"
+        bool collectStats = true;           // counters and latency histograms behind getStats()
+        bool flushOnCrash = false;          // drain queues and buffers on SIGSEGV/SIGABRT/... and std::terminate
     };
 
-     // Async logging queue
+     // Text of a queued record. Up to kInlineCapacity bytes are stored inside the record,
+     // so every slot of an AsyncQueue<LogRecord> is a fixed-size arena entry and steady-state
+     // async logging does not touch the heap; memory is bounded by the queue capacity.
+     // Longer messages take the overflow path: one heap block owned by the record and
+     // released as soon as the record holds a short message again.
+    class RecordBuffer {
+    public:
+        static constexpr size_t kInlineCapacity = 192;
+
+        RecordBuffer() = default;
+        RecordBuffer(RecordBuffer&& other) noexcept { *this = std::move(other); }
+
+        RecordBuffer& operator=(RecordBuffer&& other) noexcept {
+            if (this == &other) {
+                return *this;
+            }
+            size_ = other.size_;
+            if (size_ <= kInlineCapacity) {
+                std::memcpy(inline_, other.inline_, size_);
+                heap_.reset();
+                heap_capacity_ = 0;
+            } else {
+                heap_ = std::move(other.heap_);
+                heap_capacity_ = other.heap_capacity_;
+                other.heap_capacity_ = 0;
+            }
+            other.size_ = 0;
+            return *this;
+        }
+
+        void assign(std::string_view data) { assign(std::string_view(), data); }
+
+        // prefix and data stored back to back, without joining them first
+        void assign(std::string_view prefix, std::string_view data) {
+            const size_t size = prefix.size() + data.size();
+            char* destination = inline_;
+            if (size <= kInlineCapacity) {
+                heap_.reset();
+                heap_capacity_ = 0;
+            } else {
+                if (heap_capacity_ < size) {
+                    heap_.reset(new char[size]);
+                    heap_capacity_ = size;
+                }
+                destination = heap_.get();
+            }
+            if (!prefix.empty()) {
+                std::memcpy(destination, prefix.data(), prefix.size());
+            }
+            std::memcpy(destination + prefix.size(), data.data(), data.size());
+            size_ = size;
+        }
+
+        std::string_view view() const {
+            return std::string_view(size_ <= kInlineCapacity ? inline_ : heap_.get(), size_);
+        }
+        size_t size() const { return size_; }
+        bool onHeap() const { return size_ > kInlineCapacity; }
+
+    private:
+        size_t size_ = 0;
+        std::unique_ptr<char[]> heap_;
+        size_t heap_capacity_ = 0;
+        char inline_[kInlineCapacity];
+    };
+
+     // Latency distribution in power-of-two buckets: buckets[i] counts samples
+     // of [2^i, 2^(i+1)) ns; quantiles interpolate inside a bucket
+    struct LatencyHistogram {
+        static constexpr size_t kBuckets = 40;
+        uint64_t buckets[kBuckets] = {};
+        uint64_t count = 0;
+        uint64_t totalNs = 0;
+        uint64_t maxNs = 0;
+
+        double meanNs() const { return count > 0 ? static_cast<double>(totalNs) / static_cast<double>(count) : 0.0; }
+        double quantileNs(double q) const;
+    };
+
+     // Snapshot returned by Logger::getStats(); counters are totals since construction
+    struct LoggerStats {
+        uint64_t accepted[kLogLevelCount] = {};  // passed the level filter and the rate limit
+        uint64_t filtered[kLogLevelCount] = {};  // below the logger's level
+        uint64_t dropped[kLogLevelCount] = {};   // lost to async queue overflow
+        uint64_t suppressed = 0;                 // rate limit and collapsed repeats
+        uint64_t bytesWritten = 0;               // handed to the main output, newlines included
+        uint64_t sinkWrites = 0;                 // writeBatch/writeRaw calls on the main output
+        uint64_t writeErrors = 0;                // of those, calls that returned false
+        uint64_t flushes = 0;                    // flushes of the main output
+        size_t queueDepth = 0;                   // async queue, at the time of the snapshot
+        size_t queueHighWater = 0;               // deepest queue seen by the worker
+        size_t queueCapacity = 0;                // 0 while async mode is off
+        LatencyHistogram enqueueLatency;         // log() after formatting: queued or written (sampled 1/16)
+        LatencyHistogram sinkWriteLatency;       // one call to the main output (sampled 1/8)
+
+        uint64_t acceptedTotal() const;
+        uint64_t filteredTotal() const;
+        uint64_t droppedTotal() const;
+    };
+
+     // Record passed from producers to the async worker
+    struct LogRecord {
+        RecordBuffer message;
+        LogLevel level = LogLevel::INFO;
+        std::chrono::system_clock::time_point timestamp;
+        std::promise<void>* flushBarrier = nullptr; // set only for Logger::flush() markers
+        bool binary = false;                         // message holds a staged binary event
+    };
+
+     // Async logging queue: bounded lock-free ring (Vyukov), many producers, one consumer.
+     // Capacity is rounded up to a power of two.
     template<typename T>
     class AsyncQueue {
     private:
-        std::queue<T> queue_;
-        mutable std::mutex mutex_;
-        std::condition_variable cv_;
+        struct Slot {
+            std::atomic<size_t> sequence;
+            T data;
+        };
+
+        static constexpr size_t kCacheLine = 64;
+        static constexpr int kSpinsBeforePark = 256;
+
+        std::unique_ptr<Slot[]> slots_;
+        size_t mask_;
+        alignas(kCacheLine) std::atomic<size_t> enqueue_pos_{0};
+        alignas(kCacheLine) std::atomic<size_t> dequeue_pos_{0};
+        alignas(kCacheLine) std::atomic<bool> consumer_waiting_{false};
         std::atomic<bool> shutdown_{false};
-        size_t max_size_;
+        std::mutex wait_mutex_;
+        std::condition_variable cv_;
+
+        static size_t roundUpToPowerOfTwo(size_t value) {
+            size_t result = 2;
+            while (result < value) result <<= 1;
+            return result;
+        }
+
+        bool waitPop(T& item, const std::chrono::steady_clock::time_point* deadline) {
+            for (;;) {
+                for (int spin = 0; spin < kSpinsBeforePark; ++spin) {
+                    if (tryPop(item)) return true;
+                    if (shutdown_.load(std::memory_order_acquire)) {
+                        return tryPop(item);
+                    }
+                }
+
+                std::unique_lock<std::mutex> lock(wait_mutex_);
+                consumer_waiting_.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (tryPop(item)) {
+                    consumer_waiting_.store(false, std::memory_order_relaxed);
+                    return true;
+                }
+                if (shutdown_.load(std::memory_order_acquire)) {
+                    consumer_waiting_.store(false, std::memory_order_relaxed);
+                    return tryPop(item);
+                }
+
+                auto wakeup = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+                if (deadline && *deadline < wakeup) {
+                    wakeup = *deadline;
+                }
+                cv_.wait_until(lock, wakeup);
+                consumer_waiting_.store(false, std::memory_order_relaxed);
+
+                if (deadline && std::chrono::steady_clock::now() >= *deadline) {
+                    lock.unlock();
+                    return tryPop(item);
+                }
+            }
+        }
+
+        void wakeConsumer() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (consumer_waiting_.load(std::memory_order_relaxed)) {
+                std::lock_guard<std::mutex> lock(wait_mutex_);
+                cv_.notify_one();
+            }
+        }
 
     public:
-        explicit AsyncQueue(size_t max_size = 10000) : max_size_(max_size) {}
+        explicit AsyncQueue(size_t max_size = 10000)
+            : slots_(new Slot[roundUpToPowerOfTwo(max_size)]),
+              mask_(roundUpToPowerOfTwo(max_size) - 1) {
+            for (size_t i = 0; i <= mask_; ++i) {
+                slots_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        AsyncQueue(const AsyncQueue&) = delete;
+        AsyncQueue& operator=(const AsyncQueue&) = delete;
+
+        // Неблокирующая вставка с заполнением элемента прямо в ячейке кольца;
+        // fill(T&) вызывается только после захвата ячейки. false, если очередь заполнена
+        template<typename Fill>
+        bool emplace(Fill&& fill) {
+            size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+            for (;;) {
+                Slot& slot = slots_[pos & mask_];
+                size_t seq = slot.sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                if (diff == 0) {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        fill(slot.data);
+                        slot.sequence.store(pos + 1, std::memory_order_release);
+                        wakeConsumer();
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Неблокирующая вставка; false, если очередь заполнена
+        bool push(T&& item) {
+            return emplace([&item](T& data) { data = std::move(item); });
+        }
 
         bool push(const T& item) {
-            std::lock_guard<std::mutex> lock(mutex_);
-            if (queue_.size() >= max_size_) return false;
-            queue_.push(item);
-            cv_.notify_one();
-            return true;
+            return emplace([&item](T& data) { data = item; });
+        }
+
+        // Неблокирующее извлечение; false, если очередь пуста
+        bool tryPop(T& item) {
+            return tryConsume([&item](T& data) { item = std::move(data); });
+        }
+
+        // Извлечение с обработкой элемента прямо в ячейке кольца: без перемещения
+        // и освобождения памяти (аварийный сброс из обработчика сигнала)
+        template<typename Visit>
+        bool tryConsume(Visit&& visit) {
+            size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+            for (;;) {
+                Slot& slot = slots_[pos & mask_];
+                size_t seq = slot.sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+                if (diff == 0) {
+                    if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        visit(slot.data);
+                        slot.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = dequeue_pos_.load(std::memory_order_relaxed);
+                }
+            }
         }
 
+        // Блокирующее извлечение; false только после shutdown() и опустошения очереди
         bool pop(T& item) {
-            std::unique_lock<std::mutex> lock(mutex_);
-            cv_.wait(lock, [this] { return !queue_.empty() || shutdown_.load(); });
-            if (shutdown_.load() && queue_.empty()) return false;
-            item = queue_.front();
-            queue_.pop();
-            return true;
+            return waitPop(item, nullptr);
+        }
+
+        // Извлечение с таймаутом; false также при истечении таймаута
+        bool pop(T& item, std::chrono::milliseconds timeout) {
+            auto deadline = std::chrono::steady_clock::now() + timeout;
+            return waitPop(item, &deadline);
         }
 
         void shutdown() {
-            shutdown_.store(true);
+            shutdown_.store(true, std::memory_order_release);
+            std::lock_guard<std::mutex> lock(wait_mutex_);
             cv_.notify_all();
         }
+
+        bool isShutdown() const {
+            return shutdown_.load(std::memory_order_acquire);
+        }
+
+        // Приблизительное число элементов (точно только в состоянии покоя)
+        size_t size() const {
+            size_t enq = enqueue_pos_.load(std::memory_order_acquire);
+            size_t deq = dequeue_pos_.load(std::memory_order_acquire);
+            return enq >= deq ? enq - deq : 0;
+        }
+
+        size_t capacity() const { return mask_ + 1; }
     };
 
-     // Log rotation handler
+     // Log rotation handler.
+     // rotate() only renames the live file to a pending name; shifting base.1..base.N,
+     // deleting the oldest segment and gzip compression run on a background thread.
+     // Pending segments left by a process that exited mid-rotation are picked up by the
+     // constructor, and new pending names never reuse an existing file.
     class LogRotator {
     private:
         std::string base_filename_;
@@ -142,13 +526,59 @@ namespace logging {
         size_t max_files_;
         bool compress_;
 
+        std::deque<std::string> pending_;   // renamed segments waiting for the cascade
+        uint64_t next_pending_id_ = 0;
+        bool busy_ = false;
+        bool stopping_ = false;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::condition_variable idle_cv_;
+        std::thread worker_;
+
+        std::string segmentName(size_t index, bool compressed) const;
+        void workerLoop();
+        void processSegment(const std::string& pendingFile);
+
     public:
         LogRotator(const std::string& base_filename, size_t max_size_mb, size_t max_files, bool compress);
+        ~LogRotator();
+
+        LogRotator(const LogRotator&) = delete;
+        LogRotator& operator=(const LogRotator&) = delete;
+
         bool shouldRotate(size_t current_size) const;
         bool rotate();
+        void waitIdle();                    // blocks until all background work is done
+        const std::string& baseFilename() const { return base_filename_; }
+    };
+
+     // Sequential reader for segments left by LogRotator: base.N is read as is and
+     // base.N.gz is decompressed on the fly. gzip is recognised by content, not by name.
+    class LogSegmentReader {
+    private:
+        int fd_ = -1;
+        void* gz_ = nullptr;                // gzFile when the segment is compressed
+        bool compressed_ = false;
+
+    public:
+        LogSegmentReader() = default;
+        ~LogSegmentReader();
+
+        LogSegmentReader(const LogSegmentReader&) = delete;
+        LogSegmentReader& operator=(const LogSegmentReader&) = delete;
+
+        // false: the file cannot be opened, or it is gzip and the library has no zlib
+        bool open(const std::string& path);
+        // Bytes read into buffer, 0 at the end of the segment, -1 on I/O error or damaged gzip
+        int64_t read(char* buffer, size_t size);
+        void close();
+        bool compressed() const { return compressed_; }
     };
 
-     // Enhanced socket output with reconnection
+     // Enhanced socket output with reconnection.
+     // writeLog only appends to an in-memory buffer; a background I/O thread owns the
+     // non-blocking socket, sends everything accumulated so far in one go, keeps
+     // (bounded) unsent data while disconnected and replays it after reconnecting.
     class EnhancedSocketOutput : public LogOutput {
     private:
         int socket_fd_;
@@ -159,69 +589,493 @@ namespace logging {
         int reconnect_interval_ms_;
         int max_reconnect_attempts_;
         std::thread reconnect_thread_;
-        std::mutex reconnect_mutex_;
+        mutable std::mutex reconnect_mutex_;
+
+        std::condition_variable io_cv_;
+        std::condition_variable drained_cv_;
+        std::string pending_;               // records not yet handed to the I/O thread
+        size_t in_flight_ = 0;              // bytes the I/O thread is sending right now
+        size_t max_buffer_bytes_;
+        std::atomic<uint64_t> dropped_records_{0};
+        std::atomic<bool> gave_up_{false};
+        std::atomic<bool> stopping_{false};
+
+        // Framed transport (see FramedTransport.h): the encoder exists while the current
+        // connection has negotiated frames; wire_ and boundaries_ belong to the I/O thread
+        bool compress_;
+        std::unique_ptr<framed::FrameEncoder> encoder_;
+        std::string wire_;
+        std::vector<framed::FrameEncoder::Boundary> boundaries_;
+        std::atomic<uint64_t> payload_bytes_{0};
+        std::atomic<uint64_t> wire_bytes_{0};
 
         bool connect();
+        bool negotiate(int fd);
         void disconnect();
         void reconnectLoop();
+        bool sendAll(const std::string& data, size_t& sent);
 
     public:
         EnhancedSocketOutput(const std::string& host, int port, 
                            int reconnect_interval_ms = 5000, 
-                           int max_reconnect_attempts = 10);
+                           int max_reconnect_attempts = 10,
+                           size_t max_buffer_bytes = 4 * 1024 * 1024,
+                           bool compress = false,
+                           bool connect_in_background = false);
         ~EnhancedSocketOutput() override;
         
-        bool writeLog(const std::string& formattedMessage) override;
-        bool isValid() const override;
+        bool writeLog(std::string_view formattedMessage) override;
+        bool writeBatch(const std::string_view* records, size_t count) override;
+        bool isValid() const override;      // true while records are accepted (connected or buffering)
+        bool flush() override;              // wakes the I/O thread; never waits for the network
+        bool waitDrained(std::chrono::milliseconds timeout); // true once everything was sent
+        bool emergencyWrite(const std::string_view* records, size_t count, bool raw) noexcept override;
+        bool isConnected() const { return connected_.load(); }
+        uint64_t droppedRecords() const { return dropped_records_.load(); }
+        bool isFramed() const;              // the current connection sends frames instead of text
+        uint64_t sentPayloadBytes() const { return payload_bytes_.load(std::memory_order_relaxed); }
+        uint64_t sentWireBytes() const { return wire_bytes_.load(std::memory_order_relaxed); }
     };
 
-     // Enhanced file output with rotation
+     // Enhanced file output with rotation (buffered like FileOutput)
     class EnhancedFileOutput : public LogOutput {
     private:
-        std::ofstream file_;
+        std::unique_ptr<LogOutput> file_;   // FileOutput or IoUringOutput
         std::string filename_;
         std::unique_ptr<LogRotator> rotator_;
         size_t current_size_;
-        std::mutex file_mutex_;
+        size_t buffer_size_;
+        int flush_interval_ms_;
+        bool io_uring_;
+        std::atomic<uint64_t> generation_{0};
+        mutable std::mutex file_mutex_;
+
+        std::unique_ptr<LogOutput> openFile() const;
+        void rotateFile();
 
     public:
         EnhancedFileOutput(const std::string& filename, 
                           size_t max_size_mb = 100, 
                           size_t max_files = 10,
-                          bool compress = false);
+                          bool compress = false,
+                          size_t bufferSize = 0,
+                          int flushIntervalMs = 0,
+                          bool ioUring = false);
         ~EnhancedFileOutput() override;
         
-        bool writeLog(const std::string& formattedMessage) override;
+        bool writeLog(std::string_view formattedMessage) override;
         bool isValid() const override;
+        bool flush() override;
+        bool supportsRaw() const override { return true; }
+        bool writeRaw(std::string_view data) override;
+        bool writeBatch(const std::string_view* records, size_t count) override;
+        uint64_t streamGeneration() const override { return generation_.load(std::memory_order_acquire); }
+        bool emergencyWrite(const std::string_view* records, size_t count, bool raw) noexcept override;
+        LogRotator& rotator() { return *rotator_; }
+    };
+
+     // Memory-mapped file output.
+     // The segment is preallocated (fallocate) and mapped MAP_SHARED; a write reserves
+     // space with one fetch_add on the cursor and memcpy's into the mapping, so data
+     // survives a process crash as soon as the call returns. When the segment is full
+     // it is truncated to its used size and handed to LogRotator (or, without a rotator,
+     // the file grows by another segment). A background thread msync's dirty pages.
+     // The last bytes of an open segment hold a trailer with the used length, so a file
+     // left preallocated by a crash is reopened after its data even if a binary record
+     // ends in zero bytes; a clean close truncates the trailer away.
+    class MappedFileOutput : public LogOutput {
+    private:
+        std::string filename_;
+        size_t segment_size_;
+        std::unique_ptr<LogRotator> rotator_;        // null: grow the file instead of rolling
+        std::chrono::milliseconds flush_interval_;
+
+        // shared: writers copying into the mapping; exclusive: roll, grow and close
+        mutable std::shared_mutex segment_mutex_;
+        int fd_ = -1;
+        char* data_ = nullptr;
+        size_t capacity_ = 0;
+        std::atomic<size_t> cursor_{0};
+        std::atomic<size_t> sealed_size_{SIZE_MAX}; // end of data once a reservation overflowed
+        std::atomic<uint64_t> generation_{0};
+
+        bool stopping_ = false;
+        bool flush_requested_ = false;
+        std::mutex flusher_mutex_;
+        std::condition_variable flusher_cv_;
+        std::thread flusher_;
+
+        bool openSegment();
+        void closeSegment();
+        bool extendSegment(size_t needed);
+        void writeTrailer(size_t used);
+        uint64_t* trailerLength() const;
+        void commit(size_t end) noexcept;
+        bool append(const std::string_view* parts, size_t count, bool newline);
+        size_t usedSize() const;
+        void flusherLoop();
+
+    public:
+        MappedFileOutput(const std::string& filename,
+                         size_t segment_size_mb = 100,
+                         size_t max_files = 10,
+                         bool compress = false,
+                         int flushIntervalMs = 1000,
+                         bool rotate = true);
+        ~MappedFileOutput() override;
+
+        MappedFileOutput(const MappedFileOutput&) = delete;
+        MappedFileOutput& operator=(const MappedFileOutput&) = delete;
+
+        bool writeLog(std::string_view formattedMessage) override;
+        bool isValid() const override;
+        bool flush() override;
+        bool supportsRaw() const override { return true; }
+        bool writeRaw(std::string_view data) override;
+        bool writeBatch(const std::string_view* records, size_t count) override; // one reservation
+        uint64_t streamGeneration() const override { return generation_.load(std::memory_order_acquire); }
+        bool emergencyWrite(const std::string_view* records, size_t count, bool raw) noexcept override; // current segment only
+        size_t segmentSize() const { return segment_size_; }
+        LogRotator* rotator() { return rotator_.get(); }
+    };
+
+     // Вывод через io_uring (Linux) в файл или TCP-сокет.
+     // Записи копятся в одном из kBufferCount заранее зарегистрированных в ядре буферов;
+     // заполненный буфер отправляется без ожидания (файл — WRITE_FIXED по своему смещению,
+     // сокет — SEND по очереди), а следующие записи копятся в свободном буфере. Поток
+     // записи ждёт ядро только в flush() и когда все буферы ещё в полёте. Как и FileOutput,
+     // не потокобезопасен: его вызывают под блокировкой логгера или из одного потока.
+     // Если io_uring недоступен (старое ядро, запрет в контейнере, сборка без
+     // LOGGING_WITH_IO_URING), isAvailable() == false и логгер выбирает обычные выводы.
+    class IoUringOutput : public LogOutput {
+    public:
+        static constexpr size_t kBufferCount = 4;
+
+        explicit IoUringOutput(const std::string& filename, size_t bufferSize = 0, int flushIntervalMs = 0);
+        // Вывод в TCP-сокет (без переподключения, как SocketOutput)
+        static std::unique_ptr<IoUringOutput> connect(const std::string& host, int port,
+                                                      size_t bufferSize = 0, int flushIntervalMs = 0);
+        ~IoUringOutput() override;
+
+        IoUringOutput(const IoUringOutput&) = delete;
+        IoUringOutput& operator=(const IoUringOutput&) = delete;
+
+        // Ядро и сборка поддерживают io_uring (проверяется один раз)
+        static bool isAvailable();
+
+        bool writeLog(std::string_view formattedMessage) override;
+        bool isValid() const override;
+        bool flush() override;              // waits until every buffer reached the kernel's file/socket
+        bool supportsRaw() const override { return !socket_; }
+        bool writeRaw(std::string_view data) override;
+        bool writeBatch(const std::string_view* records, size_t count) override;
+        bool emergencyWrite(const std::string_view* records, size_t count, bool raw) noexcept override;
+        bool usesRegisteredBuffers() const;
+
+    private:
+        struct Ring;                        // кольца, буферы и очередь отправки (IoUringOutput.cpp)
+        std::unique_ptr<Ring> ring_;
+        int fd_ = -1;
+        bool socket_ = false;
+        bool immediate_;                    // bufferSize == 0: буфер уходит в конце каждого вызова
+        std::chrono::milliseconds flush_interval_;
+        std::chrono::steady_clock::time_point last_flush_;
+
+        IoUringOutput(int fd, bool socket, size_t bufferSize, int flushIntervalMs);
+        bool append(std::string_view data, bool newline);
+        bool finishCall();
+    };
+
+     // Чтение двоичного журнала (RecordFormat::BINARY): байты подаются кусками через
+     // append(), next() отдаёт разобранные записи с уже подставленными аргументами.
+    class BinaryLogDecoder {
+    public:
+        enum class Status { RECORD, NEED_MORE, CORRUPT };
+
+        struct Record {
+            LogLevel level = LogLevel::INFO;
+            std::chrono::system_clock::time_point timestamp;
+            std::string message;
+        };
+
+        explicit BinaryLogDecoder(std::string timestampFormat = "%Y-%m-%d %H:%M:%S",
+                                  TimestampPrecision precision = TimestampPrecision::MILLISECONDS);
+
+        void append(std::string_view data);
+        Status next(Record& record);
+        // Строка в текстовом формате логгера: "[timestamp] [LEVEL] message"
+        void render(std::string& out, const Record& record) const;
+        // Остались байты незавершённой записи
+        bool hasPendingData() const { return offset_ < buffer_.size(); }
+
+    private:
+        std::string buffer_;
+        size_t offset_ = 0;
+        std::unordered_map<uint64_t, std::string> formats_;
+        std::string timestamp_format_;
+        TimestampPrecision precision_;
+
+        bool decodeEvent(std::string_view payload, Record& record) const;
+    };
+
+     // Output created on first use: the file is opened (or the socket created) by the first
+     // record that reaches it, so a logger that never writes above its level costs no I/O at
+     // startup. supportsRaw is fixed up front because setConfig asks before any write.
+    class LazyOutput : public LogOutput {
+    public:
+        using Factory = std::function<std::unique_ptr<LogOutput>()>;
+
+        LazyOutput(Factory factory, bool supportsRaw);
+
+        bool writeLog(std::string_view formattedMessage) override;
+        bool writeBatch(const std::string_view* records, size_t count) override;
+        bool isValid() const override;      // true until the sink is opened and turns out invalid
+        bool flush() override;              // nothing to flush before the first write
+        bool supportsRaw() const override { return supports_raw_; }
+        bool writeRaw(std::string_view data) override;
+        uint64_t streamGeneration() const override;
+        bool emergencyWrite(const std::string_view* records, size_t count, bool raw) noexcept override;
+        bool isOpen() const { return output_.load(std::memory_order_acquire) != nullptr; }
+
+    private:
+        Factory factory_;
+        bool supports_raw_;
+        std::mutex open_mutex_;
+        std::unique_ptr<LogOutput> owned_;
+        std::atomic<LogOutput*> output_{nullptr};
+        std::atomic<bool> failed_{false};
+
+        LogOutput* open();
+    };
+
+     // Sink described by config.filename or config.host/port (see LoggerConfig),
+     // wrapped in a LazyOutput when config.lazyOpen is set; nullptr if neither is given
+    std::unique_ptr<LogOutput> createOutput(const LoggerConfig& config);
+
+     // Additional Logger output with its own level filter, queue and drain thread.
+     // The logger formats each record once and hands every lane a copy of the text;
+     // a slow output only fills its own queue, after which its records are dropped.
+    class OutputLane {
+    private:
+        std::unique_ptr<LogOutput> output_;
+        std::atomic<LogLevel> min_level_;
+        LogLevel flush_level_;
+        std::chrono::milliseconds flush_interval_;
+        AsyncQueue<LogRecord> queue_;
+        std::atomic<uint64_t> dropped_{0};
+        std::vector<LogRecord> batch_;      // worker thread only
+        std::vector<std::string_view> views_;
+        std::thread worker_;
+
+        void workerLoop();
+
+    public:
+        OutputLane(std::unique_ptr<LogOutput> output, LogLevel minLevel, size_t queueSize,
+                   LogLevel flushLevel = LogLevel::WARNING, int flushIntervalMs = 1000);
+        ~OutputLane();
+
+        OutputLane(const OutputLane&) = delete;
+        OutputLane& operator=(const OutputLane&) = delete;
+
+        bool accepts(LogLevel level) const {
+            return static_cast<int>(level) >= static_cast<int>(min_level_.load(std::memory_order_relaxed));
+        }
+        bool push(std::string_view formattedMessage, LogLevel level); // never blocks
+        bool pushWait(std::string_view formattedMessage, LogLevel level); // waits for room like OverflowPolicy::BLOCK
+        bool flush();                       // waits until queued records reach the output
+        bool emergencyDrain() noexcept;     // crash path: queued records straight to emergencyWrite
+        // crash path: the queue, then records, through the output's emergencyWrite
+        bool emergencyWrite(const std::string_view* records, size_t count, bool raw) noexcept;
+        void setMinLevel(LogLevel level) { min_level_.store(level, std::memory_order_relaxed); }
+        LogLevel getMinLevel() const { return min_level_.load(std::memory_order_relaxed); }
+        uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+        LogOutput& output() { return *output_; }
+    };
+
+     // Key/value tags of the calling thread, added to every text record of every logger
+     // as one context field after the level: "[ts] [LEVEL] [logger=db tid=42 request=7] text".
+     // The field is rendered once per change of the tags (or of the logger's name/tid settings)
+     // and copied into records as ready bytes. Spaces, '=' and ']' in keys and values become '_'.
+    class LogContext {
+    public:
+        static void set(std::string_view key, std::string_view value);
+        static bool get(std::string_view key, std::string& value);
+        static void remove(std::string_view key);
+        static void clear();
+    };
+
+     // Sets a tag for the current scope and restores the previous value (or removes the tag)
+    class ScopedLogTag {
+    public:
+        ScopedLogTag(std::string_view key, std::string_view value)
+            : key_(key), had_previous_(LogContext::get(key, previous_)) {
+            LogContext::set(key, value);
+        }
+        ~ScopedLogTag() {
+            if (had_previous_) {
+                LogContext::set(key_, previous_);
+            } else {
+                LogContext::remove(key_);
+            }
+        }
+
+        ScopedLogTag(const ScopedLogTag&) = delete;
+        ScopedLogTag& operator=(const ScopedLogTag&) = delete;
+
+    private:
+        std::string key_;
+        std::string previous_;
+        bool had_previous_;
     };
 
      // Основной класс логгера с расширенными функциями
     class Logger {
     private:
         std::unique_ptr<LogOutput> output_;
-        LogLevel defaultLevel_;
+        std::atomic<LogLevel> defaultLevel_;
         mutable std::mutex mutex_;
-        LoggerConfig config_;
+        
+        // Configuration is published as immutable snapshots (RCU style):
+        // setConfig swaps the pointer with std::atomic_store and bumps config_version_,
+        // the writer (holder of mutex_) re-reads the pointer only when the version changes.
+        struct ConfigSnapshot {
+            LoggerConfig config;
+            uint64_t timestampFormatId; // identifies config.timestampFormat in the timestamp cache
+            uint64_t contextFieldsId;   // identifies loggerName/threadIdField in the context cache
+        };
+        std::shared_ptr<const ConfigSnapshot> config_;
+        std::atomic<uint64_t> config_version_{0};
+        std::shared_ptr<const ConfigSnapshot> active_config_; // writer's copy, under mutex_
+        uint64_t active_config_version_ = 0;
+        std::mutex config_mutex_;                             // serializes setConfig calls
+        const uint64_t instance_id_;                          // keys per-thread config caches
+        
+        // Synchronous path uses flat combining: each producer formats into its own
+        // thread-local buffer and pushes a stack-allocated node onto pending_writes_;
+        // whoever acquires mutex_ writes every pending node to the sink in one pass.
+        struct PendingWrite;
+        std::atomic<PendingWrite*> pending_writes_{nullptr};
+        
+        // Binary record format: producers stage packed events, the writer (holder of
+        // mutex_) adds the stream header and format definitions once per output stream
+        std::atomic<bool> binary_records_{false};
+        bool binary_stream_started_ = false;      // under mutex_
+        uint64_t binary_generation_ = 0;          // under mutex_
+        std::unordered_set<uint64_t> binary_formats_; // ids defined in the current stream, under mutex_
+        std::string binary_scratch_;              // under mutex_
+        
+        // Text records collected for one LogOutput::writeBatch call (under mutex_):
+        // the async worker formats into batch_text_, batch_ends_ marks where each record ends
+        std::string batch_text_;
+        std::vector<size_t> batch_ends_;
+        std::vector<std::string_view> batch_views_;
+        std::vector<LogLevel> batch_levels_;
+        
+        // Extra outputs fed with the records written to output_ (vector under mutex_)
+        std::vector<std::unique_ptr<OutputLane>> lanes_;
         
         // Async logging support
-        std::unique_ptr<AsyncQueue<std::pair<std::string, LogLevel>>> async_queue_;
+        std::unique_ptr<AsyncQueue<LogRecord>> async_queue_;
         std::unique_ptr<std::thread> async_worker_;
         std::atomic<bool> async_running_{false};
+        std::atomic<int> async_producers_{0};
+        // Where the async worker's current record is, for emergencyFlush: POPPING — inside pop(),
+        // HOLDING — popped and waiting for mutex_, TAKEN — already written by emergencyFlush
+        enum class WorkerState : int { IDLE, POPPING, HOLDING, TAKEN };
+        std::atomic<WorkerState> worker_state_{WorkerState::IDLE};
+        std::atomic<LogRecord*> worker_record_{nullptr};
+        mutable std::mutex async_control_mutex_;
         
+        // Overflow handling (copied from config_ so the producer path needs no lock)
+        std::atomic<OverflowPolicy> overflow_policy_{OverflowPolicy::BLOCK};
+        std::atomic<size_t> overflow_sample_rate_{10};
+        std::atomic<uint64_t> overflow_sample_counter_{0};
+        std::atomic<uint64_t> dropped_[kLogLevelCount] = {};
+        std::atomic<int64_t> last_drop_ns_[kLogLevelCount] = {};
+
+        // Rate limiting and collapsing of repeats (copied from config_ like overflow_policy_).
+        // Each call site hashes into a fixed table of token buckets kept as one atomic
+        // "theoretical arrival time" (GCRA), so there is no lock and no map; sites that
+        // collide share a bucket. Suppressed counts are written out as a summary record.
+        struct RateSlot {
+            std::atomic<int64_t> next_ns{0};
+            std::atomic<uint64_t> suppressed{0};
+            std::atomic<LogLevel> level{LogLevel::INFO};
+        };
+        static constexpr size_t kRateSlots = 1024;
+        std::unique_ptr<RateSlot[]> rate_slots_{new RateSlot[kRateSlots]};
+        std::atomic<bool> throttling_{false};
+        std::atomic<int64_t> rate_interval_ns_{0};
+        std::atomic<int64_t> rate_burst_ns_{0};
+        std::atomic<bool> collapse_repeats_{false};
+        std::atomic<uint64_t> last_record_key_{0};
+        std::atomic<uint64_t> repeat_count_{0};
+        std::atomic<LogLevel> repeat_level_{LogLevel::INFO};
+        std::atomic<uint64_t> suppressed_total_{0};
+
+        // Self-instrumentation: each producer thread counts into its own shard (found through
+        // a thread-local cache keyed by instance_id_), the writer into writer_stats_;
+        // getStats() sums them without stopping anyone
+        struct StatsShard;
+        std::atomic<bool> collect_stats_{true};
+        std::vector<std::unique_ptr<StatsShard>> stats_shards_; // under stats_mutex_
+        mutable std::mutex stats_mutex_;
+        std::unique_ptr<StatsShard> writer_stats_;
+
         // Error tracking
-        LoggingError last_error_;
+        std::atomic<LoggingError> last_error_{LoggingError::SUCCESS};
         std::string last_error_message_;
+        mutable std::mutex error_mutex_;
 
-        std::string formatMessage(const std::string& message, LogLevel level) const;
-        std::string getCurrentTime() const;
+        void publishConfig(const LoggerConfig& config);
+        bool logMessage(std::string_view message, LogLevel level);
+        StatsShard* statsShard();
+        int64_t startRecord(LogLevel level, StatsShard*& shard);
+        void finishRecord(StatsShard* shard, int64_t startedNs);
+        bool writeToOutput(const std::string_view* records, const LogLevel* levels, size_t count, bool raw);
+        bool flushOutput(bool forLevel = false);   // forLevel: after a flushLevel record, may not wait
+        bool admit(uint64_t siteHash, uint64_t recordHash, LogLevel level);
+        void reportRepeats();
+        void reportSuppressed();
+        std::shared_ptr<const ConfigSnapshot> loadConfig() const;
+        const ConfigSnapshot& activeConfig();
+        const ConfigSnapshot& producerConfig() const;
+        std::string_view contextPrefix(const ConfigSnapshot& config) const; // LogContext.cpp
+        void formatMessage(std::string& out, std::string_view context, std::string_view message,
+                           LogLevel level, const std::chrono::system_clock::time_point& timestamp,
+                           const ConfigSnapshot& config) const;
+        size_t formatTimestamp(char* buffer, size_t size,
+                               const std::chrono::system_clock::time_point& timestamp,
+                               const ConfigSnapshot& config) const;
+        bool writeTextBatch(const std::string_view* records, const LogLevel* levels, size_t count);
+        bool writeFormattedBatch();
+        bool combinedWrite(std::string_view formattedMessage, LogLevel level, bool binary = false);
+        bool logStaged(std::string& staged, LogLevel level);
+        bool dispatchAsync(std::string_view context, std::string_view payload, LogLevel level,
+                           const std::chrono::system_clock::time_point& timestamp,
+                           bool binary, bool& queued);
+        bool writeBinaryRecord(std::string_view staged);
+        bool emergencyRecord(const LogRecord& record) noexcept;
+        void setCrashFlush(bool enable);    // CrashHandler.cpp: crash handler registry
+        void fanOut(std::string_view formattedMessage, LogLevel level);
+        bool flushLanes();
+        void drainPendingWrites();
+        bool enqueueRecord(std::string_view context, std::string_view payload, LogLevel level,
+                           const std::chrono::system_clock::time_point& timestamp, bool binary);
+        bool shouldFlush(LogLevel level);
+        void recordDrop(LogLevel level);
+        void setError(LoggingError error, const std::string& message);
         void startAsyncWorker();
         void stopAsyncWorker();
         void asyncWorkerLoop();
 
     public:
         Logger(const std::string& filename, LogLevel defaultLevel = LogLevel::INFO);
+        Logger(const std::string& filename, const LoggerConfig& config);
         Logger(const std::string& host, int port, LogLevel defaultLevel = LogLevel::INFO);
-        Logger(const LoggerConfig& config);
+        Logger(const std::string& host, int port, const LoggerConfig& config);
+        Logger(const LoggerConfig& config);  // sink from config.filename or config.host/port
+        Logger(std::unique_ptr<LogOutput> output, const LoggerConfig& config);
         
         ~Logger();
 
@@ -230,8 +1084,46 @@ namespace logging {
         Logger(Logger&&) = default;
         Logger& operator=(Logger&&) = default;
 
-        bool log(const std::string& message, LogLevel level);
-        bool log(const std::string& message);
+        bool log(std::string_view message, LogLevel level);
+        bool log(std::string_view message);
+        
+        // Форматированная запись: "{}" в format заменяются аргументами.
+        // Аргументы форматируются только если уровень проходит фильтр,
+        // в переиспользуемый буфер потока.
+        template<typename... Args>
+        bool log(LogLevel level, std::string_view format, const Args&... args) {
+            if (!isLevelEnabled(level)) {
+                countFiltered(level);
+                return true;
+            }
+            std::string& buffer = detail::threadMessageBuffer();
+            const bool throttling = throttling_.load(std::memory_order_relaxed);
+            if (binary_records_.load(std::memory_order_relaxed)) {
+                // Двоичный режим: аргументы только упаковываются, текст собирает log_decode
+                binary::stageEvent(buffer, format, args...);
+                if (throttling && !admit(std::hash<std::string_view>{}(format),
+                                         std::hash<std::string_view>{}(buffer), level)) {
+                    return true;
+                }
+                return logStaged(buffer, level);
+            }
+            buffer.clear();
+            detail::formatTo(buffer, format, args...);
+            // Ограничение частоты считается по строке формата, то есть по месту вызова
+            if (throttling && !admit(std::hash<std::string_view>{}(format),
+                                     std::hash<std::string_view>{}(buffer), level)) {
+                return true;
+            }
+            return logMessage(buffer, level);
+        }
+        
+        // Проверка уровня без блокировок: одна relaxed-загрузка
+        bool isLevelEnabled(LogLevel level) const {
+            return static_cast<int>(level) >= static_cast<int>(defaultLevel_.load(std::memory_order_relaxed));
+        }
+        
+        // Дописывает очередь (в асинхронном режиме) и сбрасывает буфер вывода
+        bool flush();
         
         void setDefaultLevel(LogLevel level);
         LogLevel getDefaultLevel() const;
@@ -245,14 +1137,133 @@ namespace logging {
         void enableAsync(bool enable = true);
         bool isAsyncEnabled() const;
         
+        // Overflow statistics (records lost because the async queue was full)
+        uint64_t getDroppedCount(LogLevel level) const;
+        uint64_t getDroppedCount() const;
+        std::chrono::system_clock::time_point getLastDropTime(LogLevel level) const;
+        void resetDropCounters();
+
+        // Records not written because of rateLimitPerSecond or collapseRepeats
+        uint64_t getSuppressedCount() const;
+
+        // Live metrics (see LoggerStats); cheap enough to poll from a monitoring thread
+        LoggerStats getStats() const;
+
+        // Synchronously writes the async queue and the output buffers using only
+        // async-signal-safe calls (see LoggerConfig::flushOnCrash); for custom crash handlers.
+        // Pending flush() markers are dropped, so a thread blocked in flush() is not woken
+        bool emergencyFlush() noexcept;
+        // Counts a record skipped by the level check before log() (used by the LOG_* macros)
+        void countFiltered(LogLevel level);
+        
         // Configuration
         void setConfig(const LoggerConfig& config);
         LoggerConfig getConfig() const;
+        
+        // Fan-out: extra outputs receive the same formatted records (text format only),
+        // filtered by their own level and drained by their own thread. Indexes follow
+        // the order of addOutput calls.
+        bool addOutput(std::unique_ptr<LogOutput> output, LogLevel minLevel = LogLevel::TRACE);
+        size_t getOutputCount() const;
+        void setOutputLevel(size_t index, LogLevel level);
+        uint64_t getOutputDroppedCount(size_t index) const;
 
         // Extended helper methods
-        bool debug(const std::string& message) { return log(message, LogLevel::DEBUG); }
-        bool info(const std::string& message) { return log(message, LogLevel::INFO); }
-        bool warning(const std::string& message) { return log(message, LogLevel::WARNING); }
+        bool trace(std::string_view message) { return log(message, LogLevel::TRACE); }
+        bool debug(std::string_view message) { return log(message, LogLevel::DEBUG); }
+        bool info(std::string_view message) { return log(message, LogLevel::INFO); }
+        bool warning(std::string_view message) { return log(message, LogLevel::WARNING); }
+        bool error(std::string_view message) { return log(message, LogLevel::ERROR); }
+        bool fatal(std::string_view message) { return log(message, LogLevel::FATAL); }
+
+        template<typename Arg, typename... Args>
+        bool trace(std::string_view format, const Arg& arg, const Args&... args) {
+            return log(LogLevel::TRACE, format, arg, args...);
+        }
+        template<typename Arg, typename... Args>
+        bool debug(std::string_view format, const Arg& arg, const Args&... args) {
+            return log(LogLevel::DEBUG, format, arg, args...);
+        }
+        template<typename Arg, typename... Args>
+        bool info(std::string_view format, const Arg& arg, const Args&... args) {
+            return log(LogLevel::INFO, format, arg, args...);
+        }
+        template<typename Arg, typename... Args>
+        bool warning(std::string_view format, const Arg& arg, const Args&... args) {
+            return log(LogLevel::WARNING, format, arg, args...);
+        }
+        template<typename Arg, typename... Args>
+        bool error(std::string_view format, const Arg& arg, const Args&... args) {
+            return log(LogLevel::ERROR, format, arg, args...);
+        }
+        template<typename Arg, typename... Args>
+        bool fatal(std::string_view format, const Arg& arg, const Args&... args) {
+            return log(LogLevel::FATAL, format, arg, args...);
+        }
     };
 
-} 
+     // Process-wide named loggers for components created at startup. Loggers whose configs
+     // name the same sink (config.filename, or config.host:port) share one output and one
+     // drain thread (an OutputLane over a LazyOutput): the file is opened, or the socket
+     // created and connected in the background, by the first record that passes a level
+     // check, so registering dozens of loggers does no I/O. Each logger keeps its own level
+     // and settings; its name becomes the "logger=" context field unless config.loggerName
+     // is set. Sink options (rotation, buffering, reconnects, queue size) come from the
+     // config that created the sink. Callers format and queue records themselves, so
+     // enableAsync is ignored here and records are always text.
+    class LoggerRegistry {
+    public:
+        static LoggerRegistry& instance();
+
+        // The logger called name: created from config on the first call, later calls return
+        // the same logger and ignore config. nullptr if config names no sink
+        std::shared_ptr<Logger> get(const std::string& name, const LoggerConfig& config);
+        std::shared_ptr<Logger> find(const std::string& name) const;
+        // The registry forgets the logger; a sink closes with the last logger using it
+        void remove(const std::string& name);
+        void clear();
+        size_t size() const;
+        bool flushAll();
+
+    private:
+        mutable std::mutex mutex_;
+        std::unordered_map<std::string, std::shared_ptr<Logger>> loggers_;
+        std::unordered_map<std::string, std::weak_ptr<OutputLane>> sinks_; // by sink key
+    };
+
+    namespace detail {
+
+         // Выбор перегрузки для LOG_*: одна строка пишется как есть, с аргументами — форматируется
+        template<typename LoggerT>
+        bool logAt(LoggerT& logger, LogLevel level, std::string_view message) {
+            return logger.log(message, level);
+        }
+
+        template<typename LoggerT, typename Arg, typename... Args>
+        bool logAt(LoggerT& logger, LogLevel level, std::string_view format, const Arg& arg, const Args&... args) {
+            return logger.log(level, format, arg, args...);
+        }
+
+    }
+
+}
+
+ // Макросы логирования. Вызовы ниже LOGGING_ACTIVE_LEVEL не попадают в код вовсе,
+ // остальные вычисляют аргументы только после проверки уровня логгера.
+#define LOGGING_LOG_AT(logger, level, ...)                                       \
+    do {                                                                         \
+        if constexpr (::logging::isLevelCompiled(level)) {                       \
+            if ((logger).isLevelEnabled(level)) {                                \
+                ::logging::detail::logAt((logger), (level), __VA_ARGS__);        \
+            } else {                                                             \
+                (logger).countFiltered(level);                                   \
+            }                                                                    \
+        }                                                                        \
+    } while (0)
+
+#define LOG_TRACE(logger, ...)   LOGGING_LOG_AT(logger, ::logging::LogLevel::TRACE, __VA_ARGS__)
+#define LOG_DEBUG(logger, ...)   LOGGING_LOG_AT(logger, ::logging::LogLevel::DEBUG, __VA_ARGS__)
+#define LOG_INFO(logger, ...)    LOGGING_LOG_AT(logger, ::logging::LogLevel::INFO, __VA_ARGS__)
+#define LOG_WARNING(logger, ...) LOGGING_LOG_AT(logger, ::logging::LogLevel::WARNING, __VA_ARGS__)
+#define LOG_ERROR(logger, ...)   LOGGING_LOG_AT(logger, ::logging::LogLevel::ERROR, __VA_ARGS__)
+#define LOG_FATAL(logger, ...)   LOGGING_LOG_AT(logger, ::logging::LogLevel::FATAL, __VA_ARGS__)
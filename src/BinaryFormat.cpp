@@ -0,0 +1,237 @@
+#include "logging/Logger.h"
+#include <ctime>
+#include <cstring>
+
+namespace logging {
+
+    namespace {
+
+        // Кадр больше этого размера считается повреждением, а не длинной записью
+        constexpr size_t kMaxFrameSize = 64 * 1024 * 1024;
+
+        // Последовательное чтение полезной части кадра с проверкой границ
+        class PayloadReader {
+        private:
+            std::string_view data_;
+            bool ok_ = true;
+
+        public:
+            explicit PayloadReader(std::string_view data) : data_(data) {}
+
+            bool ok() const { return ok_; }
+
+            uint64_t integer(size_t bytes) {
+                if (!ok_ || data_.size() < bytes) {
+                    ok_ = false;
+                    return 0;
+                }
+                uint64_t value = binary::loadLE(data_.data(), bytes);
+                data_.remove_prefix(bytes);
+                return value;
+            }
+
+            std::string_view bytes(size_t count) {
+                if (!ok_ || data_.size() < count) {
+                    ok_ = false;
+                    return std::string_view();
+                }
+                std::string_view value = data_.substr(0, count);
+                data_.remove_prefix(count);
+                return value;
+            }
+        };
+
+        // Один аргумент события в тексте, так же как его вывел бы detail::appendArg
+        bool appendEncodedArg(std::string& out, PayloadReader& reader) {
+            auto type = static_cast<binary::ArgType>(reader.integer(1));
+            switch (type) {
+                case binary::ArgType::INT:
+                    detail::appendArg(out, static_cast<int64_t>(reader.integer(8)));
+                    break;
+                case binary::ArgType::UINT:
+                    detail::appendArg(out, reader.integer(8));
+                    break;
+                case binary::ArgType::FLOAT: {
+                    uint32_t bits = static_cast<uint32_t>(reader.integer(4));
+                    float value;
+                    std::memcpy(&value, &bits, sizeof(value));
+                    detail::appendArg(out, value);
+                    break;
+                }
+                case binary::ArgType::DOUBLE: {
+                    uint64_t bits = reader.integer(8);
+                    double value;
+                    std::memcpy(&value, &bits, sizeof(value));
+                    detail::appendArg(out, value);
+                    break;
+                }
+                case binary::ArgType::STRING: {
+                    size_t length = static_cast<size_t>(reader.integer(4));
+                    out.append(reader.bytes(length));
+                    break;
+                }
+                case binary::ArgType::BOOL:
+                    detail::appendArg(out, reader.integer(1) != 0);
+                    break;
+                case binary::ArgType::CHAR:
+                    out.push_back(static_cast<char>(reader.integer(1)));
+                    break;
+                case binary::ArgType::POINTER:
+                    detail::appendArg(out, reinterpret_cast<const void*>(
+                        static_cast<std::uintptr_t>(reader.integer(8))));
+                    break;
+                default:
+                    return false;
+            }
+            return reader.ok();
+        }
+
+    }
+
+    // BinaryLogDecoder implementation
+    BinaryLogDecoder::BinaryLogDecoder(std::string timestampFormat, TimestampPrecision precision)
+        : timestamp_format_(std::move(timestampFormat)), precision_(precision) {
+    }
+
+    void BinaryLogDecoder::append(std::string_view data) {
+        // Разобранное начало буфера отбрасываем, чтобы он не рос бесконечно
+        if (offset_ > 0 && offset_ >= buffer_.size() / 2) {
+            buffer_.erase(0, offset_);
+            offset_ = 0;
+        }
+        buffer_.append(data);
+    }
+
+    BinaryLogDecoder::Status BinaryLogDecoder::next(Record& record) {
+        for (;;) {
+            std::string_view available(buffer_.data() + offset_, buffer_.size() - offset_);
+            if (available.size() < binary::kFrameHeaderSize) {
+                return Status::NEED_MORE;
+            }
+
+            uint8_t tag = static_cast<uint8_t>(available[0]);
+            size_t payloadSize = static_cast<size_t>(binary::loadLE(available.data() + 1, 4));
+            if (payloadSize > kMaxFrameSize) {
+                return Status::CORRUPT;
+            }
+            if (available.size() < binary::kFrameHeaderSize + payloadSize) {
+                return Status::NEED_MORE;
+            }
+
+            std::string_view payload = available.substr(binary::kFrameHeaderSize, payloadSize);
+            offset_ += binary::kFrameHeaderSize + payloadSize;
+
+            switch (tag) {
+                case binary::kStreamTag: {
+                    // Новый поток: определения форматов предыдущего больше не действуют
+                    const size_t magicSize = sizeof(binary::kStreamMagic) - 1;
+                    if (payload.size() < magicSize + 1 ||
+                        payload.substr(0, magicSize) != std::string_view(binary::kStreamMagic, magicSize) ||
+                        static_cast<uint8_t>(payload[magicSize]) > binary::kVersion) {
+                        return Status::CORRUPT;
+                    }
+                    formats_.clear();
+                    break;
+                }
+                case binary::kFormatTag: {
+                    if (payload.size() < 8) {
+                        return Status::CORRUPT;
+                    }
+                    formats_[binary::loadLE(payload.data(), 8)] = std::string(payload.substr(8));
+                    break;
+                }
+                case binary::kEventTag:
+                    return decodeEvent(payload, record) ? Status::RECORD : Status::CORRUPT;
+                default:
+                    break; // неизвестный кадр пропускается
+            }
+        }
+    }
+
+    bool BinaryLogDecoder::decodeEvent(std::string_view payload, Record& record) const {
+        PayloadReader reader(payload);
+        uint64_t level = reader.integer(1);
+        int64_t ticks = static_cast<int64_t>(reader.integer(8));
+        uint64_t id = reader.integer(8);
+        size_t argCount = static_cast<size_t>(reader.integer(2));
+        if (!reader.ok() || level >= kLogLevelCount) {
+            return false;
+        }
+
+        record.level = static_cast<LogLevel>(level);
+        record.timestamp = std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(ticks)));
+        record.message.clear();
+
+        std::string_view format;
+        if (id != binary::kPlainMessageId) {
+            auto it = formats_.find(id);
+            if (it == formats_.end()) {
+                // Определение потеряно (например, журнал обрезан): выводим аргументы как есть
+                record.message.append("<unknown format>");
+                for (size_t i = 0; i < argCount; ++i) {
+                    record.message.push_back(' ');
+                    if (!appendEncodedArg(record.message, reader)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            format = it->second;
+        }
+
+        for (size_t i = 0; i < argCount; ++i) {
+            if (id != binary::kPlainMessageId && !detail::appendUntilPlaceholder(record.message, format)) {
+                // Лишние аргументы игнорируются, как в detail::formatTo
+                std::string ignored;
+                if (!appendEncodedArg(ignored, reader)) {
+                    return false;
+                }
+                continue;
+            }
+            if (!appendEncodedArg(record.message, reader)) {
+                return false;
+            }
+        }
+        if (id != binary::kPlainMessageId) {
+            detail::formatTo(record.message, format);
+        }
+        return true;
+    }
+
+    void BinaryLogDecoder::render(std::string& out, const Record& record) const {
+        auto sinceEpoch = std::chrono::duration_cast<std::chrono::microseconds>(
+            record.timestamp.time_since_epoch()).count();
+        int64_t second = sinceEpoch / 1000000;
+        int64_t micros = sinceEpoch % 1000000;
+        if (micros < 0) {
+            micros += 1000000;
+            second -= 1;
+        }
+
+        std::time_t time = static_cast<std::time_t>(second);
+        std::tm tm{};
+        localtime_r(&time, &tm);
+        char prefix[128];
+        size_t prefixLen = std::strftime(prefix, sizeof(prefix), timestamp_format_.c_str(), &tm);
+
+        out.push_back('[');
+        out.append(prefix, prefixLen);
+        int digits = static_cast<int>(precision_);
+        if (digits > 0) {
+            char fraction[8];
+            int64_t value = digits == 3 ? micros / 1000 : micros;
+            for (int i = digits - 1; i >= 0; --i) {
+                fraction[i] = static_cast<char>('0' + value % 10);
+                value /= 10;
+            }
+            out.push_back('.');
+            out.append(fraction, static_cast<size_t>(digits));
+        }
+        out.append("] [", 3);
+        out.append(logLevelToString(record.level));
+        out.append("] ", 2);
+        out.append(record.message);
+    }
+
+}
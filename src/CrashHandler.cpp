@@ -0,0 +1,373 @@
+#include "logging/Logger.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <cerrno>
+#include <csignal>
+#include <ctime>
+#include <unistd.h>
+
+namespace logging {
+
+    namespace {
+
+        // Аварийный сброс при фатальных сигналах и std::terminate.
+        // В обработчике сигнала допустимы только async-signal-safe вызовы: записи
+        // форматируются вручную в статический буфер, выводы пишут их write/send/pwrite.
+        // Единственное исключение — try_lock мьютексов (pthread_mutex_trylock никогда не ждёт).
+
+        constexpr int kFatalSignals[] = {SIGSEGV, SIGABRT, SIGBUS, SIGFPE, SIGILL};
+        constexpr size_t kFatalSignalCount = sizeof(kFatalSignals) / sizeof(kFatalSignals[0]);
+
+        // Логгеры с flushOnCrash; ячейки меняются атомарно, обработчик читает их без блокировок
+        constexpr size_t kMaxCrashLoggers = 32;
+        std::atomic<Logger*> crashLoggers[kMaxCrashLoggers];
+
+        // Сколько раз (по 1 мс) ждать мьютекс пишущего, прежде чем писать без него:
+        // если упал сам пишущий поток, мьютекс уже не освободится
+        constexpr int kLockAttempts = 100;
+
+        // Сколько миллисекунд ждать рабочий поток, извлекающий запись из очереди
+        constexpr int kWorkerPopAttempts = 10;
+
+        // Запись в текстовом формате логгера; длиннее — обрезается
+        constexpr size_t kCrashRecordSize = 64 * 1024;
+        char crashRecord[kCrashRecordSize];
+        std::atomic<bool> crashRecordBusy{false};
+
+        // 0 — сброса не было, 1 — идёт, 2 — завершён
+        std::atomic<int> crashState{0};
+
+        struct sigaction previousActions[kFatalSignalCount];
+        std::terminate_handler previousTerminate = nullptr;
+        long utcOffsetSeconds = 0;          // часовой пояс на момент установки обработчиков
+        char alternateStack[64 * 1024];     // для SIGSEGV при переполнении стека
+        std::once_flag installOnce;
+
+        // Имя уровня без std::string (logLevelToString выделяет память)
+        std::string_view levelName(LogLevel level) {
+            switch (level) {
+                case LogLevel::TRACE:   return "TRACE";
+                case LogLevel::DEBUG:   return "DEBUG";
+                case LogLevel::INFO:    return "INFO";
+                case LogLevel::WARNING: return "WARNING";
+                case LogLevel::ERROR:   return "ERROR";
+                case LogLevel::FATAL:   return "FATAL";
+                default:                return "UNKNOWN";
+            }
+        }
+
+        void pauseMillisecond() {
+            struct timespec pause{0, 1000000L};
+            nanosleep(&pause, nullptr);
+        }
+
+        // Статический буфер записи используется одним сбросом за раз
+        class CrashRecordScope {
+        public:
+            CrashRecordScope() {
+                for (int attempt = 0; crashRecordBusy.exchange(true, std::memory_order_acquire); ++attempt) {
+                    if (attempt >= kLockAttempts * 20) {
+                        break; // другой сброс не завершился за 2 с: пишем поверх
+                    }
+                    pauseMillisecond();
+                }
+            }
+            ~CrashRecordScope() { crashRecordBusy.store(false, std::memory_order_release); }
+        };
+
+        class RecordWriter {
+        private:
+            size_t used_ = 0;
+
+        public:
+            void append(const char* data, size_t size) {
+                size = std::min(size, kCrashRecordSize - used_);
+                std::memcpy(crashRecord + used_, data, size);
+                used_ += size;
+            }
+            void append(std::string_view data) { append(data.data(), data.size()); }
+            void appendNumber(uint64_t value, int width) {
+                char digits[20];
+                int count = 0;
+                do {
+                    digits[count++] = static_cast<char>('0' + value % 10);
+                    value /= 10;
+                } while (value > 0 && count < 20);
+                for (int i = count; i < width; ++i) {
+                    append("0", 1);
+                }
+                while (count > 0) {
+                    append(&digits[--count], 1);
+                }
+            }
+            bool fits(size_t size) const { return used_ + size <= kCrashRecordSize; }
+            char* reserve(size_t size) {
+                char* start = crashRecord + used_;
+                used_ += size;
+                return start;
+            }
+            std::string_view view() const { return std::string_view(crashRecord, used_); }
+        };
+
+        // Метка времени формата по умолчанию "%Y-%m-%d %H:%M:%S.mmm" без localtime_r:
+        // смещение часового пояса запомнено при установке обработчиков
+        void appendTimestamp(RecordWriter& out, int64_t sinceEpochNs) {
+            int64_t millis = sinceEpochNs / 1000000 + static_cast<int64_t>(utcOffsetSeconds) * 1000;
+            int64_t seconds = millis / 1000;
+            millis %= 1000;
+            if (millis < 0) {
+                millis += 1000;
+                seconds -= 1;
+            }
+            int64_t days = seconds / 86400;
+            int64_t daySeconds = seconds % 86400;
+            if (daySeconds < 0) {
+                daySeconds += 86400;
+                days -= 1;
+            }
+
+            // Гражданская дата из числа дней с 1970-01-01 (алгоритм Хиннанта)
+            days += 719468;
+            const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+            const int64_t dayOfEra = days - era * 146097;
+            const int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+            const int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+            const int64_t monthIndex = (5 * dayOfYear + 2) / 153;
+            const int64_t day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+            const int64_t month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+            const int64_t year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+
+            out.appendNumber(static_cast<uint64_t>(year), 4);
+            out.append("-", 1);
+            out.appendNumber(static_cast<uint64_t>(month), 2);
+            out.append("-", 1);
+            out.appendNumber(static_cast<uint64_t>(day), 2);
+            out.append(" ", 1);
+            out.appendNumber(static_cast<uint64_t>(daySeconds / 3600), 2);
+            out.append(":", 1);
+            out.appendNumber(static_cast<uint64_t>(daySeconds / 60 % 60), 2);
+            out.append(":", 1);
+            out.appendNumber(static_cast<uint64_t>(daySeconds % 60), 2);
+            out.append(".", 1);
+            out.appendNumber(static_cast<uint64_t>(millis), 3);
+        }
+
+        void flushRegisteredLoggers() {
+            int expected = 0;
+            if (!crashState.compare_exchange_strong(expected, 1)) {
+                // Сброс уже идёт в другом потоке (или это abort() после terminate): ждём его
+                for (int attempt = 0; attempt < kLockAttempts * 20 && crashState.load() == 1; ++attempt) {
+                    pauseMillisecond();
+                }
+                return;
+            }
+            for (auto& slot : crashLoggers) {
+                Logger* logger = slot.load(std::memory_order_acquire);
+                if (logger) {
+                    logger->emergencyFlush();
+                }
+            }
+            crashState.store(2);
+        }
+
+        void onFatalSignal(int signo) {
+            const int savedErrno = errno;
+            flushRegisteredLoggers();
+
+            // Прежний обработчик (или действие по умолчанию с дампом памяти) получает
+            // сигнал повторно, как только этот обработчик вернёт управление
+            for (size_t i = 0; i < kFatalSignalCount; ++i) {
+                if (kFatalSignals[i] == signo) {
+                    sigaction(signo, &previousActions[i], nullptr);
+                }
+            }
+            errno = savedErrno;
+            raise(signo);
+        }
+
+        void onTerminate() {
+            flushRegisteredLoggers();
+            if (previousTerminate) {
+                previousTerminate();
+            }
+            std::abort();
+        }
+
+        void installHandlers() {
+            std::time_t now = std::time(nullptr);
+            std::tm local{};
+            if (localtime_r(&now, &local)) {
+                utcOffsetSeconds = local.tm_gmtoff;
+            }
+
+            // Запасной стек только для потока, включившего flushOnCrash
+            stack_t current{};
+            if (sigaltstack(nullptr, &current) == 0 && (current.ss_flags & SS_DISABLE)) {
+                stack_t stack{};
+                stack.ss_sp = alternateStack;
+                stack.ss_size = sizeof(alternateStack);
+                sigaltstack(&stack, nullptr);
+            }
+
+            struct sigaction action{};
+            action.sa_handler = onFatalSignal;
+            sigemptyset(&action.sa_mask);
+            action.sa_flags = SA_ONSTACK;
+            for (size_t i = 0; i < kFatalSignalCount; ++i) {
+                if (sigaction(kFatalSignals[i], &action, &previousActions[i]) != 0) {
+                    std::cerr << "Ошибка установки обработчика сигнала " << kFatalSignals[i] << std::endl;
+                }
+            }
+            previousTerminate = std::set_terminate(onTerminate);
+        }
+
+    }
+
+    void Logger::setCrashFlush(bool enable) {
+        if (enable) {
+            std::call_once(installOnce, installHandlers);
+        }
+        for (auto& slot : crashLoggers) {
+            if (slot.load(std::memory_order_acquire) == this) {
+                if (!enable) {
+                    slot.store(nullptr, std::memory_order_release);
+                }
+                return;
+            }
+        }
+        if (!enable) {
+            return;
+        }
+        for (auto& slot : crashLoggers) {
+            Logger* expected = nullptr;
+            if (slot.compare_exchange_strong(expected, this, std::memory_order_acq_rel)) {
+                return;
+            }
+        }
+        std::cerr << "Предупреждение: flushOnCrash включён более чем у " << kMaxCrashLoggers
+                  << " логгеров, аварийный сброс для этого логгера не выполняется" << std::endl;
+    }
+
+    bool Logger::emergencyFlush() noexcept {
+        CrashRecordScope scope;
+
+        // С мьютексом рабочий поток не пишет одновременно с нами; если мьютекс держит
+        // упавший поток, пишем без него
+        bool locked = false;
+        for (int attempt = 0; attempt < kLockAttempts; ++attempt) {
+            if (mutex_.try_lock()) {
+                locked = true;
+                break;
+            }
+            pauseMillisecond();
+        }
+
+        // Сначала буферы выводов (записи в них старше очереди), затем очереди
+        bool ok = output_ && output_->emergencyWrite(nullptr, 0, false);
+        for (auto& lane : lanes_) {
+            ok = lane->emergencyDrain() && ok;
+        }
+        // Запись, уже извлечённая рабочим потоком, который ждёт мьютекс, старше очереди.
+        // Если поток как раз внутри pop(), даём ему закончить; второй раз смотрим после
+        // очереди на случай, если pop() ждал пустую очередь и получил запись позже
+        auto takeWorkerRecord = [&] {
+            if (!locked) {
+                return;
+            }
+            WorkerState state = worker_state_.load(std::memory_order_acquire);
+            for (int attempt = 0; attempt < kWorkerPopAttempts && state == WorkerState::POPPING; ++attempt) {
+                pauseMillisecond();
+                state = worker_state_.load(std::memory_order_acquire);
+            }
+            if (state != WorkerState::HOLDING ||
+                !worker_state_.compare_exchange_strong(state, WorkerState::TAKEN, std::memory_order_acq_rel)) {
+                return;
+            }
+            // Маркер flush() пропускается: promise::set_value() берёт мьютекс и будит
+            // condvar, это не async-signal-safe, а ждущего будить незачем — процесс завершается
+            LogRecord* held = worker_record_.load(std::memory_order_acquire);
+            if (!held->flushBarrier) {
+                ok = emergencyRecord(*held) && ok;
+            }
+        };
+        AsyncQueue<LogRecord>* queue = async_queue_.get();
+        if (output_ && queue) {
+            takeWorkerRecord();
+            while (queue->tryConsume([&](LogRecord& record) {
+                if (!record.flushBarrier) {
+                    ok = emergencyRecord(record) && ok;
+                }
+            })) {
+            }
+            takeWorkerRecord();
+        }
+
+        if (locked) {
+            mutex_.unlock();
+        }
+        return ok;
+    }
+
+    bool Logger::emergencyRecord(const LogRecord& record) noexcept {
+        // Вызывается из emergencyFlush: запись очереди в crashRecord и сразу выводам
+        const int64_t timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            record.timestamp.time_since_epoch()).count();
+        const std::string_view payload = record.message.view();
+        RecordWriter out;
+
+        if (record.binary) {
+            // Та же раскладка, что у writeBinaryRecord; определение формата пишется повторно,
+            // если его нет в файле (в binary_formats_ здесь не добавляем: это выделение памяти)
+            const size_t eventOffset = binary::stagedEventOffset(payload);
+            std::string_view format = payload.substr(4, eventOffset - 4);
+            std::string_view event = payload.substr(eventOffset);
+            uint64_t id = binary::loadLE(event.data() + binary::kFrameHeaderSize + 1 + 8, 8);
+            const size_t magicSize = sizeof(binary::kStreamMagic) - 1;
+            const bool header = !binary_stream_started_;
+            const bool definition = id != binary::kPlainMessageId && binary_formats_.count(id) == 0;
+            const size_t size = (header ? 5 + magicSize + 1 : 0) + (definition ? 5 + 8 + format.size() : 0) +
+                                event.size();
+            if (!out.fits(size)) {
+                return false;
+            }
+            if (header) {
+                char* frame = out.reserve(5);
+                frame[0] = static_cast<char>(binary::kStreamTag);
+                binary::storeLE(frame + 1, magicSize + 1, 4);
+                out.append(binary::kStreamMagic, magicSize);
+                const char version = static_cast<char>(binary::kVersion);
+                out.append(&version, 1);
+                binary_stream_started_ = true;
+            }
+            if (definition) {
+                char* frame = out.reserve(5 + 8);
+                frame[0] = static_cast<char>(binary::kFormatTag);
+                binary::storeLE(frame + 1, 8 + format.size(), 4);
+                binary::storeLE(frame + 5, id, 8);
+                out.append(format);
+            }
+            out.append(event);
+            std::string_view data = out.view();
+            return output_->emergencyWrite(&data, 1, true);
+        }
+
+        out.append("[", 1);
+        appendTimestamp(out, timestampNs);
+        out.append("] [", 3);
+        out.append(levelName(record.level));
+        out.append("] ", 2);
+        out.append(payload);
+
+        std::string_view text = out.view();
+        bool ok = output_->emergencyWrite(&text, 1, false);
+        for (auto& lane : lanes_) {
+            if (lane->accepts(record.level)) {
+                ok = lane->output().emergencyWrite(&text, 1, false) && ok;
+            }
+        }
+        return ok;
+    }
+
+}
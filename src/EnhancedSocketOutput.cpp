@@ -0,0 +1,431 @@
+#include "logging/Logger.h"
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <ctime>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+namespace logging {
+
+    namespace {
+
+        // Сколько деструктор ждёт отправки накопленных данных
+        constexpr std::chrono::milliseconds kShutdownDrainTimeout(1000);
+
+        // Ограничение ожидания в poll(), чтобы поток ввода-вывода видел остановку
+        constexpr int kPollTimeoutMs = 200;
+
+        // Аварийный сброс: сколько раз ждать в poll() заполненный сокет и поток ввода-вывода
+        constexpr int kEmergencyAttempts = 10;
+
+        // Сколько ждать ответа на приветствие кадрового протокола; старый сервер не отвечает
+        constexpr int kHandshakeTimeoutMs = 1000;
+        constexpr size_t kMaxReplySize = 64;
+
+        // Отправка из обработчика сигнала: только send/poll и ограниченное ожидание
+        bool emergencySend(int fd, std::string_view data) {
+            int stalls = 0;
+            while (!data.empty()) {
+                ssize_t result = send(fd, data.data(), data.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+                if (result > 0) {
+                    data.remove_prefix(static_cast<size_t>(result));
+                    continue;
+                }
+                if (result < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && ++stalls <= kEmergencyAttempts) {
+                    struct pollfd pfd{fd, POLLOUT, 0};
+                    poll(&pfd, 1, kPollTimeoutMs / 2);
+                    continue;
+                }
+                return false;
+            }
+            return true;
+        }
+
+    }
+
+    // EnhancedSocketOutput implementation
+    EnhancedSocketOutput::EnhancedSocketOutput(const std::string& host, int port,
+                                               int reconnect_interval_ms, int max_reconnect_attempts,
+                                               size_t max_buffer_bytes, bool compress,
+                                               bool connect_in_background)
+        : socket_fd_(-1), host_(host), port_(port), connected_(false), reconnecting_(false),
+          reconnect_interval_ms_(std::max(reconnect_interval_ms, 1)),
+          max_reconnect_attempts_(max_reconnect_attempts),
+          max_buffer_bytes_(max_buffer_bytes), compress_(compress) {
+        if (compress_ && !framed::compressionAvailable()) {
+            std::cerr << "Предупреждение: библиотека собрана без zlib, кадры передаются без сжатия" << std::endl;
+        }
+        // Первая попытка синхронная, дальше переподключается поток ввода-вывода.
+        // В фоне подключается сразу поток ввода-вывода, записи до этого копятся в pending_
+        connected_ = !connect_in_background && connect();
+        if (!connected_ && !connect_in_background) {
+            std::cerr << "Ошибка подключения к " << host_ << ":" << port_
+                      << ", сообщения буферизуются до переподключения" << std::endl;
+        }
+        reconnect_thread_ = std::thread(&EnhancedSocketOutput::reconnectLoop, this);
+    }
+
+    EnhancedSocketOutput::~EnhancedSocketOutput() {
+        waitDrained(kShutdownDrainTimeout);
+        {
+            std::lock_guard<std::mutex> lock(reconnect_mutex_);
+            stopping_ = true;
+        }
+        io_cv_.notify_all();
+        if (reconnect_thread_.joinable()) {
+            reconnect_thread_.join();
+        }
+        disconnect();
+    }
+
+    bool EnhancedSocketOutput::connect() {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct sockaddr_in server_addr{};
+        server_addr.sin_family = AF_INET;
+        server_addr.sin_port = htons(port_);
+        if (inet_pton(AF_INET, host_.c_str(), &server_addr.sin_addr) <= 0) {
+            close(fd);
+            return false;
+        }
+
+        if (::connect(fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+            if (errno != EINPROGRESS) {
+                close(fd);
+                return false;
+            }
+
+            // Неблокирующее подключение: ждём готовности не дольше интервала переподключения
+            struct pollfd pfd{fd, POLLOUT, 0};
+            int timeoutMs = std::min(reconnect_interval_ms_, 5000);
+            int error = 0;
+            socklen_t length = sizeof(error);
+            if (poll(&pfd, 1, timeoutMs) <= 0 ||
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0) {
+                close(fd);
+                return false;
+            }
+        }
+
+        // Кодировщик нового соединения начинает поток deflate заново
+        encoder_.reset();
+        if (compress_ && !negotiate(fd)) {
+            close(fd);
+            return false;
+        }
+
+        socket_fd_ = fd;
+        return true;
+    }
+
+    bool EnhancedSocketOutput::negotiate(int fd) {
+        // Приветствие и ответ — по строке. Ответа нет (сервер без кадрового протокола) —
+        // соединение остаётся текстовым; false только при ошибке самого соединения
+        const std::string hello = framed::helloLine(true);
+        size_t sent = 0;
+        while (sent < hello.size()) {
+            ssize_t result = send(fd, hello.data() + sent, hello.size() - sent, MSG_NOSIGNAL);
+            if (result > 0) {
+                sent += static_cast<size_t>(result);
+                continue;
+            }
+            if (result < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+                struct pollfd pfd{fd, POLLOUT, 0};
+                if (poll(&pfd, 1, kHandshakeTimeoutMs) <= 0) {
+                    return false;
+                }
+                continue;
+            }
+            return false;
+        }
+
+        std::string reply;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kHandshakeTimeoutMs);
+        while (reply.size() < kMaxReplySize) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            struct pollfd pfd{fd, POLLIN, 0};
+            if (left <= 0 || poll(&pfd, 1, static_cast<int>(left)) == 0) {
+                std::cerr << "Сервер " << host_ << ":" << port_
+                          << " не ответил на приветствие кадрового протокола, данные идут текстом" << std::endl;
+                return true;
+            }
+            char c;
+            ssize_t result = recv(fd, &c, 1, 0);
+            if (result < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+                continue;
+            }
+            if (result <= 0) {
+                return false;
+            }
+            if (c == '\n') {
+                break;
+            }
+            reply.push_back(c);
+        }
+
+        framed::Codec codec;
+        if (framed::parseReply(reply, codec)) {
+            encoder_ = std::make_unique<framed::FrameEncoder>(codec);
+        }
+        return true;
+    }
+
+    bool EnhancedSocketOutput::isFramed() const {
+        std::lock_guard<std::mutex> lock(reconnect_mutex_);
+        return connected_ && encoder_ != nullptr;
+    }
+
+    void EnhancedSocketOutput::disconnect() {
+        if (socket_fd_ >= 0) {
+            close(socket_fd_);
+            socket_fd_ = -1;
+        }
+        connected_ = false;
+    }
+
+    bool EnhancedSocketOutput::sendAll(const std::string& data, size_t& sent) {
+        while (sent < data.size()) {
+            ssize_t result = send(socket_fd_, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (result > 0) {
+                sent += static_cast<size_t>(result);
+                continue;
+            }
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                // Буфер сокета заполнен: ждём, пока получатель разберёт данные
+                struct pollfd pfd{socket_fd_, POLLOUT, 0};
+                int ready = poll(&pfd, 1, kPollTimeoutMs);
+                if (ready < 0 && errno != EINTR) {
+                    return false;
+                }
+                if (ready > 0 && (pfd.revents & (POLLERR | POLLHUP))) {
+                    return false;
+                }
+                if (ready == 0 && stopping_) {
+                    return false;
+                }
+                continue;
+            }
+            return false;
+        }
+        return true;
+    }
+
+    void EnhancedSocketOutput::reconnectLoop() {
+        int failedAttempts = 0;
+        std::string sending;
+        std::unique_lock<std::mutex> lock(reconnect_mutex_);
+
+        while (!stopping_) {
+            if (!connected_) {
+                reconnecting_ = true;
+                drained_cv_.notify_all();
+                lock.unlock();
+                bool ok = connect();
+                lock.lock();
+
+                if (ok) {
+                    connected_ = true;
+                    reconnecting_ = false;
+                    failedAttempts = 0;
+                    continue;
+                }
+                if (max_reconnect_attempts_ > 0 && ++failedAttempts >= max_reconnect_attempts_) {
+                    std::cerr << "Не удалось переподключиться к " << host_ << ":" << port_
+                              << " после " << failedAttempts << " попыток" << std::endl;
+                    gave_up_ = true;
+                    reconnecting_ = false;
+                    dropped_records_ += static_cast<uint64_t>(
+                        std::count(pending_.begin(), pending_.end(), '\n'));
+                    pending_.clear();
+                    drained_cv_.notify_all();
+                    break;
+                }
+                io_cv_.wait_for(lock, std::chrono::milliseconds(reconnect_interval_ms_),
+                                [this] { return stopping_.load(); });
+                continue;
+            }
+
+            io_cv_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+            if (pending_.empty()) {
+                continue;
+            }
+
+            // Забираем всё накопленное и отправляем одним куском вне блокировки.
+            // Буферы меняются местами, поэтому в установившемся режиме память не выделяется.
+            sending.swap(pending_);
+            in_flight_ = sending.size();
+            lock.unlock();
+
+            size_t sent = 0;
+            bool ok;
+            if (encoder_) {
+                // Кадры: пачка сжимается целиком, системных вызовов и байтов в сети меньше
+                wire_.clear();
+                boundaries_.clear();
+                ok = encoder_->encode(sending, wire_, boundaries_) && sendAll(wire_, sent);
+            } else {
+                ok = sendAll(sending, sent);
+            }
+
+            lock.lock();
+            in_flight_ = 0;
+            if (ok) {
+                payload_bytes_.fetch_add(sending.size(), std::memory_order_relaxed);
+                wire_bytes_.fetch_add(encoder_ ? wire_.size() : sending.size(), std::memory_order_relaxed);
+            } else {
+                // Повторяем с начала первой не полностью отправленной записи:
+                // получатель отбрасывает обрывок строки (или кадра) вместе со старым соединением
+                size_t restart = 0;
+                if (encoder_) {
+                    for (const auto& boundary : boundaries_) {
+                        if (boundary.wireEnd > sent) {
+                            break;
+                        }
+                        restart = boundary.textEnd;
+                    }
+                } else if (sent > 0) {
+                    restart = sending.rfind('\n', sent - 1);
+                    restart = restart == std::string::npos ? 0 : restart + 1;
+                }
+                pending_.insert(0, sending, restart, std::string::npos);
+                disconnect();
+            }
+            sending.clear();
+            if (pending_.empty()) {
+                drained_cv_.notify_all();
+            }
+        }
+
+        reconnecting_ = false;
+        drained_cv_.notify_all();
+    }
+
+    bool EnhancedSocketOutput::writeLog(std::string_view formattedMessage) {
+        std::lock_guard<std::mutex> lock(reconnect_mutex_);
+        if (gave_up_) {
+            return false;
+        }
+
+        // Ограниченный буфер: пока получатель недоступен, лишние записи отбрасываются
+        const size_t recordSize = formattedMessage.size() + 1;
+        if (pending_.size() + recordSize > max_buffer_bytes_) {
+            dropped_records_++;
+            return false;
+        }
+
+        bool wasEmpty = pending_.empty();
+        pending_.append(formattedMessage);
+        pending_.push_back('\n');
+        if (wasEmpty) {
+            io_cv_.notify_one();
+        }
+        return true;
+    }
+
+    bool EnhancedSocketOutput::writeBatch(const std::string_view* records, size_t count) {
+        // Вся пачка добавляется в буфер под одним захватом, поток ввода-вывода будится один раз
+        std::lock_guard<std::mutex> lock(reconnect_mutex_);
+        if (gave_up_) {
+            return false;
+        }
+
+        bool wasEmpty = pending_.empty();
+        bool ok = true;
+        for (size_t i = 0; i < count; ++i) {
+            const size_t recordSize = records[i].size() + 1;
+            if (pending_.size() + recordSize > max_buffer_bytes_) {
+                dropped_records_++;
+                ok = false;
+                continue;
+            }
+            pending_.append(records[i]);
+            pending_.push_back('\n');
+        }
+        if (wasEmpty && !pending_.empty()) {
+            io_cv_.notify_one();
+        }
+        return ok;
+    }
+
+    bool EnhancedSocketOutput::isValid() const {
+        return !gave_up_;
+    }
+
+    bool EnhancedSocketOutput::flush() {
+        // Данные уже переданы потоку ввода-вывода; здесь не ждём сеть
+        io_cv_.notify_one();
+        return connected_ && !gave_up_;
+    }
+
+    bool EnhancedSocketOutput::emergencyWrite(const std::string_view* records, size_t count, bool raw) noexcept {
+        // Пока поток ввода-вывода отправляет свой кусок, в сокет писать нельзя: строки
+        // перемешаются. Ждём его ограниченно через try_lock (не блокирует), затем шлём
+        // накопленное и записи сами
+        if (raw) {
+            return false;
+        }
+        bool locked = false;
+        for (int attempt = 0; attempt < kEmergencyAttempts; ++attempt) {
+            if (reconnect_mutex_.try_lock()) {
+                if (in_flight_ == 0) {
+                    locked = true;
+                    break;
+                }
+                reconnect_mutex_.unlock();
+            }
+            struct timespec pause{0, kPollTimeoutMs / 2 * 1000000L};
+            nanosleep(&pause, nullptr);
+        }
+        if (!locked) {
+            return false;
+        }
+
+        // В кадровом режиме — кадры без сжатия: deflate здесь недоступен, заголовок
+        // собирается на стеке
+        const bool frames = connected_ && encoder_ != nullptr;
+        auto sendText = [&](std::string_view text, bool newline) {
+            if (frames) {
+                char header[framed::kHeaderSize];
+                framed::storeHeader(header, text.size() + (newline ? 1 : 0), framed::Codec::NONE);
+                if (!emergencySend(socket_fd_, std::string_view(header, sizeof(header)))) {
+                    return false;
+                }
+            }
+            return emergencySend(socket_fd_, text) &&
+                   (!newline || emergencySend(socket_fd_, std::string_view("\n", 1)));
+        };
+        bool ok = connected_ && socket_fd_ >= 0 && (pending_.empty() || sendText(pending_, false));
+        if (ok) {
+            pending_.clear();
+            for (size_t i = 0; ok && i < count; ++i) {
+                ok = sendText(records[i], true);
+            }
+        }
+        reconnect_mutex_.unlock();
+        return ok;
+    }
+
+    bool EnhancedSocketOutput::waitDrained(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(reconnect_mutex_);
+        drained_cv_.wait_for(lock, timeout, [this] {
+            return (pending_.empty() && in_flight_ == 0) || gave_up_ || stopping_;
+        });
+        return pending_.empty() && in_flight_ == 0;
+    }
+
+}
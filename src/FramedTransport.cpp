@@ -0,0 +1,292 @@
+#include "logging/FramedTransport.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef LOGGING_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+namespace logging {
+namespace framed {
+
+    namespace {
+
+        // Уровень сжатия: быстрые уровни deflate, журнал сжимает пишущий поток вывода
+        constexpr int kDeflateLevel = 3;
+
+        // Защита от «бомб»: текст одного кадра не больше этого размера
+        constexpr size_t kMaxFrameOutput = 4 * kMaxFramePayload;
+
+        const char* codecName(Codec codec) {
+            return codec == Codec::DEFLATE ? "deflate" : "none";
+        }
+
+        // Есть ли name в списке через запятую
+        bool listed(std::string_view list, std::string_view name) {
+            while (!list.empty()) {
+                size_t comma = list.find(',');
+                if (list.substr(0, comma) == name) {
+                    return true;
+                }
+                list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+            }
+            return false;
+        }
+
+        uint64_t loadLE32(const char* source) {
+            uint64_t value = 0;
+            for (size_t i = 0; i < 4; ++i) {
+                value |= static_cast<uint64_t>(static_cast<uint8_t>(source[i])) << (8 * i);
+            }
+            return value;
+        }
+
+    }
+
+    bool compressionAvailable() {
+#ifdef LOGGING_HAS_ZLIB
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    std::string helloLine(bool compress) {
+        std::string line(kHelloPrefix);
+        line.append(compress && compressionAvailable() ? "deflate,none" : "none");
+        line.push_back('\n');
+        return line;
+    }
+
+    bool chooseCodec(std::string_view hello, Codec& codec) {
+        if (hello.substr(0, kHelloPrefix.size()) != kHelloPrefix) {
+            return false;
+        }
+        std::string_view offered = hello.substr(kHelloPrefix.size());
+        if (compressionAvailable() && listed(offered, "deflate")) {
+            codec = Codec::DEFLATE;
+            return true;
+        }
+        if (listed(offered, "none")) {
+            codec = Codec::NONE;
+            return true;
+        }
+        return false;
+    }
+
+    std::string replyLine(Codec codec) {
+        std::string line(kHelloPrefix);
+        line.append(codecName(codec));
+        line.push_back('\n');
+        return line;
+    }
+
+    bool parseReply(std::string_view reply, Codec& codec) {
+        if (reply.substr(0, kHelloPrefix.size()) != kHelloPrefix) {
+            return false;
+        }
+        std::string_view name = reply.substr(kHelloPrefix.size());
+        if (name == "deflate" && compressionAvailable()) {
+            codec = Codec::DEFLATE;
+            return true;
+        }
+        if (name == "none") {
+            codec = Codec::NONE;
+            return true;
+        }
+        return false;
+    }
+
+    // FrameEncoder implementation
+    struct FrameEncoder::Stream {
+#ifdef LOGGING_HAS_ZLIB
+        z_stream zs{};
+        bool ready = false;
+
+        Stream() {
+            ready = deflateInit2(&zs, kDeflateLevel, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+        }
+        ~Stream() {
+            if (ready) {
+                deflateEnd(&zs);
+            }
+        }
+#endif
+    };
+
+    FrameEncoder::FrameEncoder(Codec codec)
+        : codec_(codec == Codec::DEFLATE && compressionAvailable() ? Codec::DEFLATE : Codec::NONE) {
+        if (codec_ == Codec::DEFLATE) {
+            stream_ = std::make_unique<Stream>();
+        }
+    }
+
+    FrameEncoder::~FrameEncoder() = default;
+
+    bool FrameEncoder::encode(std::string_view text, std::string& out, std::vector<Boundary>& boundaries) {
+        size_t position = 0;
+        while (position < text.size()) {
+            // Кадр заканчивается на '\n': получатель всегда видит целые строки
+            size_t end = std::min(position + kMaxFrameText, text.size());
+            if (end < text.size()) {
+                size_t newline = text.rfind('\n', end - 1);
+                if (newline != std::string_view::npos && newline >= position) {
+                    end = newline + 1;
+                } else {
+                    newline = text.find('\n', end);
+                    end = newline == std::string_view::npos ? text.size() : newline + 1;
+                }
+            }
+            if (!appendFrame(text.substr(position, end - position), out)) {
+                return false;
+            }
+            boundaries.push_back(Boundary{out.size(), end});
+            position = end;
+        }
+        return true;
+    }
+
+    bool FrameEncoder::appendFrame(std::string_view text, std::string& out) {
+        const size_t header = out.size();
+        out.resize(header + kHeaderSize);
+
+        if (codec_ == Codec::NONE) {
+            out.append(text);
+        } else {
+#ifdef LOGGING_HAS_ZLIB
+            z_stream& zs = stream_->zs;
+            if (!stream_->ready) {
+                out.resize(header);
+                return false;
+            }
+            zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(text.data()));
+            zs.avail_in = static_cast<uInt>(text.size());
+            // Z_SYNC_FLUSH выравнивает сжатые данные по границе кадра, словарь сохраняется
+            do {
+                const size_t used = out.size();
+                const size_t room = std::max<size_t>(zs.avail_in / 2 + 64, 4096);
+                out.resize(used + room);
+                zs.next_out = reinterpret_cast<Bytef*>(&out[used]);
+                zs.avail_out = static_cast<uInt>(room);
+                int result = deflate(&zs, Z_SYNC_FLUSH);
+                out.resize(used + room - zs.avail_out);
+                if (result != Z_OK && result != Z_BUF_ERROR) {
+                    out.resize(header);
+                    return false;
+                }
+            } while (zs.avail_out == 0);
+#else
+            out.resize(header);
+            return false;
+#endif
+        }
+
+        const size_t payload = out.size() - header - kHeaderSize;
+        if (payload > kMaxFramePayload) {
+            out.resize(header);
+            return false;
+        }
+        storeHeader(&out[header], payload, codec_);
+        return true;
+    }
+
+    // FrameDecoder implementation
+    struct FrameDecoder::Stream {
+#ifdef LOGGING_HAS_ZLIB
+        z_stream zs{};
+        bool ready = false;
+
+        Stream() {
+            ready = inflateInit2(&zs, -15) == Z_OK;
+        }
+        ~Stream() {
+            if (ready) {
+                inflateEnd(&zs);
+            }
+        }
+#endif
+    };
+
+    FrameDecoder::FrameDecoder() = default;
+
+    FrameDecoder::~FrameDecoder() = default;
+
+    bool FrameDecoder::feed(const char* data, size_t size, std::string& out) {
+        wire_bytes_ += size;
+        // Обычно кадры разбираются прямо из входа; копируется только хвост незаконченного кадра
+        if (!partial_.empty()) {
+            partial_.append(data, size);
+            data = partial_.data();
+            size = partial_.size();
+        }
+
+        size_t position = 0;
+        while (size - position >= kHeaderSize) {
+            const size_t length = static_cast<size_t>(loadLE32(data + position));
+            if (length > kMaxFramePayload) {
+                return false;
+            }
+            if (size - position - kHeaderSize < length) {
+                break;
+            }
+            const Codec codec = static_cast<Codec>(data[position + 4]);
+            if (!decodeFrame(codec, data + position + kHeaderSize, length, out)) {
+                return false;
+            }
+            position += kHeaderSize + length;
+        }
+
+        if (!partial_.empty() && data == partial_.data()) {
+            partial_.erase(0, position);
+        } else {
+            partial_.assign(data + position, size - position);
+        }
+        return true;
+    }
+
+    bool FrameDecoder::decodeFrame(Codec codec, const char* payload, size_t size, std::string& out) {
+        if (codec == Codec::NONE) {
+            out.append(payload, size);
+            text_bytes_ += size;
+            return true;
+        }
+        if (codec != Codec::DEFLATE) {
+            return false;
+        }
+#ifdef LOGGING_HAS_ZLIB
+        if (!stream_) {
+            stream_ = std::make_unique<Stream>();
+        }
+        if (!stream_->ready) {
+            return false;
+        }
+        const size_t start = out.size();
+        z_stream& zs = stream_->zs;
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(payload));
+        zs.avail_in = static_cast<uInt>(size);
+        do {
+            const size_t used = out.size();
+            const size_t room = std::max<size_t>(size * 4, 16 * 1024);
+            out.resize(used + room);
+            zs.next_out = reinterpret_cast<Bytef*>(&out[used]);
+            zs.avail_out = static_cast<uInt>(room);
+            int result = inflate(&zs, Z_SYNC_FLUSH);
+            out.resize(used + room - zs.avail_out);
+            if ((result != Z_OK && result != Z_BUF_ERROR) || out.size() - start > kMaxFrameOutput) {
+                out.resize(start);
+                return false;
+            }
+        } while (zs.avail_out == 0);
+        if (zs.avail_in != 0) {
+            out.resize(start);
+            return false;
+        }
+        text_bytes_ += out.size() - start;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+}
+}
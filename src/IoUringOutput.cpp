@@ -0,0 +1,563 @@
+#include "logging/Logger.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#ifdef LOGGING_HAS_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+namespace logging {
+
+    namespace {
+
+        // Размер одного буфера, если буферизация в конфигурации выключена
+        constexpr size_t kDefaultBufferSize = 64 * 1024;
+
+        // Файл открывается без O_APPEND: смещение каждой отправки считаем сами,
+        // чтобы несколько буферов в полёте легли в файл по порядку
+        int openLogFile(const std::string& filename) {
+            int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+            if (fd < 0) {
+                std::cerr << "Ошибка: не удалось открыть файл журнала: " << filename << std::endl;
+            }
+            return fd;
+        }
+
+        int connectTo(const std::string& host, int port) {
+            int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd < 0) {
+                std::cerr << "Ошибка создания сокета" << std::endl;
+                return -1;
+            }
+
+            struct sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(static_cast<uint16_t>(port));
+            if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) <= 0) {
+                std::cerr << "Неверный адрес: " << host << std::endl;
+                close(fd);
+                return -1;
+            }
+            if (::connect(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0) {
+                std::cerr << "Ошибка подключения к " << host << ":" << port << std::endl;
+                close(fd);
+                return -1;
+            }
+            return fd;
+        }
+
+#ifdef LOGGING_HAS_IO_URING
+        // liburing не требуется: три системных вызова и кольца в общей памяти
+        int uringSetup(unsigned entries, struct io_uring_params* params) {
+            return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+        }
+
+        int uringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+            return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+        }
+
+        int uringRegister(int fd, unsigned opcode, const void* arg, unsigned count) {
+            return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+        }
+
+        // Нужные операции есть в ядре (IORING_REGISTER_PROBE появился вместе с ними, в 5.6)
+        bool probeOperations(int ringFd) {
+            constexpr unsigned kProbeOps = 64;
+            std::vector<char> storage(sizeof(struct io_uring_probe) + kProbeOps * sizeof(struct io_uring_probe_op));
+            auto* probe = reinterpret_cast<struct io_uring_probe*>(storage.data());
+            if (uringRegister(ringFd, IORING_REGISTER_PROBE, probe, kProbeOps) < 0) {
+                return false;
+            }
+            for (unsigned op : {IORING_OP_WRITE_FIXED, IORING_OP_WRITE, IORING_OP_SEND}) {
+                if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+#endif
+
+    }
+
+#ifdef LOGGING_HAS_IO_URING
+    // Кольца io_uring и буферы. Буферы заполняются и отправляются по кругу, поэтому
+    // их порядок совпадает с порядком данных; у файла отправляются все готовые буферы,
+    // у сокета — по одному (иначе короткая отправка перемешала бы байты в потоке).
+    struct IoUringOutput::Ring {
+        struct Buffer {
+            char* data = nullptr;
+            size_t used = 0;        // скопировано записей
+            size_t done = 0;        // принято ядром
+            uint64_t offset = 0;    // смещение data[0] в файле
+            bool queued = false;    // отправлен или ждёт отправки; заполнять нельзя
+            bool inFlight = false;
+        };
+
+        int target;                 // файл или сокет
+        bool socket;
+        int fd = -1;
+        void* sq_ring = MAP_FAILED;
+        size_t sq_ring_size = 0;
+        void* cq_ring = MAP_FAILED;
+        size_t cq_ring_size = 0;
+        struct io_uring_sqe* sqes = static_cast<struct io_uring_sqe*>(MAP_FAILED);
+        size_t sqes_size = 0;
+        unsigned* sq_tail = nullptr;
+        unsigned sq_mask = 0;
+        unsigned* sq_array = nullptr;
+        unsigned* cq_head = nullptr;
+        unsigned* cq_tail = nullptr;
+        unsigned cq_mask = 0;
+        struct io_uring_cqe* cqes = nullptr;
+
+        char* memory = static_cast<char*>(MAP_FAILED);
+        size_t memory_size = 0;
+        size_t capacity = 0;
+        Buffer buffers[kBufferCount];
+        size_t current = 0;         // заполняемый буфер
+        size_t next_send = 0;       // следующий буфер очереди на отправку
+        size_t in_flight = 0;
+        unsigned unsubmitted = 0;
+        uint64_t file_offset = 0;
+        bool registered = false;
+        std::atomic<bool> failed{false};    // записи больше не принимаются (isValid из других потоков)
+        bool broken = false;                // кольцо непригодно: завершений больше не дождаться
+        bool emergency = false;             // аварийный сброс: без iostream, ошибка — только в результате
+
+        Ring(int targetFd, bool isSocket) : target(targetFd), socket(isSocket) {}
+
+        ~Ring() {
+            // Ядро ещё может писать из буферов: дожидаемся их до освобождения памяти
+            while (fd >= 0 && in_flight > 0 && !broken) {
+                reap(true);
+            }
+            if (fd >= 0) {
+                close(fd);
+            }
+            if (memory != MAP_FAILED) {
+                munmap(memory, memory_size);
+            }
+            if (sqes != MAP_FAILED) {
+                munmap(sqes, sqes_size);
+            }
+            if (cq_ring != MAP_FAILED && cq_ring != sq_ring) {
+                munmap(cq_ring, cq_ring_size);
+            }
+            if (sq_ring != MAP_FAILED) {
+                munmap(sq_ring, sq_ring_size);
+            }
+        }
+
+        bool init(size_t bufferSize) {
+            struct io_uring_params params{};
+            fd = uringSetup(kBufferCount * 2, &params);
+            if (fd < 0) {
+                return false;
+            }
+
+            sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+            if (params.features & IORING_FEAT_SINGLE_MMAP) {
+                sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+            }
+            sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           fd, IORING_OFF_SQ_RING);
+            if (sq_ring == MAP_FAILED) {
+                return false;
+            }
+            cq_ring = (params.features & IORING_FEAT_SINGLE_MMAP)
+                ? sq_ring
+                : mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       fd, IORING_OFF_CQ_RING);
+            if (cq_ring == MAP_FAILED) {
+                return false;
+            }
+            sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+            sqes = static_cast<struct io_uring_sqe*>(mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+                                                          MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+            if (sqes == MAP_FAILED) {
+                return false;
+            }
+
+            char* sq = static_cast<char*>(sq_ring);
+            char* cq = static_cast<char*>(cq_ring);
+            sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            cqes = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+            // Память буферов закрепляется один раз; без регистрации (лимит memlock
+            // на старых ядрах) работаем обычными WRITE с теми же буферами
+            capacity = bufferSize;
+            const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            const size_t stride = (capacity + pageSize - 1) / pageSize * pageSize;
+            memory_size = stride * kBufferCount;
+            memory = static_cast<char*>(mmap(nullptr, memory_size, PROT_READ | PROT_WRITE,
+                                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+            if (memory == MAP_FAILED) {
+                return false;
+            }
+            struct iovec vectors[kBufferCount];
+            for (size_t i = 0; i < kBufferCount; ++i) {
+                buffers[i].data = memory + i * stride;
+                vectors[i].iov_base = buffers[i].data;
+                vectors[i].iov_len = capacity;
+            }
+            registered = uringRegister(fd, IORING_REGISTER_BUFFERS, vectors, kBufferCount) == 0;
+
+            if (!socket) {
+                off_t end = lseek(target, 0, SEEK_END);
+                file_offset = end > 0 ? static_cast<uint64_t>(end) : 0;
+            }
+            return true;
+        }
+
+        void prepare(size_t index) {
+            Buffer& buffer = buffers[index];
+            unsigned tail = *sq_tail;
+            unsigned slot = tail & sq_mask;
+            struct io_uring_sqe* sqe = &sqes[slot];
+            std::memset(sqe, 0, sizeof(*sqe));
+
+            sqe->fd = target;
+            sqe->addr = reinterpret_cast<uint64_t>(buffer.data + buffer.done);
+            sqe->len = static_cast<uint32_t>(buffer.used - buffer.done);
+            sqe->user_data = index;
+            if (socket) {
+                sqe->opcode = IORING_OP_SEND;
+                sqe->msg_flags = MSG_NOSIGNAL;
+            } else {
+                // IOSQE_ASYNC: копирование в страничный кэш выполняет поток ядра, а не вызывающий
+                sqe->opcode = registered ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+                sqe->buf_index = registered ? static_cast<uint16_t>(index) : 0;
+                sqe->off = buffer.offset + buffer.done;
+                sqe->flags = IOSQE_ASYNC;
+            }
+
+            sq_array[slot] = slot;
+            __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+            buffer.inFlight = true;
+            in_flight++;
+            unsubmitted++;
+        }
+
+        bool submit() {
+            while (unsubmitted > 0) {
+                int result = uringEnter(fd, unsubmitted, 0, 0);
+                if (result < 0) {
+                    if (errno == EINTR || errno == EAGAIN) {
+                        continue;
+                    }
+                    broken = true;
+                    fail(errno);
+                    return false;
+                }
+                unsubmitted -= std::min(unsubmitted, static_cast<unsigned>(result));
+            }
+            return true;
+        }
+
+        // Отправка готовых буферов по порядку
+        bool pump() {
+            while (buffers[next_send].queued && !buffers[next_send].inFlight && (!socket || in_flight == 0)) {
+                prepare(next_send);
+                next_send = (next_send + 1) % kBufferCount;
+            }
+            return submit();
+        }
+
+        void fail(int error) {
+            if (!failed && !emergency) {
+                std::cerr << "Ошибка записи через io_uring: " << std::strerror(error) << std::endl;
+            }
+            failed = true;
+            // Неотправленное теряется, как у закрытого сокета; буферы в полёте освободит reap
+            for (auto& buffer : buffers) {
+                if (!buffer.inFlight) {
+                    buffer.used = buffer.done = 0;
+                    buffer.queued = false;
+                }
+            }
+        }
+
+        // Разбор завершений; wait — дождаться хотя бы одного
+        bool reap(bool wait) {
+            unsigned head = *cq_head;
+            if (wait && head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+                while (uringEnter(fd, 0, 1, IORING_ENTER_GETEVENTS) < 0) {
+                    if (errno != EINTR) {
+                        broken = true;
+                        fail(errno);
+                        return false;
+                    }
+                }
+            }
+
+            const unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head) {
+                const struct io_uring_cqe& cqe = cqes[head & cq_mask];
+                Buffer& buffer = buffers[cqe.user_data];
+                buffer.inFlight = false;
+                in_flight--;
+
+                if (failed) {
+                    buffer.used = buffer.done = 0;
+                    buffer.queued = false;
+                } else if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+                    prepare(static_cast<size_t>(cqe.user_data));
+                } else if (cqe.res <= 0) {
+                    buffer.used = buffer.done = 0;
+                    buffer.queued = false;
+                    fail(cqe.res < 0 ? -cqe.res : EIO);
+                } else {
+                    buffer.done += static_cast<size_t>(cqe.res);
+                    if (buffer.done < buffer.used) {
+                        prepare(static_cast<size_t>(cqe.user_data)); // короткая запись: дописываем остаток
+                    } else {
+                        buffer.used = buffer.done = 0;
+                        buffer.queued = false;
+                    }
+                }
+            }
+            __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+            return !failed && pump();
+        }
+
+        // Заполненный буфер уходит в очередь отправки, заполняется следующий
+        bool seal() {
+            Buffer& buffer = buffers[current];
+            if (failed || buffer.used == 0) {
+                return !failed;
+            }
+            buffer.queued = true;
+            buffer.offset = file_offset;
+            file_offset += buffer.used;
+            current = (current + 1) % kBufferCount;
+            return pump();
+        }
+
+        // Свободный текущий буфер; ждём ядро, только если все буферы в полёте
+        bool acquire() {
+            while (buffers[current].queued) {
+                if (!reap(true)) {
+                    return false;
+                }
+            }
+            return !failed;
+        }
+
+        bool append(std::string_view data) {
+            while (!data.empty()) {
+                if (!acquire()) {
+                    return false;
+                }
+                Buffer& buffer = buffers[current];
+                size_t chunk = std::min(data.size(), capacity - buffer.used);
+                std::memcpy(buffer.data + buffer.used, data.data(), chunk);
+                buffer.used += chunk;
+                data.remove_prefix(chunk);
+                if (buffer.used == capacity && !seal()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool drain() {
+            if (!seal()) {
+                return false;
+            }
+            while (in_flight > 0) {
+                if (!reap(true)) {
+                    return false;
+                }
+            }
+            return !failed;
+        }
+    };
+#else
+    struct IoUringOutput::Ring {};
+#endif
+
+    // IoUringOutput implementation
+    IoUringOutput::IoUringOutput(const std::string& filename, size_t bufferSize, int flushIntervalMs)
+        : IoUringOutput(isAvailable() ? openLogFile(filename) : -1, false, bufferSize, flushIntervalMs) {
+    }
+
+    std::unique_ptr<IoUringOutput> IoUringOutput::connect(const std::string& host, int port,
+                                                          size_t bufferSize, int flushIntervalMs) {
+        int fd = isAvailable() ? connectTo(host, port) : -1;
+        return std::unique_ptr<IoUringOutput>(new IoUringOutput(fd, true, bufferSize, flushIntervalMs));
+    }
+
+    IoUringOutput::IoUringOutput(int fd, bool socket, size_t bufferSize, int flushIntervalMs)
+        : fd_(fd), socket_(socket), immediate_(bufferSize == 0),
+          flush_interval_(std::max(flushIntervalMs, 0)),
+          last_flush_(std::chrono::steady_clock::now()) {
+#ifdef LOGGING_HAS_IO_URING
+        if (!isAvailable()) {
+            std::cerr << "Ошибка: io_uring недоступен в этой системе" << std::endl;
+        }
+        if (fd_ < 0) {
+            return;
+        }
+        auto ring = std::make_unique<Ring>(fd_, socket_);
+        if (ring->init(bufferSize > 0 ? bufferSize : kDefaultBufferSize)) {
+            ring_ = std::move(ring);
+        } else {
+            std::cerr << "Ошибка инициализации io_uring: " << std::strerror(errno) << std::endl;
+        }
+#else
+        (void)bufferSize;
+        std::cerr << "Ошибка: библиотека собрана без io_uring (LOGGING_WITH_IO_URING)" << std::endl;
+#endif
+    }
+
+    IoUringOutput::~IoUringOutput() {
+#ifdef LOGGING_HAS_IO_URING
+        if (ring_) {
+            ring_->drain();
+        }
+#endif
+        ring_.reset();
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    bool IoUringOutput::isAvailable() {
+#ifdef LOGGING_HAS_IO_URING
+        static const bool available = [] {
+            struct io_uring_params params{};
+            int fd = uringSetup(2, &params);
+            if (fd < 0) {
+                return false;
+            }
+            bool supported = probeOperations(fd);
+            close(fd);
+            return supported;
+        }();
+        return available;
+#else
+        return false;
+#endif
+    }
+
+    bool IoUringOutput::append(std::string_view data, bool newline) {
+#ifdef LOGGING_HAS_IO_URING
+        if (!ring_) {
+            return false;
+        }
+        ring_->reap(false); // подбираем завершения без системного вызова
+        return ring_->append(data) && (!newline || ring_->append(std::string_view("\n", 1)));
+#else
+        (void)data;
+        (void)newline;
+        return false;
+#endif
+    }
+
+    bool IoUringOutput::finishCall() {
+#ifdef LOGGING_HAS_IO_URING
+        if (!ring_) {
+            return false;
+        }
+        // Те же правила, что у FileOutput: без буферизации или по интервалу — отправка сразу
+        if (immediate_ || (flush_interval_.count() > 0 &&
+                           std::chrono::steady_clock::now() - last_flush_ >= flush_interval_)) {
+            last_flush_ = std::chrono::steady_clock::now();
+            return ring_->seal();
+        }
+        return !ring_->failed;
+#else
+        return false;
+#endif
+    }
+
+    bool IoUringOutput::writeLog(std::string_view formattedMessage) {
+        bool ok = append(formattedMessage, true);
+        return finishCall() && ok;
+    }
+
+    bool IoUringOutput::writeRaw(std::string_view data) {
+        if (socket_) {
+            return false;
+        }
+        bool ok = append(data, false);
+        return finishCall() && ok;
+    }
+
+    bool IoUringOutput::writeBatch(const std::string_view* records, size_t count) {
+        bool ok = true;
+        for (size_t i = 0; i < count; ++i) {
+            ok = append(records[i], true) && ok;
+        }
+        return finishCall() && ok;
+    }
+
+    bool IoUringOutput::flush() {
+#ifdef LOGGING_HAS_IO_URING
+        if (!ring_) {
+            return false;
+        }
+        last_flush_ = std::chrono::steady_clock::now();
+        return ring_->drain();
+#else
+        return false;
+#endif
+    }
+
+    bool IoUringOutput::emergencyWrite(const std::string_view* records, size_t count, bool raw) noexcept {
+#ifdef LOGGING_HAS_IO_URING
+        // Кольцо работает без блокировок и выделения памяти: записи дописываются в буферы,
+        // и drain() ждёт ядро через io_uring_enter, как обычный flush()
+        if (!ring_ || (raw && socket_)) {
+            return false;
+        }
+        // std::cerr в fail() блокирует и выделяет память: на этом пути молчим
+        ring_->emergency = true;
+        bool ok = true;
+        for (size_t i = 0; i < count; ++i) {
+            ok = ring_->append(records[i]) && (raw || ring_->append(std::string_view("\n", 1))) && ok;
+        }
+        ok = ring_->drain() && ok;
+        ring_->emergency = false;
+        return ok;
+#else
+        (void)records;
+        (void)count;
+        (void)raw;
+        return false;
+#endif
+    }
+
+    bool IoUringOutput::isValid() const {
+#ifdef LOGGING_HAS_IO_URING
+        return ring_ && !ring_->failed;
+#else
+        return false;
+#endif
+    }
+
+    bool IoUringOutput::usesRegisteredBuffers() const {
+#ifdef LOGGING_HAS_IO_URING
+        return ring_ && ring_->registered;
+#else
+        return false;
+#endif
+    }
+
+}
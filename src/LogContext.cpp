@@ -0,0 +1,128 @@
+#include "logging/Logger.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace logging {
+
+    namespace {
+
+        // Теги потока в порядке добавления; version меняется при каждом изменении,
+        // по ней кэш префикса понимает, что поле контекста нужно отрисовать заново
+        struct ThreadContext {
+            std::vector<std::pair<std::string, std::string>> tags;
+            uint64_t version = 1;
+        };
+
+        thread_local ThreadContext threadContext;
+
+        // Отрисованное поле контекста для последнего логгера потока
+        struct PrefixCache {
+            uint64_t fieldsId = 0;
+            uint64_t tagsVersion = 0;
+            std::string text;
+        };
+
+        thread_local PrefixCache prefixCache;
+
+        // Пробелы, '=' и ']' разбили бы поле "[k=v ...]" при разборе, поэтому заменяются на '_'
+        void appendSanitized(std::string& out, std::string_view text) {
+            for (char c : text) {
+                out.push_back(c == ' ' || c == '=' || c == ']' || c == '\t' || c == '\r' || c == '\n' ? '_' : c);
+            }
+        }
+
+        std::string sanitized(std::string_view text) {
+            std::string result;
+            result.reserve(text.size());
+            appendSanitized(result, text);
+            return result;
+        }
+
+        auto findTag(const std::string& key) {
+            return std::find_if(threadContext.tags.begin(), threadContext.tags.end(),
+                                [&](const auto& tag) { return tag.first == key; });
+        }
+
+        // Идентификатор потока ядра (как в top и /proc), запрашивается один раз на поток
+        long threadId() {
+            thread_local long id = syscall(SYS_gettid);
+            return id;
+        }
+
+    }
+
+    void LogContext::set(std::string_view key, std::string_view value) {
+        if (key.empty()) {
+            return;
+        }
+        std::string name = sanitized(key);
+        auto tag = findTag(name);
+        if (tag != threadContext.tags.end()) {
+            tag->second.clear();
+            appendSanitized(tag->second, value);
+        } else {
+            threadContext.tags.emplace_back(std::move(name), sanitized(value));
+        }
+        ++threadContext.version;
+    }
+
+    bool LogContext::get(std::string_view key, std::string& value) {
+        auto tag = findTag(sanitized(key));
+        if (tag == threadContext.tags.end()) {
+            return false;
+        }
+        value = tag->second;
+        return true;
+    }
+
+    void LogContext::remove(std::string_view key) {
+        auto tag = findTag(sanitized(key));
+        if (tag != threadContext.tags.end()) {
+            threadContext.tags.erase(tag);
+            ++threadContext.version;
+        }
+    }
+
+    void LogContext::clear() {
+        if (!threadContext.tags.empty()) {
+            threadContext.tags.clear();
+            ++threadContext.version;
+        }
+    }
+
+    std::string_view Logger::contextPrefix(const ConfigSnapshot& config) const {
+        // Обычный случай — две проверки и готовые байты; отрисовка только при смене
+        // тегов потока, настроек полей или логгера, в который пишет поток
+        if (prefixCache.fieldsId == config.contextFieldsId && prefixCache.tagsVersion == threadContext.version) {
+            return prefixCache.text;
+        }
+
+        std::string& text = prefixCache.text;
+        text.clear();
+        auto separate = [&text] { text.append(text.empty() ? "[" : " "); };
+        if (!config.config.loggerName.empty()) {
+            separate();
+            text.append("logger=");
+            appendSanitized(text, config.config.loggerName);
+        }
+        if (config.config.threadIdField) {
+            separate();
+            text.append("tid=").append(std::to_string(threadId()));
+        }
+        for (const auto& [key, value] : threadContext.tags) {
+            separate();
+            text.append(key).append("=", 1).append(value);
+        }
+        if (!text.empty()) {
+            text.append("] ", 2);
+        }
+
+        prefixCache.fieldsId = config.contextFieldsId;
+        prefixCache.tagsVersion = threadContext.version;
+        return text;
+    }
+
+}
@@ -0,0 +1,383 @@
+#include "logging/Logger.h"
+#include <iostream>
+#include <filesystem>
+#include <system_error>
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef LOGGING_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+namespace logging {
+
+    namespace {
+
+        namespace fs = std::filesystem;
+
+        // Сжатие source в gzip-файл destination (через временный файл, чтобы
+        // читатели никогда не видели недописанный .gz)
+        bool compressFile(const std::string& source, const std::string& destination) {
+#ifdef LOGGING_HAS_ZLIB
+            std::ifstream input(source, std::ios::binary);
+            if (!input.is_open()) {
+                return false;
+            }
+
+            const std::string temporary = destination + ".tmp";
+            gzFile output = gzopen(temporary.c_str(), "wb6");
+            if (!output) {
+                return false;
+            }
+
+            char buffer[64 * 1024];
+            bool ok = true;
+            while (ok && input) {
+                input.read(buffer, sizeof(buffer));
+                std::streamsize count = input.gcount();
+                if (count > 0 && gzwrite(output, buffer, static_cast<unsigned>(count)) != count) {
+                    ok = false;
+                }
+            }
+            ok = (gzclose(output) == Z_OK) && ok;
+
+            std::error_code ec;
+            if (ok) {
+                fs::rename(temporary, destination, ec);
+                ok = !ec;
+            }
+            if (!ok) {
+                fs::remove(temporary, ec);
+            }
+            return ok;
+#else
+            (void)source;
+            (void)destination;
+            return false;
+#endif
+        }
+
+    }
+
+    // LogRotator implementation
+    LogRotator::LogRotator(const std::string& base_filename, size_t max_size_mb, size_t max_files, bool compress)
+        : base_filename_(base_filename), max_size_bytes_(max_size_mb * 1024 * 1024),
+          max_files_(max_files), compress_(compress) {
+#ifndef LOGGING_HAS_ZLIB
+        if (compress_) {
+            std::cerr << "Предупреждение: библиотека собрана без zlib, сжатие журналов отключено" << std::endl;
+            compress_ = false;
+        }
+#endif
+        // Сегменты, переименованные прошлым процессом, но не обработанные до его
+        // завершения: их обработка продолжается, а новые имена начинаются после них
+        const fs::path base(base_filename_);
+        const fs::path directory = base.has_parent_path() ? base.parent_path() : fs::path(".");
+        const std::string prefix = base.filename().string() + ".pending.";
+        std::vector<std::pair<uint64_t, std::string>> leftovers;
+        std::error_code ec;
+        for (fs::directory_iterator entry(directory, ec), end; !ec && entry != end; entry.increment(ec)) {
+            const std::string name = entry->path().filename().string();
+            if (name.size() <= prefix.size() || name.size() - prefix.size() > 18 ||
+                name.compare(0, prefix.size(), prefix) != 0 ||
+                !std::all_of(name.begin() + prefix.size(), name.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+                continue;
+            }
+            leftovers.emplace_back(std::stoull(name.substr(prefix.size())), entry->path().string());
+        }
+        std::sort(leftovers.begin(), leftovers.end());
+        for (auto& [id, path] : leftovers) {
+            pending_.push_back(std::move(path));
+            next_pending_id_ = id + 1;
+        }
+        worker_ = std::thread(&LogRotator::workerLoop, this);
+    }
+
+    LogRotator::~LogRotator() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
+
+    bool LogRotator::shouldRotate(size_t current_size) const {
+        return max_size_bytes_ > 0 && current_size >= max_size_bytes_;
+    }
+
+    bool LogRotator::rotate() {
+        // Горячий путь: только переименование, остальное делает фоновый поток
+        std::unique_lock<std::mutex> lock(mutex_);
+        std::string pendingFile = base_filename_ + ".pending." + std::to_string(next_pending_id_++);
+        std::error_code ec;
+        while (fs::exists(pendingFile, ec)) {
+            // Имя занято (например, другим процессом): необработанный сегмент не затираем
+            pendingFile = base_filename_ + ".pending." + std::to_string(next_pending_id_++);
+        }
+
+        fs::rename(base_filename_, pendingFile, ec);
+        if (ec) {
+            std::cerr << "Ошибка ротации журнала " << base_filename_ << ": " << ec.message() << std::endl;
+            return false;
+        }
+
+        pending_.push_back(std::move(pendingFile));
+        lock.unlock();
+        cv_.notify_one();
+        return true;
+    }
+
+    void LogRotator::waitIdle() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_cv_.wait(lock, [this] { return pending_.empty() && !busy_; });
+    }
+
+    std::string LogRotator::segmentName(size_t index, bool compressed) const {
+        std::string name = base_filename_ + "." + std::to_string(index);
+        if (compressed) {
+            name += ".gz";
+        }
+        return name;
+    }
+
+    void LogRotator::workerLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cv_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+            if (pending_.empty()) {
+                break; // stopping_ и вся работа сделана
+            }
+
+            std::string pendingFile = std::move(pending_.front());
+            pending_.pop_front();
+            busy_ = true;
+            lock.unlock();
+
+            processSegment(pendingFile);
+
+            lock.lock();
+            busy_ = false;
+            if (pending_.empty()) {
+                idle_cv_.notify_all();
+            }
+        }
+    }
+
+    void LogRotator::processSegment(const std::string& pendingFile) {
+        std::error_code ec;
+
+        if (max_files_ == 0) {
+            fs::remove(pendingFile, ec);
+            return;
+        }
+
+        // Каскад переименований: base.N удаляется, base.i -> base.(i+1)
+        fs::remove(segmentName(max_files_, false), ec);
+        fs::remove(segmentName(max_files_, true), ec);
+        for (size_t index = max_files_ - 1; index >= 1; --index) {
+            for (bool compressed : {false, true}) {
+                std::string from = segmentName(index, compressed);
+                if (fs::exists(from, ec)) {
+                    fs::rename(from, segmentName(index + 1, compressed), ec);
+                }
+            }
+        }
+
+        const std::string newest = segmentName(1, false);
+        fs::rename(pendingFile, newest, ec);
+        if (ec) {
+            std::cerr << "Ошибка ротации журнала " << pendingFile << ": " << ec.message() << std::endl;
+            return;
+        }
+
+        if (compress_) {
+            if (compressFile(newest, segmentName(1, true))) {
+                fs::remove(newest, ec);
+            } else {
+                std::cerr << "Ошибка сжатия журнала " << newest << std::endl;
+            }
+        }
+    }
+
+    // LogSegmentReader implementation
+    LogSegmentReader::~LogSegmentReader() {
+        close();
+    }
+
+    bool LogSegmentReader::open(const std::string& path) {
+        close();
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) {
+            return false;
+        }
+
+        // Заголовок gzip: 1f 8b
+        unsigned char magic[2] = {0, 0};
+        compressed_ = pread(fd_, magic, sizeof(magic), 0) == 2 && magic[0] == 0x1f && magic[1] == 0x8b;
+        if (!compressed_) {
+            return true;
+        }
+#ifdef LOGGING_HAS_ZLIB
+        gzFile file = gzdopen(fd_, "rb");
+        if (!file) {
+            close();
+            return false;
+        }
+        fd_ = -1; // дескриптором теперь владеет zlib
+        gzbuffer(file, 256 * 1024);
+        gz_ = file;
+        return true;
+#else
+        close();
+        return false;
+#endif
+    }
+
+    int64_t LogSegmentReader::read(char* buffer, size_t size) {
+#ifdef LOGGING_HAS_ZLIB
+        if (gz_) {
+            // gzread принимает unsigned: больше 1 ГиБ за раз не читаем
+            gzFile file = static_cast<gzFile>(gz_);
+            int count = gzread(file, buffer, static_cast<unsigned>(std::min<size_t>(size, 1u << 30)));
+            if (count == 0 && size > 0) {
+                // Оборванный .gz zlib отдаёт как обычный конец, ошибка видна только в gzerror
+                int error = Z_OK;
+                gzerror(file, &error);
+                return error == Z_OK ? 0 : -1;
+            }
+            return count < 0 ? -1 : count;
+        }
+#endif
+        if (fd_ < 0) {
+            return -1;
+        }
+        for (;;) {
+            ssize_t count = ::read(fd_, buffer, size);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            return count;
+        }
+    }
+
+    void LogSegmentReader::close() {
+#ifdef LOGGING_HAS_ZLIB
+        if (gz_) {
+            gzclose(static_cast<gzFile>(gz_));
+            gz_ = nullptr;
+        }
+#endif
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    // EnhancedFileOutput implementation
+    EnhancedFileOutput::EnhancedFileOutput(const std::string& filename, size_t max_size_mb, size_t max_files,
+                                           bool compress, size_t bufferSize, int flushIntervalMs,
+                                           bool ioUring)
+        : filename_(filename),
+          rotator_(std::make_unique<LogRotator>(filename, max_size_mb, max_files, compress)),
+          current_size_(0), buffer_size_(bufferSize), flush_interval_ms_(flushIntervalMs),
+          io_uring_(ioUring) {
+        file_ = openFile();
+        std::error_code ec;
+        auto existing = fs::file_size(filename_, ec);
+        if (!ec) {
+            current_size_ = static_cast<size_t>(existing);
+        }
+    }
+
+    EnhancedFileOutput::~EnhancedFileOutput() {
+        std::lock_guard<std::mutex> lock(file_mutex_);
+        file_.reset();
+    }
+
+    bool EnhancedFileOutput::writeLog(std::string_view formattedMessage) {
+        std::lock_guard<std::mutex> lock(file_mutex_);
+        const size_t recordSize = formattedMessage.size() + 1;
+
+        if (current_size_ > 0 && rotator_->shouldRotate(current_size_ + recordSize)) {
+            rotateFile();
+        }
+
+        bool ok = file_ && file_->writeLog(formattedMessage);
+        current_size_ += recordSize;
+        return ok;
+    }
+
+    bool EnhancedFileOutput::writeRaw(std::string_view data) {
+        // Двоичные записи ссылаются на определения, выданные раньше в том же сегменте,
+        // поэтому ротация выполняется после записи: следующая запись увидит новое поколение
+        std::lock_guard<std::mutex> lock(file_mutex_);
+        bool ok = file_ && file_->writeRaw(data);
+        current_size_ += data.size();
+
+        if (rotator_->shouldRotate(current_size_)) {
+            rotateFile();
+        }
+        return ok;
+    }
+
+    bool EnhancedFileOutput::writeBatch(const std::string_view* records, size_t count) {
+        // Пачка делится на части, помещающиеся в текущий сегмент; граница ротации
+        // проходит между записями, как и при writeLog
+        std::lock_guard<std::mutex> lock(file_mutex_);
+        bool ok = true;
+        size_t start = 0;
+        size_t runSize = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const size_t recordSize = records[i].size() + 1;
+            if (current_size_ + runSize > 0 && rotator_->shouldRotate(current_size_ + runSize + recordSize)) {
+                ok = (file_ && file_->writeBatch(records + start, i - start)) && ok;
+                rotateFile();
+                start = i;
+                runSize = 0;
+            }
+            runSize += recordSize;
+        }
+        ok = (file_ && file_->writeBatch(records + start, count - start)) && ok;
+        current_size_ += runSize;
+        return ok;
+    }
+
+    std::unique_ptr<LogOutput> EnhancedFileOutput::openFile() const {
+        if (io_uring_) {
+            return std::make_unique<IoUringOutput>(filename_, buffer_size_, flush_interval_ms_);
+        }
+        return std::make_unique<FileOutput>(filename_, buffer_size_, flush_interval_ms_);
+    }
+
+    void EnhancedFileOutput::rotateFile() {
+        // Дописываем буфер в старый сегмент, переименовываем и открываем новый файл
+        file_->flush();
+        file_.reset();
+        rotator_->rotate();
+        file_ = openFile();
+        // Даже при ошибке переименования следующая попытка — через max_size байт
+        current_size_ = 0;
+        generation_.fetch_add(1, std::memory_order_release);
+    }
+
+    bool EnhancedFileOutput::isValid() const {
+        std::lock_guard<std::mutex> lock(file_mutex_);
+        return file_ && file_->isValid();
+    }
+
+    bool EnhancedFileOutput::flush() {
+        std::lock_guard<std::mutex> lock(file_mutex_);
+        return file_ && file_->flush();
+    }
+
+    bool EnhancedFileOutput::emergencyWrite(const std::string_view* records, size_t count, bool raw) noexcept {
+        // Без file_mutex_: процесс завершается, ротация и размер файла уже не важны
+        return file_ && file_->emergencyWrite(records, count, raw);
+    }
+
+}
@@ -1,26 +1,315 @@
 #include "logging/Logger.h"
 #include <iostream>
-#include <iomanip>
-#include <sstream>
 #include <ctime>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <algorithm>
+#include <cstring>
+#include <cerrno>
 
 namespace logging {
 
-    std::string logLevelToString(LogLevel level) {
-        switch (level) {
-            case LogLevel::TRACE:   return "TRACE";
-            case LogLevel::DEBUG:   return "DEBUG";
-            case LogLevel::INFO:    return "INFO";
-            case LogLevel::WARNING: return "WARNING";
-            case LogLevel::ERROR:   return "ERROR";
-            case LogLevel::FATAL:   return "FATAL";
-            default:                return "UNKNOWN";
+    namespace {
+
+        const char* levelName(LogLevel level) {
+            switch (level) {
+                case LogLevel::TRACE:   return "TRACE";
+                case LogLevel::DEBUG:   return "DEBUG";
+                case LogLevel::INFO:    return "INFO";
+                case LogLevel::WARNING: return "WARNING";
+                case LogLevel::ERROR:   return "ERROR";
+                case LogLevel::FATAL:   return "FATAL";
+                default:                return "UNKNOWN";
+            }
+        }
+
+        // Источник идентификаторов форматов времени для TimestampCache
+        std::atomic<uint64_t> nextTimestampFormatId{1};
+
+        // Источник идентификаторов полей контекста (имя логгера, tid) для кэша префикса потока
+        std::atomic<uint64_t> nextContextFieldsId{1};
+
+        // Источник идентификаторов логгеров для потоковых кэшей конфигурации
+        std::atomic<uint64_t> nextLoggerId{1};
+
+        // Сколько раз ожидающий производитель крутится до уступки процессора
+        constexpr int kCombineSpinCount = 64;
+
+        // Кэш отформатированной по strftime части метки времени.
+        // Один на поток: localtime_r и strftime вызываются только при смене секунды
+        // (или формата), дробная часть дописывается в буфер вручную.
+        class TimestampCache {
+        private:
+            static constexpr size_t kPrefixSize = 128;
+
+            int64_t second_ = INT64_MIN;
+            uint64_t format_id_ = 0;
+            char prefix_[kPrefixSize];
+            size_t prefix_len_ = 0;
+
+        public:
+            size_t format(char* buffer, size_t size,
+                          const std::chrono::system_clock::time_point& timestamp,
+                          const std::string& format, uint64_t formatId,
+                          TimestampPrecision precision) {
+                auto sinceEpoch = std::chrono::duration_cast<std::chrono::microseconds>(
+                    timestamp.time_since_epoch()).count();
+                int64_t second = sinceEpoch / 1000000;
+                int64_t micros = sinceEpoch % 1000000;
+                if (micros < 0) {
+                    micros += 1000000;
+                    second -= 1;
+                }
+
+                if (second != second_ || formatId != format_id_) {
+                    std::time_t time = static_cast<std::time_t>(second);
+                    std::tm tm{};
+                    localtime_r(&time, &tm);
+                    prefix_len_ = std::strftime(prefix_, kPrefixSize, format.c_str(), &tm);
+                    second_ = second;
+                    format_id_ = formatId;
+                }
+
+                int digits = static_cast<int>(precision);
+                size_t total = prefix_len_ + (digits > 0 ? 1 + digits : 0);
+                if (total > size) {
+                    return 0;
+                }
+
+                std::memcpy(buffer, prefix_, prefix_len_);
+                if (digits > 0) {
+                    char* fraction = buffer + prefix_len_;
+                    fraction[0] = '.';
+                    int64_t value = digits == 3 ? micros / 1000 : micros;
+                    for (int i = digits; i > 0; --i) {
+                        fraction[i] = static_cast<char>('0' + value % 10);
+                        value /= 10;
+                    }
+                }
+                return total;
+            }
+        };
+
+        thread_local TimestampCache timestampCache;
+
+        // Буфер форматирования записи, переиспользуемый между вызовами в потоке
+        thread_local std::string formatBuffer;
+
+        // Доля измеряемых вызовов: время берётся у каждого N-го вызова потока и N-й записи в вывод
+        constexpr uint32_t kEnqueueSampleRate = 16;
+        constexpr uint32_t kSinkSampleRate = 8;
+
+        // Счётчик с одним писателем: обычные load и store вместо атомарного RMW
+        inline void bump(std::atomic<uint64_t>& counter, uint64_t amount = 1) {
+            counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+
+        int64_t steadyNowNs() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // LatencyHistogram с одним писателем, читаемая из других потоков
+        struct AtomicHistogram {
+            std::atomic<uint64_t> buckets[LatencyHistogram::kBuckets] = {};
+            std::atomic<uint64_t> count{0};
+            std::atomic<uint64_t> totalNs{0};
+            std::atomic<uint64_t> maxNs{0};
+
+            void record(int64_t elapsedNs) {
+                uint64_t ns = elapsedNs > 0 ? static_cast<uint64_t>(elapsedNs) : 0;
+                size_t bucket = std::min<size_t>(63 - static_cast<size_t>(__builtin_clzll(ns | 1)),
+                                                 LatencyHistogram::kBuckets - 1);
+                bump(buckets[bucket]);
+                bump(count);
+                bump(totalNs, ns);
+                if (ns > maxNs.load(std::memory_order_relaxed)) {
+                    maxNs.store(ns, std::memory_order_relaxed);
+                }
+            }
+
+            void addTo(LatencyHistogram& out) const {
+                for (size_t i = 0; i < LatencyHistogram::kBuckets; ++i) {
+                    out.buckets[i] += buckets[i].load(std::memory_order_relaxed);
+                }
+                out.count += count.load(std::memory_order_relaxed);
+                out.totalNs += totalNs.load(std::memory_order_relaxed);
+                out.maxNs = std::max(out.maxNs, maxNs.load(std::memory_order_relaxed));
+            }
+        };
+
+        // Частей iovec на один sendmsg (не больше IOV_MAX)
+        constexpr size_t kMaxSendParts = 512;
+
+        // Запись всего куска через write(2) (async-signal-safe, для аварийного сброса)
+        bool writeFully(int fd, const char* data, size_t size) {
+            while (size > 0) {
+                ssize_t written = ::write(fd, data, size);
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                data += written;
+                size -= static_cast<size_t>(written);
+            }
+            return true;
+        }
+
+        // Отправка всех частей; частичная отправка дописывается в цикле
+        bool sendParts(int fd, struct iovec* parts, size_t count) {
+            while (count > 0) {
+                struct msghdr message{};
+                message.msg_iov = parts;
+                message.msg_iovlen = count;
+
+                ssize_t sent = sendmsg(fd, &message, MSG_NOSIGNAL);
+                if (sent < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+
+                size_t left = static_cast<size_t>(sent);
+                while (count > 0 && left >= parts->iov_len) {
+                    left -= parts->iov_len;
+                    ++parts;
+                    --count;
+                }
+                if (count > 0) {
+                    parts->iov_base = static_cast<char*>(parts->iov_base) + left;
+                    parts->iov_len -= left;
+                }
+            }
+            return true;
+        }
+
+        // Файловый вывод по конфигурации: отображаемый в память, с ротацией или простой буферизованный;
+        // ioUring заменяет write на io_uring, если ядро его поддерживает, иначе игнорируется
+        std::unique_ptr<LogOutput> createFileOutput(const std::string& filename, const LoggerConfig& config) {
+            if (config.memoryMappedFile) {
+                return std::make_unique<MappedFileOutput>(filename, config.maxFileSizeMB, config.maxFiles,
+                                                          config.compressOldLogs, config.flushIntervalMs,
+                                                          config.enableRotation);
+            }
+            const bool ioUring = config.ioUring && IoUringOutput::isAvailable();
+            if (config.enableRotation && config.maxFileSizeMB > 0) {
+                return std::make_unique<EnhancedFileOutput>(filename, config.maxFileSizeMB, config.maxFiles,
+                                                            config.compressOldLogs, config.fileBufferSize,
+                                                            config.flushIntervalMs, ioUring);
+            }
+            if (ioUring) {
+                return std::make_unique<IoUringOutput>(filename, config.fileBufferSize, config.flushIntervalMs);
+            }
+            return std::make_unique<FileOutput>(filename, config.fileBufferSize, config.flushIntervalMs);
+        }
+
+        // Конфигурация с выводом, заданным аргументами конструктора
+        LoggerConfig withSink(const LoggerConfig& config, const std::string& filename,
+                              const std::string& host, int port) {
+            LoggerConfig result = config;
+            result.filename = filename;
+            result.host = host;
+            result.port = port;
+            return result;
+        }
+
+        // ioUring здесь не действует: у IoUringOutput::connect нет переподключения и сжатия
+        std::unique_ptr<LogOutput> createSocketOutput(const LoggerConfig& config) {
+            return std::make_unique<EnhancedSocketOutput>(config.host, config.port, config.reconnectIntervalMs,
+                                                          config.maxReconnectAttempts, config.socketBufferBytes,
+                                                          config.socketCompression, config.connectInBackground);
+        }
+
+    }
+
+    std::unique_ptr<LogOutput> createOutput(const LoggerConfig& config) {
+        LazyOutput::Factory factory;
+        if (!config.filename.empty()) {
+            factory = [config] { return createFileOutput(config.filename, config); };
+        } else if (!config.host.empty()) {
+            factory = [config] { return createSocketOutput(config); };
+        } else {
+            return nullptr;
+        }
+        if (config.lazyOpen) {
+            // Файловые выводы умеют writeRaw, сетевые — нет
+            return std::make_unique<LazyOutput>(std::move(factory), !config.filename.empty());
+        }
+        return factory();
+    }
+
+    // Счётчики одного потока-производителя (или пишущего, для writer_stats_).
+    // У каждого поля один писатель за раз, getStats читает их relaxed-загрузками
+    struct alignas(64) Logger::StatsShard {
+        std::thread::id owner;
+        uint32_t calls = 0;                         // только писатель: выбор измеряемых вызовов
+        std::atomic<uint64_t> accepted[kLogLevelCount] = {};
+        std::atomic<uint64_t> filtered[kLogLevelCount] = {};
+        AtomicHistogram latency;                    // постановка в очередь или запись в вывод
+
+        // Только writer_stats_ (под mutex_)
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> sinkWrites{0};
+        std::atomic<uint64_t> writeErrors{0};
+        std::atomic<uint64_t> flushes{0};
+        std::atomic<uint64_t> queueHighWater{0};
+    };
+
+    double LatencyHistogram::quantileNs(double q) const {
+        if (count == 0) {
+            return 0.0;
+        }
+        const double target = std::min(std::max(q, 0.0), 1.0) * static_cast<double>(count);
+        double seen = 0.0;
+        for (size_t i = 0; i < kBuckets; ++i) {
+            if (buckets[i] == 0) {
+                continue;
+            }
+            const double next = seen + static_cast<double>(buckets[i]);
+            if (next >= target) {
+                const double lower = i == 0 ? 0.0 : static_cast<double>(1ULL << i);
+                const double upper = static_cast<double>(1ULL << (i + 1));
+                const double value = lower + (upper - lower) * (target - seen) / static_cast<double>(buckets[i]);
+                return std::min(value, static_cast<double>(maxNs));
+            }
+            seen = next;
+        }
+        return static_cast<double>(maxNs);
+    }
+
+    uint64_t LoggerStats::acceptedTotal() const {
+        uint64_t total = 0;
+        for (uint64_t count : accepted) {
+            total += count;
+        }
+        return total;
+    }
+
+    uint64_t LoggerStats::filteredTotal() const {
+        uint64_t total = 0;
+        for (uint64_t count : filtered) {
+            total += count;
+        }
+        return total;
+    }
+
+    uint64_t LoggerStats::droppedTotal() const {
+        uint64_t total = 0;
+        for (uint64_t count : dropped) {
+            total += count;
         }
+        return total;
+    }
+
+    std::string logLevelToString(LogLevel level) {
+        return levelName(level);
     }
 
     LogLevel stringToLogLevel(const std::string& levelStr) {
@@ -38,33 +327,137 @@ namespace logging {
     }
 
     // FileOutput implementation
-    FileOutput::FileOutput(const std::string& filename) : filename_(filename) {
-        file_.open(filename_, std::ios::app);
+    FileOutput::FileOutput(const std::string& filename, size_t bufferSize, int flushIntervalMs)
+        : filename_(filename), buffer_size_(bufferSize),
+          flush_interval_(std::max(flushIntervalMs, 0)),
+          last_flush_(std::chrono::steady_clock::now()) {
+        // Буферизацию делаем сами, поэтому отключаем буфер потока:
+        // каждый writeBuffer() превращается ровно в один системный вызов write
+        file_.rdbuf()->pubsetbuf(nullptr, 0);
+        file_.open(filename_, std::ios::app | std::ios::binary);
         if (!file_.is_open()) {
             std::cerr << "Ошибка: не удалось открыть файл журнала: " << filename_ << std::endl;
         }
+        buffer_.reserve(buffer_size_ > 0 ? buffer_size_ : 256);
     }
 
     FileOutput::~FileOutput() {
         if (file_.is_open()) {
+            writeBuffer();
             file_.close();
         }
+        if (crash_fd_ >= 0) {
+            close(crash_fd_);
+        }
     }
 
-    bool FileOutput::writeLog(const std::string& formattedMessage) {
+    bool FileOutput::writeLog(std::string_view formattedMessage) {
+        return append(formattedMessage, true);
+    }
+
+    bool FileOutput::writeRaw(std::string_view data) {
+        return append(data, false);
+    }
+
+    bool FileOutput::append(std::string_view data, bool newline) {
         if (!file_.is_open()) {
             return false;
         }
-        
-        file_ << formattedMessage << std::endl;
-        file_.flush();
+
+        // Запись не помещается в буфер: сбрасываем накопленное, чтобы не раздувать буфер
+        const size_t recordSize = data.size() + (newline ? 1 : 0);
+        if (buffer_size_ > 0 && buffer_.size() + recordSize > buffer_size_) {
+            writeBuffer();
+        }
+
+        buffer_.append(data);
+        if (newline) {
+            buffer_.push_back('\n');
+        }
+
+        if (buffer_size_ == 0 || buffer_.size() >= buffer_size_) {
+            return writeBuffer();
+        }
+
+        if (flush_interval_.count() > 0 &&
+            std::chrono::steady_clock::now() - last_flush_ >= flush_interval_) {
+            return writeBuffer();
+        }
+
         return file_.good();
     }
 
+    bool FileOutput::writeBatch(const std::string_view* records, size_t count) {
+        if (!file_.is_open()) {
+            return false;
+        }
+
+        // Пачка копится в том же буфере; без буферизации уходит в файл одним write
+        for (size_t i = 0; i < count; ++i) {
+            if (buffer_size_ > 0 && !buffer_.empty() && buffer_.size() + records[i].size() + 1 > buffer_size_) {
+                writeBuffer();
+            }
+            buffer_.append(records[i]);
+            buffer_.push_back('\n');
+        }
+
+        if (buffer_size_ == 0 || buffer_.size() >= buffer_size_) {
+            return writeBuffer();
+        }
+
+        if (flush_interval_.count() > 0 &&
+            std::chrono::steady_clock::now() - last_flush_ >= flush_interval_) {
+            return writeBuffer();
+        }
+
+        return file_.good();
+    }
+
+    bool FileOutput::writeBuffer() {
+        last_flush_ = std::chrono::steady_clock::now();
+        if (buffer_.empty()) {
+            return file_.good();
+        }
+
+        file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+        return file_.good();
+    }
+
+    bool FileOutput::flush() {
+        if (!file_.is_open()) {
+            return false;
+        }
+
+        bool ok = writeBuffer();
+        file_.flush();
+        return ok && file_.good();
+    }
+
     bool FileOutput::isValid() const {
         return file_.is_open() && file_.good();
     }
 
+    bool FileOutput::emergencyWrite(const std::string_view* records, size_t count, bool raw) noexcept {
+        // Буфер потока отключён, поэтому всё незаписанное лежит в buffer_; файл открывается
+        // ещё раз с O_APPEND, так как у ofstream нет дескриптора
+        if (crash_fd_ < 0) {
+            crash_fd_ = ::open(filename_.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+            if (crash_fd_ < 0) {
+                return false;
+            }
+        }
+        bool ok = writeFully(crash_fd_, buffer_.data(), buffer_.size());
+        buffer_.clear();
+        for (size_t i = 0; i < count; ++i) {
+            ok = writeFully(crash_fd_, records[i].data(), records[i].size()) && ok;
+            if (!raw) {
+                ok = writeFully(crash_fd_, "\n", 1) && ok;
+            }
+        }
+        return ok;
+    }
+
     // SocketOutput implementation
     SocketOutput::SocketOutput(const std::string& host, int port) 
         : socket_fd_(-1), host_(host), port_(port), connected_(false) {
@@ -111,68 +504,583 @@ namespace logging {
         connected_ = false;
     }
 
-    bool SocketOutput::writeLog(const std::string& formattedMessage) {
+    bool SocketOutput::writeLog(std::string_view formattedMessage) {
+        return writeBatch(&formattedMessage, 1);
+    }
+
+    bool SocketOutput::writeBatch(const std::string_view* records, size_t count) {
         if (!connected_ || socket_fd_ < 0) {
             return false;
         }
 
-        std::string message = formattedMessage + "\n";
-        ssize_t sent = send(socket_fd_, message.c_str(), message.length(), 0);
-        
-        if (sent < 0) {
-            std::cerr << "Ошибка отправки данных в сокет" << std::endl;
-            connected_ = false;
-            return false;
+        // Записи и переводы строк уходят через sendmsg без склейки в новую строку,
+        // по kMaxSendParts частей за вызов
+        static const char newline = '\n';
+        struct iovec parts[kMaxSendParts];
+        size_t next = 0;
+        while (next < count) {
+            size_t used = 0;
+            for (; next < count && used + 2 <= kMaxSendParts; ++next) {
+                parts[used].iov_base = const_cast<char*>(records[next].data());
+                parts[used++].iov_len = records[next].size();
+                parts[used].iov_base = const_cast<char*>(&newline);
+                parts[used++].iov_len = 1;
+            }
+            if (!sendParts(socket_fd_, parts, used)) {
+                std::cerr << "Ошибка отправки данных в сокет" << std::endl;
+                connected_ = false;
+                return false;
+            }
         }
 
-        return sent == static_cast<ssize_t>(message.length());
+        return true;
     }
 
     bool SocketOutput::isValid() const {
         return connected_ && socket_fd_ >= 0;
     }
 
+    bool SocketOutput::emergencyWrite(const std::string_view* records, size_t count, bool raw) noexcept {
+        // Буфера нет: записи отправляются сразу, sendmsg допустим в обработчике сигнала
+        if (raw || !isValid()) {
+            return false;
+        }
+        static const char newline = '\n';
+        for (size_t i = 0; i < count; ++i) {
+            struct iovec parts[2];
+            parts[0].iov_base = const_cast<char*>(records[i].data());
+            parts[0].iov_len = records[i].size();
+            parts[1].iov_base = const_cast<char*>(&newline);
+            parts[1].iov_len = 1;
+            if (!sendParts(socket_fd_, parts, 2)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Запрос на запись, ожидающий комбинирования; живёт на стеке производителя
+    struct Logger::PendingWrite {
+        std::string_view formattedMessage;
+        LogLevel level;
+        bool binary = false;
+        PendingWrite* next = nullptr;
+        bool result = false;
+        std::atomic<bool> done{false};
+    };
+
     // Logger implementation
     Logger::Logger(const std::string& filename, LogLevel defaultLevel) 
-        : output_(std::make_unique<FileOutput>(filename)), defaultLevel_(defaultLevel) {
+        : output_(std::make_unique<FileOutput>(filename)), defaultLevel_(defaultLevel),
+          instance_id_(nextLoggerId.fetch_add(1, std::memory_order_relaxed)) {
+        LoggerConfig config;
+        config.defaultLevel = defaultLevel;
+        publishConfig(config);
+    }
+
+    Logger::Logger(const std::string& filename, const LoggerConfig& config)
+        : output_(createOutput(withSink(config, filename, std::string(), 0))),
+          defaultLevel_(config.defaultLevel),
+          instance_id_(nextLoggerId.fetch_add(1, std::memory_order_relaxed)) {
+        setConfig(config);
     }
 
     Logger::Logger(const std::string& host, int port, LogLevel defaultLevel)
-        : output_(std::make_unique<SocketOutput>(host, port)), defaultLevel_(defaultLevel) {
+        : output_(std::make_unique<SocketOutput>(host, port)), defaultLevel_(defaultLevel),
+          instance_id_(nextLoggerId.fetch_add(1, std::memory_order_relaxed)) {
+        LoggerConfig config;
+        config.defaultLevel = defaultLevel;
+        publishConfig(config);
+    }
+
+    Logger::Logger(const std::string& host, int port, const LoggerConfig& config)
+        : output_(createOutput(withSink(config, std::string(), host, port))),
+          defaultLevel_(config.defaultLevel),
+          instance_id_(nextLoggerId.fetch_add(1, std::memory_order_relaxed)) {
+        setConfig(config);
+    }
+
+    Logger::Logger(const LoggerConfig& config) : Logger(createOutput(config), config) {
+        if (!output_) {
+            setError(LoggingError::CONFIG_PARSE_ERROR, "LoggerConfig names no sink: set filename or host and port");
+        }
+    }
+
+    Logger::Logger(std::unique_ptr<LogOutput> output, const LoggerConfig& config)
+        : output_(std::move(output)),
+          defaultLevel_(config.defaultLevel),
+          instance_id_(nextLoggerId.fetch_add(1, std::memory_order_relaxed)) {
+        setConfig(config);
     }
 
     Logger::~Logger() {
+        // Дальше очередь и выводы дописывает сам деструктор
+        setCrashFlush(false);
+        // Итоги подавленных записей попадают в журнал до остановки рабочего потока
+        if (throttling_.load(std::memory_order_relaxed)) {
+            reportRepeats();
+            reportSuppressed();
+        }
         stopAsyncWorker();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (output_) {
+            flushOutput();
+        }
+        lanes_.clear(); // каждый дописывает свою очередь
     }
 
-    bool Logger::log(const std::string& message, LogLevel level) {
+    bool Logger::log(std::string_view message, LogLevel level) {
         // Проверяем, нужно ли записывать сообщение
-        if (static_cast<int>(level) < static_cast<int>(defaultLevel_)) {
+        if (!isLevelEnabled(level)) {
+            countFiltered(level);
             return true; // Сообщение отфильтровано, но это не ошибка
         }
 
+        // Без формата место вызова неизвестно: частота ограничивается по тексту сообщения
+        if (throttling_.load(std::memory_order_relaxed)) {
+            uint64_t hash = std::hash<std::string_view>{}(message);
+            if (!admit(hash, hash, level)) {
+                return true;
+            }
+        }
+        return logMessage(message, level);
+    }
+
+    bool Logger::logMessage(std::string_view message, LogLevel level) {
+        if (binary_records_.load(std::memory_order_relaxed)) {
+            binary::stageMessage(formatBuffer, message);
+            return logStaged(formatBuffer, level);
+        }
+
         if (!output_ || !output_->isValid()) {
             return false;
         }
 
+        StatsShard* shard = nullptr;
+        const int64_t started = startRecord(level, shard);
+        auto timestamp = std::chrono::system_clock::now();
+        const ConfigSnapshot& config = producerConfig();
+        // Поля контекста потока уже отрисованы: в запись копируются готовые байты
+        const std::string_view context = contextPrefix(config);
+
+        // Асинхронный режим: только кладём запись в очередь, форматирует и пишет рабочий поток.
+        // Контекст известен только здесь, поэтому ложится в запись перед сообщением
+        bool queued = false;
+        if (dispatchAsync(context, message, level, timestamp, false, queued)) {
+            finishRecord(shard, started);
+            return queued;
+        }
+
+        // Синхронный режим: форматируем в буфер своего потока без блокировки,
+        // под mutex_ остаётся только передача готовых строк выводу
+        formatBuffer.clear();
+        formatMessage(formatBuffer, context, message, level, timestamp, config);
+        bool written = combinedWrite(formatBuffer, level);
+        finishRecord(shard, started);
+        return written;
+    }
+
+    bool Logger::logStaged(std::string& staged, LogLevel level) {
+        if (!output_ || !output_->isValid()) {
+            return false;
+        }
+
+        StatsShard* shard = nullptr;
+        const int64_t started = startRecord(level, shard);
+        auto timestamp = std::chrono::system_clock::now();
+        auto ticks = std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch());
+        binary::finishStagedEvent(staged, static_cast<uint8_t>(level), static_cast<int64_t>(ticks.count()));
+
+        bool queued = false;
+        if (dispatchAsync(std::string_view(), staged, level, timestamp, true, queued)) {
+            finishRecord(shard, started);
+            return queued;
+        }
+        bool written = combinedWrite(staged, level, true);
+        finishRecord(shard, started);
+        return written;
+    }
+
+    bool Logger::dispatchAsync(std::string_view context, std::string_view payload, LogLevel level,
+                               const std::chrono::system_clock::time_point& timestamp,
+                               bool binary, bool& queued) {
+        // Счётчик async_producers_ позволяет stopAsyncWorker дождаться продюсеров,
+        // уже увидевших async_running_ == true, прежде чем выполнить финальный слив.
+        async_producers_.fetch_add(1, std::memory_order_seq_cst);
+        if (async_running_.load(std::memory_order_seq_cst)) {
+            queued = enqueueRecord(context, payload, level, timestamp, binary);
+            async_producers_.fetch_sub(1, std::memory_order_release);
+            return true;
+        }
+        async_producers_.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+
+    bool Logger::combinedWrite(std::string_view formattedMessage, LogLevel level, bool binary) {
+        PendingWrite request;
+        request.formattedMessage = formattedMessage;
+        request.level = level;
+        request.binary = binary;
+        request.next = pending_writes_.load(std::memory_order_relaxed);
+        while (!pending_writes_.compare_exchange_weak(request.next, &request,
+                                                      std::memory_order_release,
+                                                      std::memory_order_relaxed)) {
+        }
+
+        // Кто захватил mutex_, тот и пишет все накопившиеся запросы; остальные
+        // ждут, пока их запрос выполнит текущий комбинирующий поток
+        for (int spins = 0; !request.done.load(std::memory_order_acquire); ++spins) {
+            if (mutex_.try_lock()) {
+                drainPendingWrites();
+                mutex_.unlock();
+                continue;
+            }
+            if (spins >= kCombineSpinCount) {
+                std::this_thread::yield();
+            }
+        }
+        return request.result;
+    }
+
+    void Logger::drainPendingWrites() {
+        // Вызывается под mutex_
+        PendingWrite* stack = pending_writes_.exchange(nullptr, std::memory_order_acquire);
+        if (!stack) {
+            return;
+        }
+
+        // Стек хранит запросы в обратном порядке; разворачиваем, чтобы порядок
+        // записей совпадал с порядком публикации (и внутри каждого потока)
+        PendingWrite* batch = nullptr;
+        while (stack) {
+            PendingWrite* next = stack->next;
+            stack->next = batch;
+            batch = stack;
+            stack = next;
+        }
+
+        // Подряд идущие текстовые записи уходят выводу одной пачкой
+        bool needFlush = false;
+        PendingWrite* runStart = nullptr;
+        auto writeRun = [this, &runStart](PendingWrite* runEnd) {
+            bool ok = writeTextBatch(batch_views_.data(), batch_levels_.data(), batch_views_.size());
+            for (PendingWrite* request = runStart; request != runEnd; request = request->next) {
+                request->result = ok;
+            }
+            batch_views_.clear();
+            batch_levels_.clear();
+            runStart = nullptr;
+        };
+        for (PendingWrite* request = batch; request; request = request->next) {
+            if (request->binary) {
+                if (runStart) {
+                    writeRun(request);
+                }
+                request->result = writeBinaryRecord(request->formattedMessage);
+            } else {
+                if (!runStart) {
+                    runStart = request;
+                }
+                batch_views_.push_back(request->formattedMessage);
+                batch_levels_.push_back(request->level);
+            }
+            needFlush = needFlush || shouldFlush(request->level);
+        }
+        if (runStart) {
+            writeRun(nullptr);
+        }
+        // Один сброс на весь пакет вместо сброса после каждой важной записи
+        bool flushed = !needFlush || flushOutput(true);
+
+        while (batch) {
+            // После done владелец может сразу уничтожить запрос: next читаем раньше
+            PendingWrite* next = batch->next;
+            if (shouldFlush(batch->level)) {
+                batch->result = batch->result && flushed;
+            }
+            batch->done.store(true, std::memory_order_release);
+            batch = next;
+        }
+    }
+
+    bool Logger::shouldFlush(LogLevel level) {
+        // Вызывается под mutex_
+        return static_cast<int>(level) >= static_cast<int>(activeConfig().config.flushLevel);
+    }
+
+    bool Logger::flush() {
+        if (!output_) {
+            return false;
+        }
+        if (throttling_.load(std::memory_order_relaxed)) {
+            reportRepeats();
+            reportSuppressed();
+        }
+
+        // В асинхронном режиме ставим в очередь маркер и ждём, пока рабочий поток
+        // запишет всё, что было до него, и сбросит вывод
+        async_producers_.fetch_add(1, std::memory_order_seq_cst);
+        if (async_running_.load(std::memory_order_seq_cst)) {
+            std::promise<void> barrier;
+            std::future<void> done = barrier.get_future();
+            LogRecord marker;
+            marker.flushBarrier = &barrier;
+            while (!async_queue_->push(std::move(marker))) {
+                std::this_thread::yield();
+            }
+            async_producers_.fetch_sub(1, std::memory_order_release);
+            done.wait();
+            return flushLanes() && output_->isValid();
+        }
+        async_producers_.fetch_sub(1, std::memory_order_release);
+
+        bool flushed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            drainPendingWrites();
+            flushed = flushOutput();
+        }
+        return flushLanes() && flushed;
+    }
+
+    bool Logger::flushLanes() {
+        // Ждём выводы вне mutex_, чтобы медленный вывод не останавливал запись.
+        // Выводы не удаляются до деструктора, поэтому указатели остаются действительными.
+        std::vector<OutputLane*> lanes;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& lane : lanes_) {
+                lanes.push_back(lane.get());
+            }
+        }
+        bool ok = true;
+        for (OutputLane* lane : lanes) {
+            ok = lane->flush() && ok;
+        }
+        return ok;
+    }
+
+    bool Logger::enqueueRecord(std::string_view context, std::string_view payload, LogLevel level,
+                               const std::chrono::system_clock::time_point& timestamp, bool binary) {
+        // Запись копируется прямо в ячейку кольца: без промежуточного LogRecord и без
+        // выделения памяти, если сообщение помещается в RecordBuffer
+        auto fill = [&](LogRecord& record) {
+            record.message.assign(context, payload);
+            record.level = level;
+            record.timestamp = timestamp;
+            record.flushBarrier = nullptr;
+            record.binary = binary;
+        };
+        const OverflowPolicy policy = overflow_policy_.load(std::memory_order_relaxed);
+        const bool lowLevel = static_cast<int>(level) < static_cast<int>(LogLevel::WARNING);
+
+        // SAMPLE: при заполнении очереди на 3/4 пропускаем только каждую N-ю запись ниже WARNING
+        if (policy == OverflowPolicy::SAMPLE && lowLevel &&
+            async_queue_->size() >= async_queue_->capacity() / 4 * 3) {
+            size_t rate = overflow_sample_rate_.load(std::memory_order_relaxed);
+            if (overflow_sample_counter_.fetch_add(1, std::memory_order_relaxed) % rate != 0) {
+                recordDrop(level);
+                return false;
+            }
+        }
+
+        if (async_queue_->emplace(fill)) {
+            return true;
+        }
+
+        // Очередь заполнена: поведение определяется политикой переполнения
+        switch (policy) {
+            case OverflowPolicy::DROP_NEWEST:
+                recordDrop(level);
+                return false;
+
+            case OverflowPolicy::DROP_OLDEST: {
+                // Маркер flush() не вытесняется: завершить его может только рабочий поток,
+                // сбросив вывод. Извлечённый маркер возвращается в очередь раньше записи —
+                // тогда ожидающий flush() дождётся и всего, что было до него
+                std::vector<LogRecord> markers;
+                LogRecord oldest;
+                for (;;) {
+                    while (!markers.empty() && async_queue_->push(std::move(markers.front()))) {
+                        markers.erase(markers.begin());
+                    }
+                    if (markers.empty() && async_queue_->emplace(fill)) {
+                        return true;
+                    }
+                    if (!async_queue_->tryPop(oldest)) {
+                        continue;
+                    }
+                    if (oldest.flushBarrier) {
+                        markers.push_back(std::move(oldest));
+                        oldest = LogRecord();
+                    } else {
+                        recordDrop(oldest.level);
+                    }
+                }
+            }
+
+            case OverflowPolicy::SAMPLE:
+                if (lowLevel) {
+                    recordDrop(level);
+                    return false;
+                }
+                break; // WARNING и выше ждут места, как при BLOCK
+
+            case OverflowPolicy::BLOCK:
+                break;
+        }
+
+        // Ожидание освобождения места: сначала уступаем процессор, затем короткий сон
+        for (int attempt = 0; !async_queue_->emplace(fill); ++attempt) {
+            if (attempt < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+        return true;
+    }
+
+    void Logger::recordDrop(LogLevel level) {
+        size_t index = static_cast<size_t>(level);
+        auto now = std::chrono::system_clock::now();
+        dropped_[index].fetch_add(1, std::memory_order_relaxed);
+        last_drop_ns_[index].store(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count(),
+            std::memory_order_relaxed);
+
+        // Мьютекс сообщения об ошибке берём только при первом переполнении подряд
+        if (last_error_.load(std::memory_order_relaxed) != LoggingError::QUEUE_OVERFLOW) {
+            setError(LoggingError::QUEUE_OVERFLOW, "Async queue is full, records dropped");
+        }
+    }
+
+    void Logger::setError(LoggingError error, const std::string& message) {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        last_error_.store(error, std::memory_order_relaxed);
+        last_error_message_ = message;
+    }
+
+    bool Logger::writeBinaryRecord(std::string_view staged) {
+        // Вызывается под mutex_. Заголовок потока и определения форматов пишутся одним
+        // куском с событием, чтобы ротация не могла разделить их по разным сегментам.
+        const size_t eventOffset = binary::stagedEventOffset(staged);
+        std::string_view format = staged.substr(4, eventOffset - 4);
+        std::string_view event = staged.substr(eventOffset);
+        uint64_t id = binary::loadLE(event.data() + binary::kFrameHeaderSize + 1 + 8, 8);
+
+        binary_scratch_.clear();
+        uint64_t generation = output_->streamGeneration();
+        if (!binary_stream_started_ || generation != binary_generation_) {
+            binary_formats_.clear();
+            const size_t magicSize = sizeof(binary::kStreamMagic) - 1;
+            binary_scratch_.push_back(static_cast<char>(binary::kStreamTag));
+            binary::appendLE(binary_scratch_, magicSize + 1, 4);
+            binary_scratch_.append(binary::kStreamMagic, magicSize);
+            binary_scratch_.push_back(static_cast<char>(binary::kVersion));
+            binary_stream_started_ = true;
+            binary_generation_ = generation;
+        }
+        if (id != binary::kPlainMessageId && binary_formats_.insert(id).second) {
+            binary_scratch_.push_back(static_cast<char>(binary::kFormatTag));
+            binary::appendLE(binary_scratch_, 8 + format.size(), 4);
+            binary::appendLE(binary_scratch_, id, 8);
+            binary_scratch_.append(format);
+        }
+
+        std::string_view data = event;
+        if (!binary_scratch_.empty()) {
+            binary_scratch_.append(event);
+            data = binary_scratch_;
+        }
+        return writeToOutput(&data, nullptr, 1, true);
+    }
+
+    bool Logger::writeTextBatch(const std::string_view* records, const LogLevel* levels, size_t count) {
+        // Вызывается под mutex_
+        if (count == 0) {
+            return true;
+        }
+        bool written = writeToOutput(records, levels, count, false);
+        if (!lanes_.empty()) {
+            for (size_t i = 0; i < count; ++i) {
+                fanOut(records[i], levels[i]);
+            }
+        }
+        return written;
+    }
+
+    bool Logger::writeFormattedBatch() {
+        // Вызывается под mutex_: записи, отформатированные рабочим потоком в batch_text_
+        std::string_view text(batch_text_);
+        size_t start = 0;
+        for (size_t end : batch_ends_) {
+            batch_views_.push_back(text.substr(start, end - start));
+            start = end;
+        }
+        bool written = writeTextBatch(batch_views_.data(), batch_levels_.data(), batch_views_.size());
+        batch_text_.clear();
+        batch_ends_.clear();
+        batch_views_.clear();
+        batch_levels_.clear();
+        return written;
+    }
+
+    void Logger::fanOut(std::string_view formattedMessage, LogLevel level) {
+        // Вызывается под mutex_; текст уже отформатирован, выводам уходит его копия
+        for (auto& lane : lanes_) {
+            if (lane->accepts(level)) {
+                lane->push(formattedMessage, level);
+            }
+        }
+    }
+
+    bool Logger::addOutput(std::unique_ptr<LogOutput> output, LogLevel minLevel) {
+        if (!output) {
+            return false;
+        }
+        auto config = loadConfig();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (binary_records_.load(std::memory_order_relaxed)) {
+            setError(LoggingError::OUTPUT_NOT_SUPPORTED,
+                     "Дополнительные выводы не поддерживаются в двоичном формате");
+            return false;
+        }
+        lanes_.push_back(std::make_unique<OutputLane>(std::move(output), minLevel,
+                                                      config->config.asyncQueueSize,
+                                                      config->config.flushLevel,
+                                                      config->config.flushIntervalMs));
+        return true;
+    }
+
+    size_t Logger::getOutputCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lanes_.size();
+    }
+
+    void Logger::setOutputLevel(size_t index, LogLevel level) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (index < lanes_.size()) {
+            lanes_[index]->setMinLevel(level);
+        }
+    }
+
+    uint64_t Logger::getOutputDroppedCount(size_t index) const {
         std::lock_guard<std::mutex> lock(mutex_);
-        
-        std::string formattedMessage = formatMessage(message, level);
-        return output_->writeLog(formattedMessage);
+        return index < lanes_.size() ? lanes_[index]->droppedCount() : 0;
     }
 
-    bool Logger::log(const std::string& message) {
-        return log(message, defaultLevel_);
+    bool Logger::log(std::string_view message) {
+        return log(message, defaultLevel_.load(std::memory_order_relaxed));
     }
 
     void Logger::setDefaultLevel(LogLevel level) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        defaultLevel_ = level;
+        defaultLevel_.store(level, std::memory_order_relaxed);
     }
 
     LogLevel Logger::getDefaultLevel() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return defaultLevel_;
+        return defaultLevel_.load(std::memory_order_relaxed);
     }
 
     bool Logger::isValid() const {
@@ -180,14 +1088,244 @@ namespace logging {
     }
 
     LoggingError Logger::getLastError() const {
-        return last_error_;
+        return last_error_.load(std::memory_order_relaxed);
     }
 
     std::string Logger::getLastErrorMessage() const {
+        std::lock_guard<std::mutex> lock(error_mutex_);
         return last_error_message_;
     }
 
+    uint64_t Logger::getDroppedCount(LogLevel level) const {
+        return dropped_[static_cast<size_t>(level)].load(std::memory_order_relaxed);
+    }
+
+    uint64_t Logger::getDroppedCount() const {
+        uint64_t total = 0;
+        for (const auto& counter : dropped_) {
+            total += counter.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    std::chrono::system_clock::time_point Logger::getLastDropTime(LogLevel level) const {
+        int64_t ns = last_drop_ns_[static_cast<size_t>(level)].load(std::memory_order_relaxed);
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(ns)));
+    }
+
+    bool Logger::admit(uint64_t siteHash, uint64_t recordHash, LogLevel level) {
+        // Та же запись того же уровня, что и предыдущая: только считаем повтор.
+        // При конкурентной записи из разных потоков подсчёт приблизительный
+        if (collapse_repeats_.load(std::memory_order_relaxed)) {
+            const uint64_t key = recordHash ^ ((static_cast<uint64_t>(level) + 1) * 0x9e3779b97f4a7c15ULL);
+            if (last_record_key_.exchange(key, std::memory_order_relaxed) == key) {
+                repeat_count_.fetch_add(1, std::memory_order_relaxed);
+                suppressed_total_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            reportRepeats();
+            repeat_level_.store(level, std::memory_order_relaxed);
+        }
+
+        // GCRA: запись проходит, если «теоретическое время прихода» корзины опережает
+        // текущее не больше чем на burst; каждая прошедшая запись сдвигает его на interval
+        const int64_t interval = rate_interval_ns_.load(std::memory_order_relaxed);
+        if (interval == 0) {
+            return true;
+        }
+        RateSlot& slot = rate_slots_[siteHash & (kRateSlots - 1)];
+        const int64_t burst = rate_burst_ns_.load(std::memory_order_relaxed);
+        const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        int64_t expected = slot.next_ns.load(std::memory_order_relaxed);
+        for (;;) {
+            const int64_t next = std::max(expected, now) + interval;
+            if (next - now > burst) {
+                slot.level.store(level, std::memory_order_relaxed);
+                slot.suppressed.fetch_add(1, std::memory_order_relaxed);
+                suppressed_total_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (slot.next_ns.compare_exchange_weak(expected, next, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+
+        // Первая прошедшая после подавления запись сообщает, сколько было пропущено
+        uint64_t skipped = slot.suppressed.exchange(0, std::memory_order_relaxed);
+        if (skipped > 0) {
+            std::string note;
+            detail::formatTo(note, "{} similar messages suppressed by rate limit", skipped);
+            logMessage(note, slot.level.load(std::memory_order_relaxed));
+        }
+        return true;
+    }
+
+    void Logger::reportRepeats() {
+        uint64_t repeats = repeat_count_.exchange(0, std::memory_order_relaxed);
+        if (repeats > 0) {
+            std::string note;
+            detail::formatTo(note, "last message repeated {} times", repeats);
+            logMessage(note, repeat_level_.load(std::memory_order_relaxed));
+        }
+    }
+
+    void Logger::reportSuppressed() {
+        // Для мест вызова, которые замолчали, не дождавшись следующей пропущенной записи
+        for (size_t i = 0; i < kRateSlots; ++i) {
+            uint64_t skipped = rate_slots_[i].suppressed.exchange(0, std::memory_order_relaxed);
+            if (skipped > 0) {
+                std::string note;
+                detail::formatTo(note, "{} similar messages suppressed by rate limit", skipped);
+                logMessage(note, rate_slots_[i].level.load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+    uint64_t Logger::getSuppressedCount() const {
+        return suppressed_total_.load(std::memory_order_relaxed);
+    }
+
+    Logger::StatsShard* Logger::statsShard() {
+        // Несколько последних логгеров потока; промах — поиск под stats_mutex_,
+        // шарды живут до уничтожения логгера и не освобождаются с выходом потока
+        constexpr size_t kCachedLoggers = 4;
+        thread_local struct {
+            uint64_t loggerId[kCachedLoggers] = {};
+            StatsShard* shard[kCachedLoggers] = {};
+            size_t next = 0;
+        } cache;
+
+        for (size_t i = 0; i < kCachedLoggers; ++i) {
+            if (cache.loggerId[i] == instance_id_) {
+                return cache.shard[i];
+            }
+        }
+
+        const std::thread::id self = std::this_thread::get_id();
+        StatsShard* found = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            for (auto& shard : stats_shards_) {
+                if (shard->owner == self) {
+                    found = shard.get(); // поток вытеснен из кэша или занял id завершившегося
+                    break;
+                }
+            }
+            if (!found) {
+                stats_shards_.push_back(std::make_unique<StatsShard>());
+                found = stats_shards_.back().get();
+                found->owner = self;
+            }
+        }
+
+        cache.loggerId[cache.next] = instance_id_;
+        cache.shard[cache.next] = found;
+        cache.next = (cache.next + 1) % kCachedLoggers;
+        return found;
+    }
+
+    void Logger::countFiltered(LogLevel level) {
+        if (collect_stats_.load(std::memory_order_relaxed)) {
+            bump(statsShard()->filtered[static_cast<size_t>(level)]);
+        }
+    }
+
+    int64_t Logger::startRecord(LogLevel level, StatsShard*& shard) {
+        // Считается каждая запись, время — только у каждой kEnqueueSampleRate-й
+        if (!collect_stats_.load(std::memory_order_relaxed)) {
+            return 0;
+        }
+        shard = statsShard();
+        bump(shard->accepted[static_cast<size_t>(level)]);
+        return shard->calls++ % kEnqueueSampleRate == 0 ? steadyNowNs() : 0;
+    }
+
+    void Logger::finishRecord(StatsShard* shard, int64_t startedNs) {
+        if (shard && startedNs != 0) {
+            shard->latency.record(steadyNowNs() - startedNs);
+        }
+    }
+
+    bool Logger::writeToOutput(const std::string_view* records, const LogLevel* levels, size_t count, bool raw) {
+        // Вызывается под mutex_: единственная точка записи в основной вывод
+        StatsShard* stats = collect_stats_.load(std::memory_order_relaxed) ? writer_stats_.get() : nullptr;
+        if (!stats) {
+            return raw ? output_->writeRaw(records[0]) : output_->writeLeveledBatch(records, levels, count);
+        }
+
+        const int64_t started = stats->calls++ % kSinkSampleRate == 0 ? steadyNowNs() : 0;
+        bool written = raw ? output_->writeRaw(records[0]) : output_->writeLeveledBatch(records, levels, count);
+        if (started != 0) {
+            stats->latency.record(steadyNowNs() - started);
+        }
+
+        uint64_t bytes = raw ? 0 : count; // переводы строк текстовых записей
+        for (size_t i = 0; i < count; ++i) {
+            bytes += records[i].size();
+        }
+        bump(stats->bytes, bytes);
+        bump(stats->sinkWrites);
+        if (!written) {
+            bump(stats->writeErrors);
+        }
+        return written;
+    }
+
+    bool Logger::flushOutput(bool forLevel) {
+        // Вызывается под mutex_
+        if (writer_stats_ && collect_stats_.load(std::memory_order_relaxed)) {
+            bump(writer_stats_->flushes);
+        }
+        return forLevel ? output_->flushForLevel() : output_->flush();
+    }
+
+    LoggerStats Logger::getStats() const {
+        LoggerStats stats;
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            for (const auto& shard : stats_shards_) {
+                for (size_t i = 0; i < kLogLevelCount; ++i) {
+                    stats.accepted[i] += shard->accepted[i].load(std::memory_order_relaxed);
+                    stats.filtered[i] += shard->filtered[i].load(std::memory_order_relaxed);
+                }
+                shard->latency.addTo(stats.enqueueLatency);
+            }
+        }
+
+        // writer_stats_ создаётся в конструкторе и дальше не меняется
+        if (writer_stats_) {
+            stats.bytesWritten = writer_stats_->bytes.load(std::memory_order_relaxed);
+            stats.sinkWrites = writer_stats_->sinkWrites.load(std::memory_order_relaxed);
+            stats.writeErrors = writer_stats_->writeErrors.load(std::memory_order_relaxed);
+            stats.flushes = writer_stats_->flushes.load(std::memory_order_relaxed);
+            stats.queueHighWater = static_cast<size_t>(writer_stats_->queueHighWater.load(std::memory_order_relaxed));
+            writer_stats_->latency.addTo(stats.sinkWriteLatency);
+        }
+
+        for (size_t i = 0; i < kLogLevelCount; ++i) {
+            stats.dropped[i] = dropped_[i].load(std::memory_order_relaxed);
+        }
+        stats.suppressed = suppressed_total_.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(async_control_mutex_);
+        if (async_running_.load(std::memory_order_relaxed) && async_queue_) {
+            stats.queueDepth = async_queue_->size();
+            stats.queueCapacity = async_queue_->capacity();
+        }
+        return stats;
+    }
+
+    void Logger::resetDropCounters() {
+        for (size_t i = 0; i < kLogLevelCount; ++i) {
+            dropped_[i].store(0, std::memory_order_relaxed);
+            last_drop_ns_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
     void Logger::enableAsync(bool enable) {
+        std::lock_guard<std::mutex> lock(async_control_mutex_);
         if (enable && !async_running_) {
             startAsyncWorker();
         } else if (!enable && async_running_) {
@@ -195,40 +1333,235 @@ namespace logging {
         }
     }
 
+    void Logger::startAsyncWorker() {
+        if (async_running_) {
+            return;
+        }
+
+        size_t queueSize = loadConfig()->config.asyncQueueSize;
+
+        // Очередь создаётся заново при каждом запуске: после stopAsyncWorker она пуста
+        // и находится в состоянии shutdown
+        async_queue_ = std::make_unique<AsyncQueue<LogRecord>>(queueSize);
+        worker_state_.store(WorkerState::POPPING, std::memory_order_release); // поток сейчас начнёт pop()
+        async_worker_ = std::make_unique<std::thread>(&Logger::asyncWorkerLoop, this);
+        async_running_.store(true, std::memory_order_seq_cst);
+    }
+
+    void Logger::stopAsyncWorker() {
+        if (!async_running_) {
+            return;
+        }
+
+        // Новые вызовы log() пойдут синхронным путём; ждём тех, кто уже кладёт в очередь
+        async_running_.store(false, std::memory_order_seq_cst);
+        while (async_producers_.load(std::memory_order_acquire) != 0) {
+            std::this_thread::yield();
+        }
+
+        // Рабочий поток дописывает всё, что осталось в очереди, и завершается
+        async_queue_->shutdown();
+        if (async_worker_ && async_worker_->joinable()) {
+            async_worker_->join();
+        }
+        async_worker_.reset();
+    }
+
+    void Logger::asyncWorkerLoop() {
+        constexpr size_t kMaxBatch = 256;
+        LogRecord record;
+
+        const int flushIntervalMs = loadConfig()->config.flushIntervalMs;
+        worker_record_.store(&record, std::memory_order_release);
+
+        for (;;) {
+            worker_state_.store(WorkerState::POPPING, std::memory_order_release);
+            bool popped = flushIntervalMs > 0
+                ? async_queue_->pop(record, std::chrono::milliseconds(flushIntervalMs))
+                : async_queue_->pop(record);
+            worker_state_.store(popped ? WorkerState::HOLDING : WorkerState::IDLE, std::memory_order_release);
+
+            if (!popped) {
+                if (async_queue_->isShutdown()) {
+                    break;
+                }
+                // Простой дольше интервала: сбрасываем буфер, чтобы данные не залеживались
+                std::lock_guard<std::mutex> lock(mutex_);
+                flushOutput();
+                continue;
+            }
+
+            // Пачка форматируется подряд в batch_text_ и уходит выводу одним writeBatch
+            // под одним захватом мьютекса, сброс — один раз в конце пачки
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (worker_state_.exchange(WorkerState::IDLE, std::memory_order_acq_rel) == WorkerState::TAKEN &&
+                !async_queue_->tryPop(record)) {
+                continue; // пока ждали мьютекс, запись дописал emergencyFlush
+            }
+            if (writer_stats_ && collect_stats_.load(std::memory_order_relaxed)) {
+                // Глубина очереди вместе с только что извлечённой записью
+                const uint64_t depth = async_queue_->size() + 1;
+                if (depth > writer_stats_->queueHighWater.load(std::memory_order_relaxed)) {
+                    writer_stats_->queueHighWater.store(depth, std::memory_order_relaxed);
+                }
+            }
+            size_t written = 0;
+            bool needFlush = false;
+            std::promise<void>* barrier = nullptr;
+            do {
+                if (record.flushBarrier) {
+                    barrier = record.flushBarrier;
+                    break;
+                }
+                if (record.binary) {
+                    writeFormattedBatch(); // сохраняем порядок записей
+                    writeBinaryRecord(record.message.view());
+                } else {
+                    // Контекст производителя уже в начале сообщения записи
+                    formatMessage(batch_text_, std::string_view(), record.message.view(), record.level,
+                                  record.timestamp, activeConfig());
+                    batch_ends_.push_back(batch_text_.size());
+                    batch_levels_.push_back(record.level);
+                }
+                needFlush = needFlush || shouldFlush(record.level);
+            } while (++written < kMaxBatch && async_queue_->tryPop(record));
+            writeFormattedBatch();
+
+            if (needFlush || barrier) {
+                flushOutput(!barrier);
+            }
+            if (barrier) {
+                barrier->set_value();
+            }
+            // Ещё под mutex_: emergencyFlush, получив мьютекс, должен видеть, что поток
+            // сейчас извлечёт следующую запись
+            worker_state_.store(WorkerState::POPPING, std::memory_order_release);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        flushOutput();
+    }
+
     bool Logger::isAsyncEnabled() const {
         return async_running_;
     }
 
     void Logger::setConfig(const LoggerConfig& config) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        config_ = config;
-        defaultLevel_ = config.defaultLevel;
+        {
+            std::lock_guard<std::mutex> lock(config_mutex_);
+            publishConfig(config);
+            defaultLevel_.store(config.defaultLevel, std::memory_order_relaxed);
+        }
+        enableAsync(config.enableAsync);
     }
 
     LoggerConfig Logger::getConfig() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return config_;
+        LoggerConfig config = loadConfig()->config;
+        config.defaultLevel = defaultLevel_.load(std::memory_order_relaxed);
+        config.enableAsync = async_running_.load(std::memory_order_relaxed);
+        return config;
     }
 
-    std::string Logger::formatMessage(const std::string& message, LogLevel level) const {
-        std::ostringstream oss;
-        oss << "[" << getCurrentTime() << "] "
-            << "[" << logLevelToString(level) << "] "
-            << message;
-        return oss.str();
+    void Logger::publishConfig(const LoggerConfig& config) {
+        // Вызывается из конструктора или под config_mutex_
+        auto previous = loadConfig();
+        uint64_t formatId = previous && previous->config.timestampFormat == config.timestampFormat
+            ? previous->timestampFormatId
+            : nextTimestampFormatId.fetch_add(1, std::memory_order_relaxed);
+        uint64_t contextId = previous && previous->config.loggerName == config.loggerName &&
+                             previous->config.threadIdField == config.threadIdField
+            ? previous->contextFieldsId
+            : nextContextFieldsId.fetch_add(1, std::memory_order_relaxed);
+
+        auto snapshot = std::make_shared<const ConfigSnapshot>(ConfigSnapshot{config, formatId, contextId});
+        overflow_policy_.store(config.overflowPolicy, std::memory_order_relaxed);
+        collect_stats_.store(config.collectStats, std::memory_order_relaxed);
+        setCrashFlush(config.flushOnCrash);
+
+        // Интервал между записями одного места вызова и допустимый запас (burst) в наносекундах
+        const int64_t interval = config.rateLimitPerSecond > 0
+            ? std::max<int64_t>(1, 1000000000LL / static_cast<int64_t>(config.rateLimitPerSecond))
+            : 0;
+        const size_t burst = config.rateLimitBurst > 0 ? config.rateLimitBurst : config.rateLimitPerSecond;
+        rate_interval_ns_.store(interval, std::memory_order_relaxed);
+        rate_burst_ns_.store(interval * static_cast<int64_t>(burst), std::memory_order_relaxed);
+        collapse_repeats_.store(config.collapseRepeats, std::memory_order_relaxed);
+        throttling_.store(interval > 0 || config.collapseRepeats, std::memory_order_relaxed);
+
+        bool binary = config.recordFormat == RecordFormat::BINARY;
+        std::unique_lock<std::mutex> lock(mutex_); // согласованно с addOutput
+        if (!writer_stats_) {
+            writer_stats_ = std::make_unique<StatsShard>();
+        }
+        if (binary && (!(output_ && output_->supportsRaw()) || !lanes_.empty())) {
+            std::cerr << "Предупреждение: двоичный формат требует один файловый вывод, записи пишутся текстом"
+                      << std::endl;
+            binary = false;
+        }
+        binary_records_.store(binary, std::memory_order_relaxed);
+        lock.unlock();
+        overflow_sample_rate_.store(std::max<size_t>(config.overflowSampleRate, 1),
+                                    std::memory_order_relaxed);
+
+        std::atomic_store_explicit(&config_, std::move(snapshot), std::memory_order_release);
+        config_version_.fetch_add(1, std::memory_order_release);
     }
 
-    std::string Logger::getCurrentTime() const {
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now.time_since_epoch()) % 1000;
+    std::shared_ptr<const Logger::ConfigSnapshot> Logger::loadConfig() const {
+        return std::atomic_load_explicit(&config_, std::memory_order_acquire);
+    }
 
-        std::ostringstream oss;
-        oss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
-        oss << "." << std::setfill('0') << std::setw(3) << ms.count();
-        
-        return oss.str();
+    const Logger::ConfigSnapshot& Logger::producerConfig() const {
+        // Кэш снимка конфигурации в потоке производителя: atomic_load разделяемого
+        // указателя выполняется только при смене логгера или версии конфигурации
+        thread_local struct {
+            uint64_t loggerId = 0;
+            uint64_t version = 0;
+            std::shared_ptr<const ConfigSnapshot> snapshot;
+        } cache;
+
+        uint64_t version = config_version_.load(std::memory_order_acquire);
+        if (cache.loggerId != instance_id_ || cache.version != version || !cache.snapshot) {
+            cache.snapshot = loadConfig();
+            cache.loggerId = instance_id_;
+            cache.version = version;
+        }
+        return *cache.snapshot;
+    }
+
+    const Logger::ConfigSnapshot& Logger::activeConfig() {
+        // Вызывается под mutex_: обновляет копию пишущего, только если конфигурация менялась
+        uint64_t version = config_version_.load(std::memory_order_acquire);
+        if (version != active_config_version_ || !active_config_) {
+            active_config_ = loadConfig();
+            active_config_version_ = version;
+        }
+        return *active_config_;
+    }
+
+    void Logger::formatMessage(std::string& out, std::string_view context, std::string_view message,
+                               LogLevel level, const std::chrono::system_clock::time_point& timestamp,
+                               const ConfigSnapshot& config) const {
+        char time[160];
+        size_t timeLen = formatTimestamp(time, sizeof(time), timestamp, config);
+        const char* name = levelName(level);
+
+        // Дописывает к out: рабочий поток собирает пачку записей в одной строке
+        out.reserve(out.size() + timeLen + context.size() + message.size() + 16);
+        out.push_back('[');
+        out.append(time, timeLen);
+        out.append("] [", 3);
+        out.append(name);
+        out.append("] ", 2);
+        out.append(context);
+        out.append(message);
+    }
+
+    size_t Logger::formatTimestamp(char* buffer, size_t size,
+                                   const std::chrono::system_clock::time_point& timestamp,
+                                   const ConfigSnapshot& config) const {
+        return timestampCache.format(buffer, size, timestamp, config.config.timestampFormat,
+                                     config.timestampFormatId, config.config.timestampPrecision);
     }
 
-} 
+}
\ No newline at end of file
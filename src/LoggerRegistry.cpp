@@ -0,0 +1,223 @@
+#include "logging/Logger.h"
+#include <filesystem>
+#include <system_error>
+
+namespace logging {
+
+    namespace {
+
+        // Основной вывод логгера реестра: записи уходят в очередь общего вывода,
+        // в файл или сокет их пишет поток этой очереди. Записи идут со своим уровнем,
+        // и поток сам сбрасывает вывод после записей уровня flushLevel и выше
+        class SharedSinkOutput : public LogOutput {
+        public:
+            explicit SharedSinkOutput(std::shared_ptr<OutputLane> sink) : sink_(std::move(sink)) {}
+
+            // Без уровня (не через Logger) запись сброса не вызывает
+            bool writeLog(std::string_view formattedMessage) override {
+                return sink_->pushWait(formattedMessage, LogLevel::TRACE);
+            }
+
+            bool writeBatch(const std::string_view* records, size_t count) override {
+                bool ok = true;
+                for (size_t i = 0; i < count; ++i) {
+                    ok = sink_->pushWait(records[i], LogLevel::TRACE) && ok;
+                }
+                return ok;
+            }
+
+            bool writeLeveledBatch(const std::string_view* records, const LogLevel* levels, size_t count) override {
+                bool ok = true;
+                for (size_t i = 0; i < count; ++i) {
+                    ok = sink_->pushWait(records[i], levels[i]) && ok;
+                }
+                return ok;
+            }
+
+            bool isValid() const override { return sink_->output().isValid(); }
+
+            // Ждёт, пока поток вывода запишет всё, что было в очереди, и сбросит вывод
+            bool flush() override { return sink_->flush(); }
+
+            // Важную запись поток вывода сбросит сам: логгер его не ждёт
+            bool flushForLevel() override { return isValid(); }
+
+            bool emergencyWrite(const std::string_view* records, size_t count, bool raw) noexcept override {
+                return sink_->emergencyWrite(records, count, raw);
+            }
+
+        private:
+            std::shared_ptr<OutputLane> sink_;
+        };
+
+        // Ключ вывода: один файл под разными написаниями пути — один вывод
+        std::string sinkKey(const LoggerConfig& config) {
+            if (!config.filename.empty()) {
+                std::error_code ec;
+                std::filesystem::path path = std::filesystem::absolute(config.filename, ec);
+                return "file:" + (ec ? config.filename : path.lexically_normal().string());
+            }
+            if (!config.host.empty()) {
+                return "tcp:" + config.host + ":" + std::to_string(config.port);
+            }
+            return std::string();
+        }
+
+    }
+
+    // LazyOutput implementation
+    LazyOutput::LazyOutput(Factory factory, bool supportsRaw)
+        : factory_(std::move(factory)), supports_raw_(supportsRaw) {}
+
+    LogOutput* LazyOutput::open() {
+        LogOutput* output = output_.load(std::memory_order_acquire);
+        if (output || failed_.load(std::memory_order_relaxed)) {
+            return output;
+        }
+        std::lock_guard<std::mutex> lock(open_mutex_);
+        if (!owned_ && !failed_.load(std::memory_order_relaxed)) {
+            owned_ = factory_();
+            factory_ = nullptr;
+            if (owned_) {
+                output_.store(owned_.get(), std::memory_order_release);
+            } else {
+                failed_.store(true, std::memory_order_relaxed);
+            }
+        }
+        return owned_.get();
+    }
+
+    bool LazyOutput::writeLog(std::string_view formattedMessage) {
+        LogOutput* output = open();
+        return output && output->writeLog(formattedMessage);
+    }
+
+    bool LazyOutput::writeBatch(const std::string_view* records, size_t count) {
+        LogOutput* output = open();
+        return output && output->writeBatch(records, count);
+    }
+
+    bool LazyOutput::isValid() const {
+        LogOutput* output = output_.load(std::memory_order_acquire);
+        return output ? output->isValid() : !failed_.load(std::memory_order_relaxed);
+    }
+
+    bool LazyOutput::flush() {
+        LogOutput* output = output_.load(std::memory_order_acquire);
+        return output ? output->flush() : !failed_.load(std::memory_order_relaxed);
+    }
+
+    bool LazyOutput::writeRaw(std::string_view data) {
+        LogOutput* output = open();
+        return output && output->writeRaw(data);
+    }
+
+    uint64_t LazyOutput::streamGeneration() const {
+        LogOutput* output = output_.load(std::memory_order_acquire);
+        return output ? output->streamGeneration() : 0;
+    }
+
+    bool LazyOutput::emergencyWrite(const std::string_view* records, size_t count, bool raw) noexcept {
+        // Открывать вывод при падении нельзя (выделение памяти); до первой записи
+        // в нём и сбрасывать нечего
+        LogOutput* output = output_.load(std::memory_order_acquire);
+        if (!output) {
+            return count == 0;
+        }
+        return output->emergencyWrite(records, count, raw);
+    }
+
+    // LoggerRegistry implementation
+    LoggerRegistry& LoggerRegistry::instance() {
+        static LoggerRegistry registry;
+        return registry;
+    }
+
+    std::shared_ptr<Logger> LoggerRegistry::get(const std::string& name, const LoggerConfig& config) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = loggers_.find(name);
+        if (found != loggers_.end()) {
+            return found->second;
+        }
+
+        const std::string key = sinkKey(config);
+        if (key.empty()) {
+            return nullptr;
+        }
+        for (auto entry = sinks_.begin(); entry != sinks_.end();) {
+            entry = entry->second.expired() ? sinks_.erase(entry) : std::next(entry);
+        }
+        std::shared_ptr<OutputLane> sink = sinks_[key].lock();
+        if (!sink) {
+            // Вывод открывается первой записью, сокет подключается в фоне: регистрация
+            // логгера не ждёт ни диска, ни сборщика
+            LoggerConfig sinkConfig = config;
+            sinkConfig.lazyOpen = true;
+            sinkConfig.connectInBackground = true;
+            sink = std::make_shared<OutputLane>(createOutput(sinkConfig), LogLevel::TRACE,
+                                                config.asyncQueueSize, config.flushLevel, config.flushIntervalMs);
+            sinks_[key] = sink;
+        }
+
+        LoggerConfig loggerConfig = config;
+        if (loggerConfig.loggerName.empty()) {
+            loggerConfig.loggerName = name;
+        }
+        loggerConfig.enableAsync = false;   // фоновый поток — у общего вывода
+        loggerConfig.recordFormat = RecordFormat::TEXT;
+        auto logger = std::make_shared<Logger>(std::make_unique<SharedSinkOutput>(std::move(sink)), loggerConfig);
+        loggers_.emplace(name, logger);
+        return logger;
+    }
+
+    std::shared_ptr<Logger> LoggerRegistry::find(const std::string& name) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = loggers_.find(name);
+        return found != loggers_.end() ? found->second : nullptr;
+    }
+
+    void LoggerRegistry::remove(const std::string& name) {
+        std::shared_ptr<Logger> logger;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto found = loggers_.find(name);
+            if (found == loggers_.end()) {
+                return;
+            }
+            logger = std::move(found->second);
+            loggers_.erase(found);
+        }
+        // Если ссылка была последней, логгер (и вывод) закрывается вне блокировки реестра
+    }
+
+    void LoggerRegistry::clear() {
+        std::unordered_map<std::string, std::shared_ptr<Logger>> loggers;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            loggers.swap(loggers_);
+        }
+        // Выводы остаются в sinks_, пока ими пользуются логгеры, взятые до clear():
+        // новый логгер с тем же выводом пишет через тот же поток, а не вторым писателем
+    }
+
+    size_t LoggerRegistry::size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return loggers_.size();
+    }
+
+    bool LoggerRegistry::flushAll() {
+        std::vector<std::shared_ptr<Logger>> loggers;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& entry : loggers_) {
+                loggers.push_back(entry.second);
+            }
+        }
+        bool ok = true;
+        for (const auto& logger : loggers) {
+            ok = logger->flush() && ok;
+        }
+        return ok;
+    }
+
+}
@@ -0,0 +1,375 @@
+#include "logging/Logger.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace logging {
+
+    namespace {
+
+        // Размер сегмента, если в конфигурации он не задан
+        constexpr size_t kDefaultSegmentSizeMB = 64;
+
+        // Хвост открытого сегмента: сигнатура и длина записанных данных. При закрытии
+        // файл усекается до данных вместе с ним, поэтому хвост есть только у файла,
+        // оставшегося после аварийного завершения
+        constexpr char kTrailerMagic[8] = {'L', 'O', 'G', 'M', 'M', 'A', 'P', '1'};
+        constexpr size_t kTrailerSize = sizeof(kTrailerMagic) + sizeof(uint64_t);
+
+        // Длина данных помещается в хвост, начиная с границы 8 байт
+        size_t alignTrailer(size_t size) {
+            return (size + 7) / 8 * 8;
+        }
+
+        // Размер данных в существующем файле: длина из хвоста, если он есть, иначе
+        // весь файл. По нулевым байтам конец не угадывается: двоичная запись может
+        // ими заканчиваться
+        size_t existingDataSize(int fd) {
+            struct stat st{};
+            if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+                return 0;
+            }
+            const size_t size = static_cast<size_t>(st.st_size);
+            if (size < kTrailerSize) {
+                return size;
+            }
+
+            char trailer[kTrailerSize];
+            if (pread(fd, trailer, kTrailerSize, static_cast<off_t>(size - kTrailerSize)) !=
+                    static_cast<ssize_t>(kTrailerSize) ||
+                std::memcmp(trailer, kTrailerMagic, sizeof(kTrailerMagic)) != 0) {
+                return size;
+            }
+            uint64_t length = 0;
+            std::memcpy(&length, trailer + sizeof(kTrailerMagic), sizeof(length));
+            return std::min<size_t>(length, size - kTrailerSize);
+        }
+
+        // Размер файла ровно capacity с заранее выделенными блоками (если ФС умеет)
+        bool preallocate(int fd, size_t capacity) {
+            if (ftruncate(fd, static_cast<off_t>(capacity)) != 0) {
+                return false;
+            }
+            if (fallocate(fd, 0, 0, static_cast<off_t>(capacity)) != 0 &&
+                errno != EOPNOTSUPP && errno != ENOSYS) {
+                return false;
+            }
+            return true;
+        }
+
+    }
+
+    // MappedFileOutput implementation
+    MappedFileOutput::MappedFileOutput(const std::string& filename, size_t segment_size_mb, size_t max_files,
+                                       bool compress, int flushIntervalMs, bool rotate)
+        : filename_(filename),
+          segment_size_((segment_size_mb > 0 ? segment_size_mb : kDefaultSegmentSizeMB) * 1024 * 1024),
+          flush_interval_(std::max(flushIntervalMs, 0)) {
+        if (rotate) {
+            rotator_ = std::make_unique<LogRotator>(filename, segment_size_ / (1024 * 1024), max_files, compress);
+        }
+
+        std::unique_lock<std::shared_mutex> lock(segment_mutex_);
+        if (!openSegment()) {
+            std::cerr << "Ошибка: не удалось отобразить файл журнала: " << filename_ << std::endl;
+        }
+        lock.unlock();
+
+        flusher_ = std::thread(&MappedFileOutput::flusherLoop, this);
+    }
+
+    MappedFileOutput::~MappedFileOutput() {
+        {
+            std::lock_guard<std::mutex> lock(flusher_mutex_);
+            stopping_ = true;
+        }
+        flusher_cv_.notify_all();
+        if (flusher_.joinable()) {
+            flusher_.join();
+        }
+
+        std::unique_lock<std::shared_mutex> lock(segment_mutex_);
+        if (data_) {
+            msync(data_, usedSize(), MS_SYNC);
+        }
+        closeSegment();
+    }
+
+    bool MappedFileOutput::openSegment() {
+        // Вызывается под исключительной блокировкой segment_mutex_
+        for (;;) {
+            fd_ = ::open(filename_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+            if (fd_ < 0) {
+                return false;
+            }
+
+            size_t used = existingDataSize(fd_);
+            if (rotator_ && used >= segment_size_ - kTrailerSize) {
+                // Оставшийся с прошлого запуска полный сегмент сразу уходит в ротацию
+                if (ftruncate(fd_, static_cast<off_t>(used)) != 0) {
+                    std::cerr << "Ошибка усечения журнала " << filename_ << std::endl;
+                }
+                close(fd_);
+                fd_ = -1;
+                if (!rotator_->rotate()) {
+                    return false;
+                }
+                continue;
+            }
+
+            // capacity — место под данные, за ним в отображении лежит хвост
+            size_t capacity = rotator_ ? segment_size_ - kTrailerSize : alignTrailer(used + segment_size_);
+            void* mapping = MAP_FAILED;
+            if (preallocate(fd_, capacity + kTrailerSize)) {
+                mapping = mmap(nullptr, capacity + kTrailerSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+            }
+            if (mapping == MAP_FAILED) {
+                if (ftruncate(fd_, static_cast<off_t>(used)) != 0) {
+                    std::cerr << "Ошибка усечения журнала " << filename_ << std::endl;
+                }
+                close(fd_);
+                fd_ = -1;
+                return false;
+            }
+
+            data_ = static_cast<char*>(mapping);
+            capacity_ = capacity;
+            cursor_.store(used, std::memory_order_relaxed);
+            sealed_size_.store(SIZE_MAX, std::memory_order_relaxed);
+            writeTrailer(used);
+            return true;
+        }
+    }
+
+    void MappedFileOutput::writeTrailer(size_t used) {
+        // Вызывается под исключительной блокировкой после отображения сегмента
+        std::memcpy(data_ + capacity_, kTrailerMagic, sizeof(kTrailerMagic));
+        __atomic_store_n(trailerLength(), static_cast<uint64_t>(used), __ATOMIC_RELAXED);
+    }
+
+    uint64_t* MappedFileOutput::trailerLength() const {
+        return reinterpret_cast<uint64_t*>(data_ + capacity_ + sizeof(kTrailerMagic));
+    }
+
+    void MappedFileOutput::commit(size_t end) noexcept {
+        // Записи копируются параллельно и завершаются в любом порядке: длина в хвосте
+        // только растёт. После падения процесса страница с хвостом остаётся в кэше
+        uint64_t* length = trailerLength();
+        uint64_t current = __atomic_load_n(length, __ATOMIC_RELAXED);
+        while (current < end &&
+               !__atomic_compare_exchange_n(length, &current, static_cast<uint64_t>(end), true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        }
+    }
+
+    void MappedFileOutput::closeSegment() {
+        // Вызывается под исключительной блокировкой: файл усекается до записанных данных
+        size_t used = usedSize();
+        if (data_) {
+            munmap(data_, capacity_ + kTrailerSize);
+            data_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            if (ftruncate(fd_, static_cast<off_t>(used)) != 0) {
+                std::cerr << "Ошибка усечения журнала " << filename_ << std::endl;
+            }
+            close(fd_);
+            fd_ = -1;
+        }
+        capacity_ = 0;
+    }
+
+    bool MappedFileOutput::extendSegment(size_t needed) {
+        // Вызывается под исключительной блокировкой, когда резервирование вышло за сегмент
+        if (rotator_) {
+            closeSegment();
+            rotator_->rotate();
+            bool ok = openSegment();
+            generation_.fetch_add(1, std::memory_order_release);
+            return ok;
+        }
+
+        // Без ротации файл растёт ещё на сегмент, смещения записей не меняются
+        size_t used = usedSize();
+        size_t capacity = alignTrailer(std::max(capacity_ + segment_size_, used + needed));
+        void* mapping = MAP_FAILED;
+        if (preallocate(fd_, capacity + kTrailerSize)) {
+            mapping = mremap(data_, capacity_ + kTrailerSize, capacity + kTrailerSize, MREMAP_MAYMOVE);
+        }
+        if (mapping == MAP_FAILED) {
+            std::cerr << "Ошибка расширения журнала " << filename_ << std::endl;
+            return false;
+        }
+
+        // Старый хвост оказывается за концом данных и будет перезаписан записями
+        data_ = static_cast<char*>(mapping);
+        capacity_ = capacity;
+        cursor_.store(used, std::memory_order_relaxed);
+        sealed_size_.store(SIZE_MAX, std::memory_order_relaxed);
+        writeTrailer(used);
+        return true;
+    }
+
+    size_t MappedFileOutput::usedSize() const {
+        return std::min({cursor_.load(std::memory_order_relaxed),
+                         sealed_size_.load(std::memory_order_relaxed), capacity_});
+    }
+
+    bool MappedFileOutput::append(const std::string_view* parts, size_t count, bool newline) {
+        // Все части резервируются одним fetch_add и лежат в файле подряд
+        size_t size = 0;
+        for (size_t i = 0; i < count; ++i) {
+            size += parts[i].size() + (newline ? 1 : 0);
+        }
+        if (size == 0) {
+            return true;
+        }
+        if (rotator_ && size > segment_size_ - kTrailerSize) {
+            if (count == 1) {
+                return false; // запись не помещается даже в пустой сегмент
+            }
+            // Пачка больше сегмента: пишем по одной, сегменты сменятся между записями
+            bool ok = true;
+            for (size_t i = 0; i < count; ++i) {
+                ok = append(parts + i, 1, newline) && ok;
+            }
+            return ok;
+        }
+
+        for (;;) {
+            std::shared_lock<std::shared_mutex> lock(segment_mutex_);
+            if (!data_) {
+                return false;
+            }
+
+            const size_t offset = cursor_.fetch_add(size, std::memory_order_relaxed);
+            if (offset + size <= capacity_) {
+                char* destination = data_ + offset;
+                for (size_t i = 0; i < count; ++i) {
+                    std::memcpy(destination, parts[i].data(), parts[i].size());
+                    destination += parts[i].size();
+                    if (newline) {
+                        *destination++ = '\n';
+                    }
+                }
+                commit(offset + size);
+                return true;
+            }
+
+            // Первое не поместившееся резервирование отмечает конец данных сегмента;
+            // следующие начинаются ещё дальше, поэтому такой поток ровно один
+            if (offset <= capacity_) {
+                sealed_size_.store(offset, std::memory_order_relaxed);
+            }
+            lock.unlock();
+
+            std::unique_lock<std::shared_mutex> exclusive(segment_mutex_);
+            if (data_ && sealed_size_.load(std::memory_order_relaxed) != SIZE_MAX) {
+                if (!extendSegment(size)) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    bool MappedFileOutput::writeLog(std::string_view formattedMessage) {
+        return append(&formattedMessage, 1, true);
+    }
+
+    bool MappedFileOutput::writeRaw(std::string_view data) {
+        return append(&data, 1, false);
+    }
+
+    bool MappedFileOutput::writeBatch(const std::string_view* records, size_t count) {
+        return append(records, count, true);
+    }
+
+    bool MappedFileOutput::emergencyWrite(const std::string_view* records, size_t count, bool raw) noexcept {
+        // Записанное уже в страничном кэше и переживёт процесс. Новые записи копируются
+        // в отображение без блокировки, пока хватает места в текущем сегменте
+        if (!data_) {
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            const size_t size = records[i].size() + (raw ? 0 : 1);
+            const size_t offset = cursor_.fetch_add(size, std::memory_order_relaxed);
+            if (offset + size > capacity_) {
+                if (offset <= capacity_) {
+                    sealed_size_.store(offset, std::memory_order_relaxed);
+                }
+                return false;
+            }
+            std::memcpy(data_ + offset, records[i].data(), records[i].size());
+            if (!raw) {
+                data_[offset + size - 1] = '\n';
+            }
+            commit(offset + size);
+        }
+        return true;
+    }
+
+    bool MappedFileOutput::isValid() const {
+        std::shared_lock<std::shared_mutex> lock(segment_mutex_);
+        return data_ != nullptr;
+    }
+
+    bool MappedFileOutput::flush() {
+        // Данные уже в страничном кэше и переживут падение процесса;
+        // msync на диск выполняет фоновый поток, здесь его только будим
+        {
+            std::lock_guard<std::mutex> lock(flusher_mutex_);
+            flush_requested_ = true;
+        }
+        flusher_cv_.notify_one();
+        return isValid();
+    }
+
+    void MappedFileOutput::flusherLoop() {
+        const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        uint64_t generation = generation_.load(std::memory_order_acquire);
+        size_t synced = 0;
+
+        std::unique_lock<std::mutex> lock(flusher_mutex_);
+        while (!stopping_) {
+            auto wake = [this] { return stopping_ || flush_requested_; };
+            if (flush_interval_.count() > 0) {
+                flusher_cv_.wait_for(lock, flush_interval_, wake);
+            } else {
+                flusher_cv_.wait(lock, wake);
+            }
+            if (stopping_) {
+                break;
+            }
+            flush_requested_ = false;
+            lock.unlock();
+
+            {
+                std::shared_lock<std::shared_mutex> segment(segment_mutex_);
+                if (data_) {
+                    uint64_t current = generation_.load(std::memory_order_acquire);
+                    if (current != generation) {
+                        generation = current; // новый сегмент: старый уже закрыт и передан ротации
+                        synced = 0;
+                    }
+                    size_t end = usedSize();
+                    if (end > synced) {
+                        size_t start = synced / pageSize * pageSize;
+                        msync(data_ + start, end - start, MS_SYNC);
+                        synced = end;
+                        // Хвост с длиной — вслед за данными
+                        size_t trailer = capacity_ / pageSize * pageSize;
+                        msync(data_ + trailer, capacity_ + kTrailerSize - trailer, MS_SYNC);
+                    }
+                }
+            }
+
+            lock.lock();
+        }
+    }
+
+}
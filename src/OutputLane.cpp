@@ -0,0 +1,133 @@
+#include "logging/Logger.h"
+#include <algorithm>
+
+namespace logging {
+
+    // OutputLane implementation
+    OutputLane::OutputLane(std::unique_ptr<LogOutput> output, LogLevel minLevel, size_t queueSize,
+                           LogLevel flushLevel, int flushIntervalMs)
+        : output_(std::move(output)), min_level_(minLevel), flush_level_(flushLevel),
+          flush_interval_(std::max(flushIntervalMs, 0)), queue_(queueSize) {
+        worker_ = std::thread(&OutputLane::workerLoop, this);
+    }
+
+    OutputLane::~OutputLane() {
+        // Рабочий поток дописывает очередь до конца и завершается
+        queue_.shutdown();
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
+
+    bool OutputLane::push(std::string_view formattedMessage, LogLevel level) {
+        // Переполненная очередь означает, что вывод не успевает: запись теряется,
+        // но остальные выводы и сам логгер не ждут
+        bool queued = queue_.emplace([&](LogRecord& record) {
+            record.message.assign(formattedMessage);
+            record.level = level;
+            record.flushBarrier = nullptr;
+        });
+        if (!queued) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    bool OutputLane::pushWait(std::string_view formattedMessage, LogLevel level) {
+        // Основной вывод нескольких логгеров (LoggerRegistry) не теряет записи: ждём места
+        while (!queue_.emplace([&](LogRecord& record) {
+            record.message.assign(formattedMessage);
+            record.level = level;
+            record.flushBarrier = nullptr;
+        })) {
+            if (queue_.isShutdown()) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    bool OutputLane::flush() {
+        std::promise<void> barrier;
+        std::future<void> done = barrier.get_future();
+        LogRecord marker;
+        marker.flushBarrier = &barrier;
+        while (!queue_.push(std::move(marker))) {
+            if (queue_.isShutdown()) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        done.wait();
+        return output_->isValid();
+    }
+
+    bool OutputLane::emergencyDrain() noexcept {
+        // Рабочий поток может в это время писать сам: аварийный сброс — лучшее из возможного
+        bool ok = output_->emergencyWrite(nullptr, 0, false);
+        while (queue_.tryConsume([&](LogRecord& record) {
+            if (record.flushBarrier) {
+                return; // маркер flush() без set_value(): он не async-signal-safe
+            }
+            std::string_view text = record.message.view();
+            ok = output_->emergencyWrite(&text, 1, false) && ok;
+        })) {
+        }
+        return ok;
+    }
+
+    bool OutputLane::emergencyWrite(const std::string_view* records, size_t count, bool raw) noexcept {
+        bool ok = emergencyDrain();
+        return (count == 0 || output_->emergencyWrite(records, count, raw)) && ok;
+    }
+
+    void OutputLane::workerLoop() {
+        constexpr size_t kMaxBatch = 256;
+        LogRecord record;
+        for (;;) {
+            bool popped = flush_interval_.count() > 0
+                ? queue_.pop(record, flush_interval_)
+                : queue_.pop(record);
+
+            if (!popped) {
+                if (queue_.isShutdown()) {
+                    break;
+                }
+                output_->flush(); // простой: не держим данные в буфере вывода
+                continue;
+            }
+
+            // Всё, что уже накопилось в очереди (до маркера flush), уходит одним writeBatch
+            std::promise<void>* barrier = nullptr;
+            bool needFlush = false;
+            do {
+                if (record.flushBarrier) {
+                    barrier = record.flushBarrier;
+                    break;
+                }
+                needFlush = needFlush || static_cast<int>(record.level) >= static_cast<int>(flush_level_);
+                batch_.push_back(std::move(record));
+            } while (batch_.size() < kMaxBatch && queue_.tryPop(record));
+
+            for (const auto& queued : batch_) {
+                views_.push_back(queued.message.view());
+            }
+            if (!views_.empty()) {
+                output_->writeBatch(views_.data(), views_.size());
+            }
+            views_.clear();
+            batch_.clear();
+
+            if (needFlush || barrier) {
+                output_->flush();
+            }
+            if (barrier) {
+                barrier->set_value();
+            }
+        }
+        output_->flush();
+    }
+
+}
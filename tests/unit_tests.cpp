@@ -8,6 +8,20 @@
 #include <filesystem>
 #include <chrono>
 #include <functional>
+#include <atomic>
+#include <regex>
+#include <mutex>
+#include <condition_variable>
+#include <cstdlib>
+#include <new>
+#include <csignal>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
 
 
  // Простой фреймворк для тестирования
@@ -81,6 +95,41 @@ size_t countLines(const std::string& content) {
 }
 
 
+//  Счётчик выделений памяти: проверка, что асинхронная запись обходится без malloc
+
+std::atomic<bool> countAllocations{false};
+std::atomic<size_t> allocationCount{0};
+
+// Замена глобальных new/delete поверх malloc/free — GCC принимает её за путаницу
+// new-выражения с free() в каждой точке встраивания
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size) {
+    if (countAllocations.load(std::memory_order_relaxed)) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* memory = std::malloc(size > 0 ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+
 //  Удаление тестового файла
  
 void cleanupFile(const std::string& filename) {
@@ -329,7 +378,7 @@ void testStressMultithreading() {
     cleanupFile(testFile);
     
     {
-        logging::Logger logger(testFile, logging::LogLevel::INFO);
+        logging::Logger logger(testFile, logging::LogLevel::DEBUG);
         
         const int numThreads = 20;
         const int messagesPerThread = 100;
@@ -489,6 +538,1929 @@ void testTimestampFormatting() {
     cleanupFile(testFile);
 }
 
+
+ // Тест асинхронного логирования из нескольких потоков
+
+void testAsyncLogging() {
+    const std::string testFile = "test_async.log";
+    cleanupFile(testFile);
+    
+    {
+        logging::Logger logger(testFile, logging::LogLevel::INFO);
+        logger.enableAsync();
+        ASSERT(logger.isAsyncEnabled(), "Асинхронный режим должен быть включен");
+        
+        const int numThreads = 8;
+        const int messagesPerThread = 500;
+        std::vector<std::thread> threads;
+        
+        for (int i = 0; i < numThreads; ++i) {
+            threads.emplace_back([&logger, i, messagesPerThread]() {
+                for (int j = 0; j < messagesPerThread; ++j) {
+                    logger.info("Async thread " + std::to_string(i) + " message " + std::to_string(j));
+                }
+            });
+        }
+        
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        // Деструктор должен дописать всё, что осталось в очереди
+    }
+    
+    std::string content = readFile(testFile);
+    ASSERT(countLines(content) == 4000, "Все асинхронные сообщения должны быть записаны");
+    ASSERT(content.find("Async thread 7 message 499") != std::string::npos,
+           "Последнее сообщение должно быть в файле");
+    
+    cleanupFile(testFile);
+}
+
+
+ // Тест переключения между синхронным и асинхронным режимами
+
+void testAsyncToggle() {
+    const std::string testFile = "test_async_toggle.log";
+    cleanupFile(testFile);
+    
+    {
+        logging::Logger logger(testFile, logging::LogLevel::INFO);
+        logger.info("Sync message 1");
+        
+        logger.enableAsync(true);
+        for (int i = 0; i < 100; ++i) {
+            logger.info("Async message " + std::to_string(i));
+        }
+        
+        // Выключение асинхронного режима дожидается записи очереди
+        logger.enableAsync(false);
+        ASSERT(!logger.isAsyncEnabled(), "Асинхронный режим должен быть выключен");
+        ASSERT(countLines(readFile(testFile)) == 101, "Очередь должна быть записана при выключении");
+        
+        logger.info("Sync message 2");
+    }
+    
+    std::string content = readFile(testFile);
+    ASSERT(countLines(content) == 102, "Должны быть записаны все сообщения");
+    ASSERT(content.find("Async message 99") < content.find("Sync message 2"),
+           "Порядок сообщений должен сохраняться");
+    
+    cleanupFile(testFile);
+}
+
+
+ // Файловый вывод с буфером 1 MB и задержкой каждой пачки: рабочий поток логгера
+ // не успевает за производителями
+class SlowFileOutput : public logging::LogOutput {
+private:
+    logging::FileOutput file_;
+
+public:
+    explicit SlowFileOutput(const std::string& filename) : file_(filename, 1024 * 1024, 0) {}
+    bool writeLog(std::string_view formattedMessage) override { return writeBatch(&formattedMessage, 1); }
+    bool writeBatch(const std::string_view* records, size_t count) override {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        return file_.writeBatch(records, count);
+    }
+    bool isValid() const override { return file_.isValid(); }
+    bool flush() override { return file_.flush(); }
+};
+
+ // Тест политик переполнения асинхронной очереди
+
+void testAsyncOverflowPolicies() {
+    const std::string testFile = "test_async_overflow.log";
+    const int numMessages = 20000;
+    
+    // BLOCK: ни одно сообщение не теряется даже при крошечной очереди
+    cleanupFile(testFile);
+    {
+        logging::Logger logger(testFile, logging::LogLevel::INFO);
+        logging::LoggerConfig config;
+        config.enableAsync = true;
+        config.asyncQueueSize = 2;
+        config.overflowPolicy = logging::OverflowPolicy::BLOCK;
+        logger.setConfig(config);
+        
+        for (int i = 0; i < numMessages; ++i) {
+            ASSERT(logger.info("Block message " + std::to_string(i)), "BLOCK не должен отбрасывать сообщения");
+        }
+        ASSERT(logger.getDroppedCount() == 0, "При BLOCK счётчик потерь должен быть нулевым");
+    }
+    ASSERT(countLines(readFile(testFile)) == static_cast<size_t>(numMessages), "Все сообщения должны быть записаны");
+    
+    // DROP_NEWEST: принятые + отброшенные = отправленные, ошибка QUEUE_OVERFLOW при потерях
+    cleanupFile(testFile);
+    size_t accepted = 0;
+    uint64_t dropped = 0;
+    {
+        logging::Logger logger(testFile, logging::LogLevel::DEBUG);
+        logging::LoggerConfig config;
+        config.defaultLevel = logging::LogLevel::DEBUG;
+        config.enableAsync = true;
+        config.asyncQueueSize = 2;
+        config.overflowPolicy = logging::OverflowPolicy::DROP_NEWEST;
+        logger.setConfig(config);
+        
+        for (int i = 0; i < numMessages; ++i) {
+            if (logger.debug("Drop message " + std::to_string(i))) {
+                accepted++;
+            }
+        }
+        dropped = logger.getDroppedCount(logging::LogLevel::DEBUG);
+        ASSERT(logger.getDroppedCount(logging::LogLevel::INFO) == 0, "Потери INFO должны быть нулевыми");
+        ASSERT(accepted + dropped == static_cast<size_t>(numMessages), "Каждое сообщение либо принято, либо учтено как потерянное");
+        if (dropped > 0) {
+            ASSERT(logger.getLastError() == logging::LoggingError::QUEUE_OVERFLOW, "Должна быть установлена ошибка QUEUE_OVERFLOW");
+            ASSERT(logger.getLastDropTime(logging::LogLevel::DEBUG).time_since_epoch().count() > 0,
+                   "Время последней потери должно быть записано");
+        }
+    }
+    ASSERT(countLines(readFile(testFile)) == accepted, "В файле должны быть только принятые сообщения");
+    
+    // DROP_OLDEST: вытесненный маркер flush() не завершается раньше сброса вывода —
+    // всё, что рабочий поток записал до вызова flush(), после него уже в файле.
+    // Медленный вывод держит очередь полной, и производители вытесняют маркер
+    cleanupFile(testFile);
+    {
+        logging::LoggerConfig config;
+        config.enableAsync = true;
+        config.asyncQueueSize = 2;
+        config.overflowPolicy = logging::OverflowPolicy::DROP_OLDEST;
+        config.flushLevel = logging::LogLevel::FATAL;
+        logging::Logger logger(std::make_unique<SlowFileOutput>(testFile), config);
+        
+        std::atomic<bool> stop{false};
+        std::vector<std::thread> storm;
+        for (int t = 0; t < 4; ++t) {
+            storm.emplace_back([&] {
+                for (int i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+                    logger.info("Oldest message {}", i);
+                }
+            });
+        }
+        bool durable = true;
+        for (int i = 0; i < 500 && durable; ++i) {
+            const uint64_t written = logger.getStats().bytesWritten;
+            ASSERT(logger.flush(), "Сброс должен пройти успешно");
+            durable = std::filesystem::file_size(testFile) >= written;
+        }
+        stop.store(true, std::memory_order_relaxed);
+        for (auto& thread : storm) {
+            thread.join();
+        }
+        ASSERT(durable, "После flush() записанное рабочим потоком должно быть в файле");
+    }
+    
+    cleanupFile(testFile);
+}
+
+
+ // Тест буферизованной записи в файл и явного сброса
+
+void testBufferedFileOutput() {
+    const std::string testFile = "test_buffered.log";
+    cleanupFile(testFile);
+    
+    {
+        logging::LoggerConfig config;
+        config.fileBufferSize = 1024 * 1024;
+        config.flushIntervalMs = 0;
+        config.flushLevel = logging::LogLevel::WARNING;
+        logging::Logger logger(testFile, config);
+        ASSERT(logger.isValid(), "Логгер должен быть валидным");
+        
+        for (int i = 0; i < 100; ++i) {
+            logger.info("Buffered message " + std::to_string(i));
+        }
+        ASSERT(countLines(readFile(testFile)) == 0, "INFO сообщения должны оставаться в буфере");
+        
+        // WARNING сбрасывает буфер сразу
+        logger.warning("Flushing warning");
+        ASSERT(countLines(readFile(testFile)) == 101, "WARNING должен сбросить буфер");
+        
+        for (int i = 0; i < 10; ++i) {
+            logger.info("Tail message " + std::to_string(i));
+        }
+        ASSERT(logger.flush(), "Явный сброс должен пройти успешно");
+        ASSERT(countLines(readFile(testFile)) == 111, "flush() должен записать остаток буфера");
+        
+        // В асинхронном режиме flush() дожидается записи очереди
+        logger.enableAsync();
+        for (int i = 0; i < 50; ++i) {
+            logger.info("Async buffered " + std::to_string(i));
+        }
+        ASSERT(logger.flush(), "Асинхронный сброс должен пройти успешно");
+        ASSERT(countLines(readFile(testFile)) == 161, "flush() должен дождаться асинхронной очереди");
+        
+        logger.info("Written on destruction");
+    }
+    
+    std::string content = readFile(testFile);
+    ASSERT(countLines(content) == 162, "Деструктор должен сбросить буфер");
+    ASSERT(content.find("Written on destruction") != std::string::npos, "Последнее сообщение должно быть в файле");
+    
+    cleanupFile(testFile);
+}
+
+
+ // Тест настраиваемого формата и точности временной метки
+
+void testTimestampConfig() {
+    const std::string testFile = "test_timestamp_config.log";
+    cleanupFile(testFile);
+    
+    {
+        logging::LoggerConfig config;
+        config.fileBufferSize = 0;
+        config.timestampFormat = "%H:%M:%S";
+        config.timestampPrecision = logging::TimestampPrecision::MICROSECONDS;
+        logging::Logger logger(testFile, config);
+        logger.info("Micro message");
+        
+        config.timestampFormat = "%Y/%m/%d";
+        config.timestampPrecision = logging::TimestampPrecision::SECONDS;
+        logger.setConfig(config);
+        logger.info("Date message");
+    }
+    
+    std::string content = readFile(testFile);
+    std::istringstream lines(content);
+    std::string first;
+    std::string second;
+    std::getline(lines, first);
+    std::getline(lines, second);
+    
+    ASSERT(std::regex_match(first, std::regex(R"(\[\d{2}:\d{2}:\d{2}\.\d{6}\] \[INFO\] Micro message)")),
+           "Метка должна иметь формат HH:MM:SS.uuuuuu");
+    ASSERT(std::regex_match(second, std::regex(R"(\[\d{4}/\d{2}/\d{2}\] \[INFO\] Date message)")),
+           "Смена формата должна применяться к следующим сообщениям");
+    
+    cleanupFile(testFile);
+}
+
+
+ // Тип, считающий обращения к operator<< (для проверки отложенного форматирования)
+struct CountingArg {
+    static int formatted;
+};
+int CountingArg::formatted = 0;
+
+std::ostream& operator<<(std::ostream& os, const CountingArg&) {
+    CountingArg::formatted++;
+    return os << "counted";
+}
+
+
+ // Тест форматированной записи с аргументами
+
+void testFormattedLogging() {
+    const std::string testFile = "test_formatted.log";
+    cleanupFile(testFile);
+    
+    {
+        logging::Logger logger(testFile, logging::LogLevel::INFO);
+        std::string_view view = "view";
+        std::string owned = "owned";
+        
+        ASSERT(logger.info("Ints {} {} {}", 42, -7, 18446744073709551615ULL), "Запись с числами должна пройти успешно");
+        ASSERT(logger.info("Strings {} {} {}", "literal", view, owned), "Запись со строками должна пройти успешно");
+        ASSERT(logger.warning("Mixed {} {} {}", 1.5, true, 'c'), "Запись со смешанными типами должна пройти успешно");
+        ASSERT(logger.info("Braces {{}} {} missing {}", 1), "Экранирование скобок должно работать");
+        ASSERT(logger.log(logging::LogLevel::INFO, "Custom {}", CountingArg{}), "Пользовательский тип должен форматироваться");
+        ASSERT(CountingArg::formatted == 1, "operator<< должен вызываться для записанного сообщения");
+        
+        // Отфильтрованные сообщения не должны форматировать аргументы
+        ASSERT(logger.debug("Filtered {}", CountingArg{}), "Отфильтрованное сообщение не является ошибкой");
+        ASSERT(CountingArg::formatted == 1, "Аргументы отфильтрованного сообщения не должны форматироваться");
+    }
+    
+    std::string content = readFile(testFile);
+    ASSERT(content.find("Ints 42 -7 18446744073709551615") != std::string::npos, "Числа должны форматироваться");
+    ASSERT(content.find("Strings literal view owned") != std::string::npos, "Строки должны подставляться");
+    ASSERT(content.find("Mixed 1.5 true c") != std::string::npos, "Смешанные типы должны форматироваться");
+    ASSERT(content.find("Braces {} 1 missing {}") != std::string::npos, "Скобки и недостающие аргументы");
+    ASSERT(content.find("Custom counted") != std::string::npos, "Пользовательский тип должен быть в файле");
+    ASSERT(content.find("Filtered") == std::string::npos, "Отфильтрованное сообщение не должно записываться");
+    
+    cleanupFile(testFile);
+}
+
+
+ // Тест макросов LOG_* с отсекаемыми при компиляции уровнями
+
+int macroArgumentEvaluations = 0;
+
+int countedArgument() {
+    return ++macroArgumentEvaluations;
+}
+
+void testLogMacros() {
+    const std::string testFile = "test_macros.log";
+    cleanupFile(testFile);
+    
+    {
+        logging::Logger logger(testFile, logging::LogLevel::INFO);
+        
+        // Ниже уровня логгера: аргументы не вычисляются
+        LOG_TRACE(logger, "Trace {}", countedArgument());
+        LOG_DEBUG(logger, "Debug {}", countedArgument());
+        ASSERT(macroArgumentEvaluations == 0, "Аргументы отфильтрованных макросов не должны вычисляться");
+        
+        LOG_INFO(logger, "Macro info {}", countedArgument());
+        LOG_WARNING(logger, "Macro warning {{literal}}");
+        LOG_ERROR(logger, "Macro error {}", "text");
+        LOG_FATAL(logger, "Macro fatal");
+        
+        int expected = logging::isLevelCompiled(logging::LogLevel::INFO) ? 1 : 0;
+        ASSERT(macroArgumentEvaluations == expected, "Аргументы включённых макросов вычисляются один раз");
+        
+        ASSERT(logger.error("Direct error {}", 5), "Запись ERROR должна пройти успешно");
+        ASSERT(logger.trace("Direct trace"), "Отфильтрованный TRACE не является ошибкой");
+    }
+    
+    std::string content = readFile(testFile);
+    ASSERT(content.find("Trace") == std::string::npos, "TRACE не должен записываться");
+    ASSERT(content.find("[ERROR] Direct error 5") != std::string::npos, "ERROR должен записываться");
+    if (logging::isLevelCompiled(logging::LogLevel::INFO)) {
+        ASSERT(content.find("[INFO] Macro info 1") != std::string::npos, "LOG_INFO должен записываться");
+        ASSERT(content.find("[WARNING] Macro warning {{literal}}") != std::string::npos,
+               "Сообщение без аргументов пишется как есть");
+        ASSERT(content.find("[ERROR] Macro error text") != std::string::npos, "LOG_ERROR должен форматировать");
+        ASSERT(content.find("[FATAL] Macro fatal") != std::string::npos, "LOG_FATAL должен записываться");
+    }
+    
+    cleanupFile(testFile);
+}
+
+
+ // Тест смены уровня и конфигурации во время записи из нескольких потоков
+
+void testConcurrentReconfiguration() {
+    const std::string testFile = "test_reconfig.log";
+    cleanupFile(testFile);
+    
+    const int numThreads = 4;
+    const int messagesPerThread = 500;
+    
+    {
+        logging::Logger logger(testFile, logging::LogLevel::INFO);
+        std::atomic<bool> done{false};
+        
+        // Переключатель уровней и формата времени, как admin-эндпоинт
+        std::thread admin([&logger, &done]() {
+            int iteration = 0;
+            while (!done.load()) {
+                logging::LoggerConfig config;
+                config.fileBufferSize = 0;
+                config.defaultLevel = (iteration % 2 == 0) ? logging::LogLevel::DEBUG : logging::LogLevel::WARNING;
+                config.timestampFormat = (iteration % 2 == 0) ? "%H:%M:%S" : "%Y-%m-%d %H:%M:%S";
+                logger.setConfig(config);
+                logger.setDefaultLevel(config.defaultLevel);
+                iteration++;
+                std::this_thread::yield();
+            }
+        });
+        
+        std::vector<std::thread> threads;
+        for (int i = 0; i < numThreads; ++i) {
+            threads.emplace_back([&logger, i, messagesPerThread]() {
+                for (int j = 0; j < messagesPerThread; ++j) {
+                    // WARNING проходит при любом из переключаемых уровней
+                    logger.warning("Reconfig thread {} message {}", i, j);
+                    logger.debug("Maybe filtered {}", j);
+                }
+            });
+        }
+        
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        done.store(true);
+        admin.join();
+        
+        logging::LoggerConfig last = logger.getConfig();
+        ASSERT((last.defaultLevel == logging::LogLevel::DEBUG) == (last.timestampFormat == "%H:%M:%S"),
+               "Снимок конфигурации должен быть согласованным");
+    }
+    
+    std::string content = readFile(testFile);
+    size_t warnings = 0;
+    size_t pos = 0;
+    while ((pos = content.find("[WARNING] Reconfig thread", pos)) != std::string::npos) {
+        warnings++;
+        pos++;
+    }
+    ASSERT(warnings == static_cast<size_t>(numThreads * messagesPerThread), "Все WARNING сообщения должны быть записаны");
+    
+    cleanupFile(testFile);
+}
+
+
+ // Тест ротации файлов журнала со сжатием в фоне
+
+void testLogRotation() {
+    const std::string testFile = "test_rotation.log";
+    auto cleanupRotation = [&testFile]() {
+        cleanupFile(testFile);
+        for (int i = 1; i <= 4; ++i) {
+            cleanupFile(testFile + "." + std::to_string(i));
+            cleanupFile(testFile + "." + std::to_string(i) + ".gz");
+        }
+    };
+    auto exists = [](const std::string& name) { return std::filesystem::exists(name); };
+    cleanupRotation();
+    
+    {
+        // Ротация каждый 1 MB, храним 2 старых сегмента, сжимаем
+        logging::EnhancedFileOutput output(testFile, 1, 2, true, 64 * 1024);
+        ASSERT(output.isValid(), "Вывод с ротацией должен быть валидным");
+        
+        const std::string line(1023, 'R');
+        for (int i = 0; i < 3500; ++i) {
+            ASSERT(output.writeLog(line), "Запись должна пройти успешно");
+        }
+        output.flush();
+        output.rotator().waitIdle();
+        
+        ASSERT(exists(testFile), "Текущий файл должен существовать");
+        ASSERT(std::filesystem::file_size(testFile) < 1024 * 1024, "Текущий файл не должен превышать лимит");
+        ASSERT(exists(testFile + ".1.gz") || exists(testFile + ".1"), "Должен быть первый старый сегмент");
+        ASSERT(exists(testFile + ".2.gz") || exists(testFile + ".2"), "Должен быть второй старый сегмент");
+        ASSERT(!exists(testFile + ".3.gz") && !exists(testFile + ".3"), "Сегментов не должно быть больше max_files");
+        
+        if (exists(testFile + ".1.gz")) {
+            std::string compressed = readFile(testFile + ".1.gz");
+            ASSERT(compressed.size() > 2 && static_cast<unsigned char>(compressed[0]) == 0x1f &&
+                   static_cast<unsigned char>(compressed[1]) == 0x8b, "Старый сегмент должен быть в формате gzip");
+            ASSERT(compressed.size() < 1024 * 1024 / 10, "Повторяющиеся строки должны хорошо сжиматься");
+        }
+    }
+    
+    for (const auto& entry : std::filesystem::directory_iterator(".")) {
+        ASSERT(entry.path().filename().string().find(testFile + ".pending") == std::string::npos,
+               "Не должно оставаться необработанных сегментов");
+    }
+    cleanupRotation();
+    
+    // Прошлый процесс завершился посреди ротации: .pending.0 остался необработанным
+    {
+        std::ofstream(testFile + ".pending.0") << "left by crash\n";
+        std::ofstream(testFile) << "current segment\n";
+        logging::LogRotator rotator(testFile, 1, 4, false);
+        ASSERT(rotator.rotate(), "Ротация должна пройти успешно");
+        rotator.waitIdle();
+        ASSERT(readFile(testFile + ".2") == "left by crash\n", "Оставшийся сегмент должен уйти в каскад");
+        ASSERT(readFile(testFile + ".1") == "current segment\n", "Новый сегмент не должен затирать оставшийся");
+        ASSERT(!exists(testFile + ".pending.0"), "Оставшийся сегмент должен быть обработан");
+    }
+    
+    cleanupRotation();
+}
+
+
+ // Простой TCP-сервер для тестов сетевого вывода: принимает соединения по очереди и копит строки
+
+class TestLogServer {
+private:
+    int listen_fd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> running_{true};
+    bool framed_ = false;      // отвечает на приветствие кадрового протокола
+    std::thread thread_;
+    std::mutex mutex_;
+    std::vector<std::string> lines_;
+
+    void serve() {
+        while (running_.load()) {
+            struct pollfd pfd{listen_fd_, POLLIN, 0};
+            if (poll(&pfd, 1, 50) <= 0) {
+                continue;
+            }
+            int client = accept(listen_fd_, nullptr, nullptr);
+            if (client < 0) {
+                continue;
+            }
+            
+            std::string partial;
+            std::unique_ptr<logging::framed::FrameDecoder> decoder;
+            char buffer[8192];
+            while (running_.load()) {
+                struct pollfd cfd{client, POLLIN, 0};
+                if (poll(&cfd, 1, 50) <= 0) {
+                    continue;
+                }
+                ssize_t count = recv(client, buffer, sizeof(buffer), 0);
+                if (count <= 0) {
+                    break;
+                }
+                if (decoder) {
+                    if (!decoder->feed(buffer, static_cast<size_t>(count), partial)) {
+                        break;
+                    }
+                } else {
+                    partial.append(buffer, static_cast<size_t>(count));
+                }
+                size_t pos;
+                while ((pos = partial.find('\n')) != std::string::npos) {
+                    std::string line = partial.substr(0, pos);
+                    partial.erase(0, pos + 1);
+                    logging::framed::Codec codec;
+                    if (framed_ && !decoder && logging::framed::chooseCodec(line, codec)) {
+                        std::string reply = logging::framed::replyLine(codec);
+                        send(client, reply.data(), reply.size(), MSG_NOSIGNAL);
+                        decoder = std::make_unique<logging::framed::FrameDecoder>();
+                        std::string rest;
+                        rest.swap(partial);
+                        decoder->feed(rest.data(), rest.size(), partial);
+                        continue;
+                    }
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    lines_.push_back(line);
+                }
+            }
+            close(client);
+        }
+    }
+
+public:
+    explicit TestLogServer(int port = 0, bool framed = false) : framed_(framed) {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        int opt = 1;
+        setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        
+        struct sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(port);
+        if (bind(listen_fd_, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(listen_fd_, 16) < 0) {
+            throw std::runtime_error("Не удалось запустить тестовый сервер");
+        }
+        
+        socklen_t length = sizeof(address);
+        getsockname(listen_fd_, (struct sockaddr*)&address, &length);
+        port_ = ntohs(address.sin_port);
+        thread_ = std::thread(&TestLogServer::serve, this);
+    }
+    
+    ~TestLogServer() {
+        running_.store(false);
+        thread_.join();
+        close(listen_fd_);
+    }
+    
+    int port() const { return port_; }
+    
+    std::vector<std::string> lines() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lines_;
+    }
+    
+    bool waitForLines(size_t count, std::chrono::milliseconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (std::chrono::steady_clock::now() < deadline) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (lines_.size() >= count) {
+                    return true;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    }
+};
+
+
+ // Тест сетевого логирования через простой SocketOutput
+
+void testSocketOutput() {
+    TestLogServer server;
+    
+    {
+        logging::Logger logger("127.0.0.1", server.port(), logging::LogLevel::INFO);
+        ASSERT(logger.isValid(), "Логгер должен подключиться к серверу");
+        for (int i = 0; i < 200; ++i) {
+            ASSERT(logger.info("Socket message {}", i), "Отправка должна пройти успешно");
+        }
+    }
+    
+    ASSERT(server.waitForLines(200, std::chrono::seconds(5)), "Сервер должен получить все строки");
+    auto lines = server.lines();
+    ASSERT(lines.back().find("[INFO] Socket message 199") != std::string::npos, "Строки должны приходить целиком");
+}
+
+
+ // Тест сетевого вывода с буферизацией, пакетной отправкой и переподключением
+
+void testEnhancedSocketOutput() {
+    // Обычная работа: записи копятся и уходят крупными пакетами
+    {
+        TestLogServer server;
+        logging::EnhancedSocketOutput output("127.0.0.1", server.port(), 50, 0);
+        ASSERT(output.isConnected(), "Вывод должен подключиться сразу");
+        for (int i = 0; i < 5000; ++i) {
+            ASSERT(output.writeLog("Batched record " + std::to_string(i)), "Запись должна приниматься");
+        }
+        ASSERT(output.waitDrained(std::chrono::seconds(5)), "Буфер должен быть отправлен");
+        ASSERT(server.waitForLines(5000, std::chrono::seconds(5)), "Сервер должен получить все записи");
+        ASSERT(server.lines()[4999] == "Batched record 4999", "Порядок записей должен сохраняться");
+    }
+    
+    // Сервер недоступен: записи буферизуются и доставляются после его запуска
+    int port;
+    {
+        TestLogServer probe;
+        port = probe.port();
+    }
+    
+    {
+        logging::LoggerConfig config;
+        config.reconnectIntervalMs = 50;
+        config.maxReconnectAttempts = 0;
+        logging::Logger logger("127.0.0.1", port, config);
+        ASSERT(logger.isValid(), "Логгер должен принимать записи во время переподключения");
+        for (int i = 0; i < 100; ++i) {
+            ASSERT(logger.info("Spilled message {}", i), "Запись должна буферизоваться");
+        }
+        
+        TestLogServer server(port);
+        ASSERT(server.waitForLines(100, std::chrono::seconds(5)), "Буфер должен быть доставлен после переподключения");
+        auto lines = server.lines();
+        ASSERT(lines.front().find("Spilled message 0") != std::string::npos, "Первой должна прийти первая запись");
+        ASSERT(lines.back().find("Spilled message 99") != std::string::npos, "Последней должна прийти последняя запись");
+    }
+    
+    // Ограниченный буфер: при недоступном сервере лишние записи отбрасываются
+    {
+        logging::EnhancedSocketOutput output("127.0.0.1", port, 1000, 0, 1024);
+        size_t accepted = 0;
+        for (int i = 0; i < 100; ++i) {
+            if (output.writeLog(std::string(100, 'x'))) {
+                accepted++;
+            }
+        }
+        ASSERT(accepted < 100 && accepted + output.droppedRecords() == 100, "Буфер должен быть ограничен");
+    }
+}
+
+// Тест комбинированной синхронной записи: порядок внутри потока и целостность строк
+void testCombinedSyncWrites() {
+    const std::string testFile = "test_combined_writes.log";
+    cleanupFile(testFile);
+    
+    const int numThreads = 8;
+    const int messagesPerThread = 500;
+    {
+        logging::LoggerConfig config;
+        config.defaultLevel = logging::LogLevel::DEBUG;
+        config.fileBufferSize = 4096;
+        logging::Logger logger(testFile, config);
+        
+        std::atomic<bool> producing{true};
+        std::thread flusher([&]() {
+            while (producing.load()) {
+                logger.flush();
+                std::this_thread::yield();
+            }
+        });
+        
+        std::vector<std::thread> threads;
+        for (int i = 0; i < numThreads; ++i) {
+            threads.emplace_back([&logger, i]() {
+                for (int j = 0; j < messagesPerThread; ++j) {
+                    // Каждая десятая запись — WARNING, она вызывает сброс пакета
+                    logging::LogLevel level = j % 10 == 0 ? logging::LogLevel::WARNING : logging::LogLevel::INFO;
+                    logger.log(level, "thread={} seq={}", i, j);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        producing = false;
+        flusher.join();
+    }
+    
+    std::ifstream file(testFile);
+    std::string line;
+    std::vector<int> lastSeq(numThreads, -1);
+    int total = 0;
+    std::regex pattern(R"(thread=(\d+) seq=(\d+)$)");
+    while (std::getline(file, line)) {
+        std::smatch match;
+        ASSERT(std::regex_search(line, match, pattern), "Строка не должна быть разорвана: " + line);
+        int thread = std::stoi(match[1]);
+        int seq = std::stoi(match[2]);
+        ASSERT(seq == lastSeq[thread] + 1, "Записи потока должны идти по порядку");
+        lastSeq[thread] = seq;
+        total++;
+    }
+    ASSERT(total == numThreads * messagesPerThread, "Должны быть записаны все сообщения");
+    
+    cleanupFile(testFile);
+}
+
+// Тест двоичного формата записей: декодированный текст совпадает с текстовым режимом
+std::vector<std::string> decodeBinaryLog(const std::string& filename, bool& ok) {
+    logging::BinaryLogDecoder decoder;
+    decoder.append(readFile(filename));
+    std::vector<std::string> lines;
+    logging::BinaryLogDecoder::Record record;
+    logging::BinaryLogDecoder::Status status;
+    while ((status = decoder.next(record)) == logging::BinaryLogDecoder::Status::RECORD) {
+        std::string line;
+        decoder.render(line, record);
+        lines.push_back(line);
+    }
+    ok = status == logging::BinaryLogDecoder::Status::NEED_MORE && !decoder.hasPendingData();
+    return lines;
+}
+
+void testBinaryRecordFormat() {
+    const std::string textFile = "test_binary_reference.log";
+    const std::string binaryFile = "test_binary.bin";
+    cleanupFile(textFile);
+    cleanupFile(binaryFile);
+    
+    auto writeSample = [](logging::Logger& logger) {
+        int* pointer = reinterpret_cast<int*>(0x1234);
+        logger.info("Plain message with {braces}");
+        logger.info("int={} uint={} neg={}", 42, 7u, -5LL);
+        logger.warning("float={} double={} bool={} char={}", 1.5f, 0.1, true, 'x');
+        logger.error("str={} view={} cstr={} ptr={}", std::string("s"), std::string_view("v"), "c", pointer);
+        logger.info("missing {} {}", 1);
+        logger.info("extra {}", 1, 2);
+        logger.info("escaped {{}} {}", "ok");
+        logger.debug("filtered {}", 1);
+        LOG_INFO(logger, "macro {}", 99);
+        // Повторяющиеся форматы — обычный случай, где двоичный формат выигрывает в объёме
+        for (int i = 0; i < 200; ++i) {
+            logger.info("request {} served in {} ms", i, i * 3);
+        }
+    };
+    
+    logging::LoggerConfig config;
+    config.enableRotation = false;
+    {
+        logging::Logger logger(textFile, config);
+        writeSample(logger);
+    }
+    config.recordFormat = logging::RecordFormat::BINARY;
+    {
+        logging::Logger logger(binaryFile, config);
+        writeSample(logger);
+    }
+    
+    // Сравниваем без метки времени: она у двух логгеров разная
+    auto stripTimestamp = [](const std::string& line) { return line.substr(line.find("] [") + 2); };
+    std::istringstream text(readFile(textFile));
+    std::vector<std::string> expected;
+    for (std::string line; std::getline(text, line);) {
+        expected.push_back(stripTimestamp(line));
+    }
+    
+    bool ok = false;
+    auto decoded = decodeBinaryLog(binaryFile, ok);
+    ASSERT(ok, "Двоичный журнал должен декодироваться без ошибок");
+    ASSERT(decoded.size() == expected.size() && expected.size() == 208, "Количество записей должно совпадать");
+    for (size_t i = 0; i < decoded.size(); ++i) {
+        ASSERT(stripTimestamp(decoded[i]) == expected[i], "Запись должна совпадать с текстовой: " + decoded[i]);
+    }
+    std::regex linePattern(R"(^\[\d{4}-\d{2}-\d{2} \d{2}:\d{2}:\d{2}\.\d{3}\] \[INFO\] Plain message with \{braces\}$)");
+    ASSERT(std::regex_match(decoded[0], linePattern), "Метка времени должна быть в текстовом формате");
+    ASSERT(std::filesystem::file_size(binaryFile) < std::filesystem::file_size(textFile),
+           "Двоичный журнал должен быть компактнее текстового");
+    
+    cleanupFile(textFile);
+    cleanupFile(binaryFile);
+    
+    // Асинхронный режим с ротацией: каждый сегмент декодируется отдельно
+    const std::string rotatedFile = "test_binary_rotated.bin";
+    auto cleanupRotated = [&rotatedFile]() {
+        cleanupFile(rotatedFile);
+        for (int i = 1; i <= 5; ++i) {
+            cleanupFile(rotatedFile + "." + std::to_string(i));
+        }
+    };
+    cleanupRotated();
+    {
+        config.enableAsync = true;
+        config.enableRotation = true;
+        config.maxFileSizeMB = 1;
+        config.maxFiles = 5;
+        logging::Logger logger(rotatedFile, config);
+        const std::string padding(200, 'p');
+        for (int i = 0; i < 12000; ++i) {
+            logger.info("record {} {}", i, padding);
+        }
+    }
+    
+    int next = 0;
+    for (int segment = 5; segment >= 0; --segment) {
+        std::string name = segment == 0 ? rotatedFile : rotatedFile + "." + std::to_string(segment);
+        if (!std::filesystem::exists(name)) {
+            continue;
+        }
+        auto lines = decodeBinaryLog(name, ok);
+        ASSERT(ok && !lines.empty(), "Сегмент должен декодироваться самостоятельно: " + name);
+        for (const auto& line : lines) {
+            ASSERT(line.find("record " + std::to_string(next) + " ") != std::string::npos,
+                   "Записи должны идти по порядку через границы сегментов");
+            next++;
+        }
+    }
+    ASSERT(std::filesystem::exists(rotatedFile + ".1"), "Должна произойти ротация");
+    ASSERT(next == 12000, "Все записи должны быть декодированы");
+    
+    cleanupRotated();
+}
+
+// Тест вывода через отображение файла в память: конкурентная запись, смена сегмента, сбой процесса
+void testMappedFileOutput() {
+    const std::string testFile = "test_mapped.log";
+    auto cleanupMapped = [&testFile]() {
+        cleanupFile(testFile);
+        for (int i = 1; i <= 5; ++i) {
+            cleanupFile(testFile + "." + std::to_string(i));
+        }
+    };
+    auto countValidLines = [](const std::string& content, std::vector<int>& seen) {
+        std::istringstream stream(content);
+        std::regex pattern(R"(^mapped (\d+) x+$)");
+        size_t lines = 0;
+        for (std::string line; std::getline(stream, line);) {
+            std::smatch match;
+            if (std::regex_match(line, match, pattern)) {
+                seen[std::stoi(match[1])]++;
+                lines++;
+            }
+        }
+        return lines;
+    };
+    cleanupMapped();
+    
+    // Четыре потока пишут ~1.7 MB в сегменты по 1 MB: должен произойти переход на новый сегмент
+    const int numThreads = 4;
+    const int perThread = 4000;
+    {
+        logging::MappedFileOutput output(testFile, 1, 5, false, 100);
+        ASSERT(output.isValid(), "Вывод через mmap должен быть валидным");
+        ASSERT(std::filesystem::file_size(testFile) == 1024 * 1024, "Сегмент должен быть предвыделен");
+        
+        std::vector<std::thread> threads;
+        for (int t = 0; t < numThreads; ++t) {
+            threads.emplace_back([&output, t]() {
+                const std::string padding(100, 'x');
+                for (int i = 0; i < perThread; ++i) {
+                    output.writeLog("mapped " + std::to_string(t * perThread + i) + " " + padding);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        output.rotator()->waitIdle();
+    }
+    
+    std::string current = readFile(testFile);
+    std::string rolled = readFile(testFile + ".1");
+    ASSERT(!rolled.empty() && rolled.back() == '\n', "Закрытый сегмент должен заканчиваться целой записью");
+    ASSERT(rolled.size() <= 1024 * 1024, "Закрытый сегмент усекается до записанных данных");
+    ASSERT(current.find('\0') == std::string::npos && rolled.find('\0') == std::string::npos,
+           "Файлы не должны содержать пустых хвостов");
+    std::vector<int> seen(numThreads * perThread, 0);
+    size_t total = countValidLines(rolled, seen) + countValidLines(current, seen);
+    ASSERT(total == static_cast<size_t>(numThreads * perThread), "Все записи должны быть целыми");
+    ASSERT(std::all_of(seen.begin(), seen.end(), [](int n) { return n == 1; }), "Каждая запись ровно один раз");
+    cleanupMapped();
+    
+    // Процесс падает без деструктора: записи остаются в файле, следующий запуск дописывает за ними
+    pid_t child = fork();
+    if (child == 0) {
+        logging::MappedFileOutput output(testFile, 1, 5, false, 0);
+        for (int i = 0; i < 1000; ++i) {
+            output.writeLog("mapped " + std::to_string(i) + " xxxx");
+        }
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    ASSERT(WIFEXITED(status), "Дочерний процесс должен завершиться");
+    ASSERT(std::filesystem::file_size(testFile) == 1024 * 1024, "После сбоя файл остаётся предвыделенным");
+    {
+        logging::MappedFileOutput output(testFile, 1, 5, false, 0, false);
+        ASSERT(output.writeLog("mapped 1000 xxxx"), "Запись после перезапуска должна пройти успешно");
+    }
+    std::vector<int> recovered(1001, 0);
+    current = readFile(testFile);
+    ASSERT(countValidLines(current, recovered) == 1001 && countLines(current) == 1001,
+           "Записи до сбоя должны сохраниться, новые — дописаться следом");
+    cleanupMapped();
+    
+    // Двоичные записи, оканчивающиеся нулями: длина данных берётся не по нулевым байтам
+    const std::string zeroTail("bin\x01\0\0\0\0", 8);
+    child = fork();
+    if (child == 0) {
+        logging::MappedFileOutput output(testFile, 1, 5, false, 0);
+        output.writeRaw(zeroTail);
+        output.writeRaw(zeroTail);
+        _exit(0);
+    }
+    status = 0;
+    waitpid(child, &status, 0);
+    ASSERT(WIFEXITED(status), "Дочерний процесс должен завершиться");
+    {
+        logging::MappedFileOutput output(testFile, 1, 5, false, 0, false);
+        ASSERT(output.writeRaw(zeroTail), "Двоичная запись после сбоя должна пройти успешно");
+    }
+    {
+        logging::MappedFileOutput output(testFile, 1, 5, false, 0, false);
+        ASSERT(output.writeRaw("end"), "Запись после штатного закрытия должна пройти успешно");
+    }
+    ASSERT(readFile(testFile) == zeroTail + zeroTail + zeroTail + "end",
+           "Нулевые байты в конце записей не должны считаться свободным местом");
+    cleanupMapped();
+    
+    // Без ротации сегмент расширяется, а логгер может использовать вывод через конфигурацию
+    {
+        logging::LoggerConfig config;
+        config.memoryMappedFile = true;
+        config.enableRotation = false;
+        config.maxFileSizeMB = 1;
+        logging::Logger logger(testFile, config);
+        const std::string padding(200, 'x');
+        for (int i = 0; i < 8000; ++i) {
+            logger.info("mapped {} {}", i, padding);
+        }
+    }
+    current = readFile(testFile);
+    ASSERT(countLines(current) == 8000 && current.size() > 1024 * 1024, "Файл без ротации должен расти");
+    ASSERT(!std::filesystem::exists(testFile + ".1"), "Без ротации новых сегментов быть не должно");
+    cleanupMapped();
+}
+
+// Вывод, который блокируется до разрешения (имитация зависшего получателя)
+class StalledOutput : public logging::LogOutput {
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool released_ = false;
+    std::atomic<size_t> written_{0};
+
+public:
+    bool writeLog(std::string_view) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return released_; });
+        written_++;
+        return true;
+    }
+    bool isValid() const override { return true; }
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        released_ = true;
+        cv_.notify_all();
+    }
+    size_t written() const { return written_.load(); }
+};
+
+// Тест нескольких выводов: свой уровень у каждого, зависший вывод не тормозит остальные
+void testMultipleOutputs() {
+    const std::string primaryFile = "test_fanout_primary.log";
+    const std::string warningFile = "test_fanout_warnings.log";
+    cleanupFile(primaryFile);
+    cleanupFile(warningFile);
+    
+    // Очередь вмещает все WARNING (2000), но не все записи (8000): переполняется только зависший вывод
+    const int numMessages = 8000;
+    uint64_t stalledDropped = 0;
+    size_t stalledWritten = 0;
+    {
+        logging::LoggerConfig config;
+        config.defaultLevel = logging::LogLevel::DEBUG;
+        config.enableRotation = false;
+        config.asyncQueueSize = 4096;
+        logging::Logger logger(primaryFile, config);
+        
+        auto stalledOwner = std::make_unique<StalledOutput>();
+        StalledOutput* stalled = stalledOwner.get();
+        // Разблокируем вывод при любом выходе из блока, иначе деструктор логгера будет ждать его
+        struct ReleaseGuard {
+            StalledOutput* output;
+            ~ReleaseGuard() { output->release(); }
+        } releaseGuard{stalled};
+        ASSERT(logger.addOutput(std::make_unique<logging::FileOutput>(warningFile), logging::LogLevel::WARNING),
+               "Файловый вывод должен добавляться");
+        ASSERT(logger.addOutput(std::move(stalledOwner)), "Пользовательский вывод должен добавляться");
+        ASSERT(logger.getOutputCount() == 2, "Должно быть два дополнительных вывода");
+        ASSERT(!logger.addOutput(nullptr), "Пустой вывод не добавляется");
+        
+        CountingArg::formatted = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < numMessages; ++i) {
+            logging::LogLevel level = i % 4 == 0 ? logging::LogLevel::WARNING : logging::LogLevel::INFO;
+            logger.log(level, "fanout {} {}", i, CountingArg{});
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        ASSERT(CountingArg::formatted == numMessages, "Каждая запись форматируется один раз на все выводы");
+        ASSERT(elapsed < std::chrono::seconds(5), "Зависший вывод не должен блокировать запись");
+        ASSERT(logger.getOutputDroppedCount(1) > 0, "Переполненная очередь зависшего вывода теряет записи");
+        ASSERT(logger.getOutputDroppedCount(0) == 0, "Файловый вывод успевает без потерь");
+        
+        stalled->release();
+        ASSERT(logger.flush(), "Сброс должен дождаться всех выводов");
+        stalledDropped = logger.getOutputDroppedCount(1);
+        stalledWritten = stalled->written();
+    }
+    
+    ASSERT(countLines(readFile(primaryFile)) == static_cast<size_t>(numMessages), "Основной вывод получает всё");
+    std::string warnings = readFile(warningFile);
+    ASSERT(countLines(warnings) == static_cast<size_t>(numMessages / 4), "Второй вывод получает только WARNING");
+    ASSERT(warnings.find("[INFO]") == std::string::npos, "INFO не должен попасть во второй вывод");
+    ASSERT(stalledWritten + stalledDropped == static_cast<size_t>(numMessages),
+           "Каждая запись либо доставлена, либо учтена как потерянная");
+    
+    cleanupFile(primaryFile);
+    cleanupFile(warningFile);
+}
+
+// Вывод, считающий вызовы writeBatch и записи в них
+class BatchCountingOutput : public logging::LogOutput {
+private:
+    std::mutex mutex_;
+    std::vector<std::string> records_;
+    size_t batches_ = 0;
+
+public:
+    bool writeLog(std::string_view formattedMessage) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        records_.emplace_back(formattedMessage);
+        return true;
+    }
+    bool writeBatch(const std::string_view* records, size_t count) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            batches_++;
+        }
+        return logging::LogOutput::writeBatch(records, count);
+    }
+    bool isValid() const override { return true; }
+    std::vector<std::string> records() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return records_;
+    }
+    size_t batches() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return batches_;
+    }
+};
+
+// Тест пакетной записи: порядок и число записей у каждого вывода, пачки в асинхронном режиме
+void testWriteBatch() {
+    const std::string plainFile = "test_batch_plain.log";
+    const std::string mappedFile = "test_batch_mapped.log";
+    const std::string asyncFile = "test_batch_async.log";
+    cleanupFile(plainFile);
+    cleanupFile(mappedFile);
+    cleanupFile(asyncFile);
+    
+    std::vector<std::string> messages;
+    for (int i = 0; i < 1000; ++i) {
+        messages.push_back("batch " + std::to_string(i));
+    }
+    std::vector<std::string_view> views(messages.begin(), messages.end());
+    std::string expected;
+    for (const auto& message : messages) {
+        expected += message + "\n";
+    }
+    
+    // Вывод без своей реализации пишет пачку по одной записи
+    BatchCountingOutput counting;
+    ASSERT(counting.writeBatch(views.data(), views.size()), "Пачка должна записываться");
+    ASSERT(counting.records() == messages, "Записи пачки должны идти по порядку");
+    ASSERT(counting.writeBatch(nullptr, 0), "Пустая пачка допустима");
+    
+    {
+        logging::FileOutput output(plainFile);
+        ASSERT(output.writeBatch(views.data(), views.size()), "Файловый вывод должен принимать пачку");
+    }
+    ASSERT(readFile(plainFile) == expected, "Файл должен содержать пачку целиком и по порядку");
+    
+    {
+        logging::MappedFileOutput output(mappedFile, 1, 5, false, 0, false);
+        ASSERT(output.writeBatch(views.data(), views.size()), "Вывод через mmap должен принимать пачку");
+        ASSERT(output.writeLog("batch tail"), "Запись после пачки должна проходить");
+    }
+    ASSERT(readFile(mappedFile) == expected + "batch tail\n", "Пачка в mmap лежит одним куском");
+    
+    // Асинхронный логгер отдаёт дополнительному выводу накопленное одной пачкой
+    BatchCountingOutput* lane = nullptr;
+    const int numMessages = 5000;
+    {
+        logging::LoggerConfig config;
+        config.enableAsync = true;
+        config.enableRotation = false;
+        logging::Logger logger(asyncFile, config);
+        auto laneOwner = std::make_unique<BatchCountingOutput>();
+        lane = laneOwner.get();
+        ASSERT(logger.addOutput(std::move(laneOwner)), "Пользовательский вывод должен добавляться");
+        for (int i = 0; i < numMessages; ++i) {
+            logger.info("async {}", i);
+        }
+        ASSERT(logger.flush(), "Сброс должен пройти успешно");
+        
+        auto received = lane->records();
+        ASSERT(received.size() == static_cast<size_t>(numMessages), "Вывод должен получить все записи");
+        bool ordered = true;
+        for (int i = 0; i < numMessages; ++i) {
+            const std::string suffix = "async " + std::to_string(i);
+            const std::string& record = received[static_cast<size_t>(i)];
+            ordered = ordered && record.size() >= suffix.size() &&
+                      record.compare(record.size() - suffix.size(), suffix.size(), suffix) == 0;
+        }
+        ASSERT(ordered, "Записи должны приходить в порядке вызовов");
+        ASSERT(lane->batches() < static_cast<size_t>(numMessages), "Записи должны приходить пачками");
+    }
+    ASSERT(countLines(readFile(asyncFile)) == static_cast<size_t>(numMessages), "Основной вывод получает всё");
+    
+    cleanupFile(plainFile);
+    cleanupFile(mappedFile);
+    cleanupFile(asyncFile);
+}
+
+// Тест вывода через io_uring: порядок при нескольких буферах в полёте, сокет, выбор через конфигурацию
+void testIoUringOutput() {
+    const std::string directFile = "test_uring_direct.log";
+    const std::string rotatedFile = "test_uring_rotated.log";
+    auto cleanupUring = [&]() {
+        cleanupFile(directFile);
+        for (int i = 0; i <= 5; ++i) {
+            cleanupFile(i == 0 ? rotatedFile : rotatedFile + "." + std::to_string(i));
+        }
+    };
+    cleanupUring();
+    
+    // Без io_uring логгер молча берёт обычный файловый вывод
+    if (!logging::IoUringOutput::isAvailable()) {
+        {
+            logging::LoggerConfig config;
+            config.ioUring = true;
+            config.enableRotation = false;
+            logging::Logger logger(directFile, config);
+            ASSERT(logger.info("fallback"), "Запись должна идти через обычный вывод");
+        }
+        ASSERT(countLines(readFile(directFile)) == 1, "Резервный вывод должен записать строку");
+        cleanupUring();
+        return;
+    }
+    
+    // Маленькие буферы: много отправок в полёте; запись больше буфера делится между ними
+    std::string expected = "existing\n";
+    {
+        std::ofstream existing(directFile);
+        existing << expected;
+    }
+    {
+        logging::IoUringOutput output(directFile, 4096);
+        ASSERT(output.isValid(), "Вывод через io_uring должен быть валидным");
+        for (int i = 0; i < 20000; ++i) {
+            std::string record = "uring " + std::to_string(i) + " " + std::string(static_cast<size_t>(i % 97), 'x');
+            ASSERT(output.writeLog(record), "Запись должна приниматься");
+            expected += record + "\n";
+        }
+        const std::string large(10000, 'L');
+        ASSERT(output.writeLog(large), "Запись больше буфера должна приниматься");
+        expected += large + "\n";
+        ASSERT(output.flush(), "Сброс должен дождаться всех буферов");
+        ASSERT(readFile(directFile) == expected, "После flush файл должен совпадать с записанным");
+        ASSERT(output.writeRaw("raw"), "Двоичные данные пишутся как есть");
+        expected += "raw";
+    }
+    ASSERT(readFile(directFile) == expected, "Деструктор должен дописать остаток");
+    cleanupUring();
+    
+    // Сокет: буферы уходят по одному, порядок строк в потоке сохраняется
+    {
+        TestLogServer server;
+        {
+            auto output = logging::IoUringOutput::connect("127.0.0.1", server.port(), 2048);
+            ASSERT(output->isValid(), "Вывод должен подключиться к серверу");
+            ASSERT(!output->supportsRaw(), "Двоичный формат в сокет не поддерживается");
+            std::vector<std::string> records;
+            for (int i = 0; i < 5000; ++i) {
+                records.push_back("uring socket " + std::to_string(i));
+            }
+            std::vector<std::string_view> views(records.begin(), records.end());
+            ASSERT(output->writeBatch(views.data(), views.size()), "Пачка должна приниматься");
+            ASSERT(output->flush(), "Сброс должен дождаться отправки");
+        }
+        ASSERT(server.waitForLines(5000, std::chrono::seconds(5)), "Сервер должен получить все записи");
+        auto lines = server.lines();
+        bool ordered = true;
+        for (int i = 0; i < 5000; ++i) {
+            ordered = ordered && lines[static_cast<size_t>(i)] == "uring socket " + std::to_string(i);
+        }
+        ASSERT(ordered, "Записи должны приходить по порядку и целиком");
+    }
+    
+    // Через конфигурацию: асинхронный логгер с ротацией поверх io_uring
+    const int numMessages = 12000;
+    {
+        logging::LoggerConfig config;
+        config.ioUring = true;
+        config.enableAsync = true;
+        config.maxFileSizeMB = 1;
+        config.maxFiles = 5;
+        logging::Logger logger(rotatedFile, config);
+        const std::string padding(100, 'x');
+        for (int i = 0; i < numMessages; ++i) {
+            logger.info("rotated {} {}", i, padding);
+        }
+        ASSERT(logger.flush(), "Сброс должен пройти успешно");
+    }
+    ASSERT(std::filesystem::exists(rotatedFile + ".1"), "Должна произойти ротация");
+    size_t total = countLines(readFile(rotatedFile)) + countLines(readFile(rotatedFile + ".1"));
+    ASSERT(total == static_cast<size_t>(numMessages), "Все записи должны попасть в сегменты");
+    ASSERT(std::filesystem::file_size(rotatedFile + ".1") <= 1024 * 1024, "Сегмент не превышает предел");
+    cleanupUring();
+}
+
+// Тест пула записей очереди: без выделений памяти в установившемся режиме, длинные записи целы
+void testRecordArena() {
+    const std::string testFile = "test_record_arena.log";
+    cleanupFile(testFile);
+    
+    // Перемещение записи переносит короткий текст внутри записи, длинный — владением блоком
+    logging::RecordBuffer shortText;
+    shortText.assign("short message");
+    logging::RecordBuffer moved(std::move(shortText));
+    ASSERT(moved.view() == "short message" && !moved.onHeap(), "Короткий текст хранится в записи");
+    const std::string longMessage(logging::RecordBuffer::kInlineCapacity * 4, 'L');
+    moved.assign(longMessage);
+    ASSERT(moved.onHeap() && moved.view() == longMessage, "Длинный текст уходит в отдельный блок");
+    logging::RecordBuffer target;
+    target = std::move(moved);
+    ASSERT(target.view() == longMessage && moved.size() == 0, "Блок переходит к новой записи");
+    target.assign("again short");
+    ASSERT(!target.onHeap() && target.view() == "again short", "Короткий текст освобождает блок");
+    
+    const int numMessages = 20000;
+    size_t allocations = 0;
+    {
+        logging::LoggerConfig config;
+        config.enableAsync = true;
+        config.enableRotation = false;
+        config.asyncQueueSize = 4096;
+        logging::Logger logger(testFile, config);
+        const std::string message(100, 'm');
+        
+        // Прогрев: буферы форматирования и вывода достигают рабочего размера
+        for (int i = 0; i < numMessages; ++i) {
+            logger.log(message, logging::LogLevel::INFO);
+        }
+        ASSERT(logger.flush(), "Сброс должен пройти успешно");
+        
+        allocationCount = 0;
+        countAllocations = true;
+        for (int i = 0; i < numMessages; ++i) {
+            logger.log(message, logging::LogLevel::INFO);
+        }
+        countAllocations = false;
+        ASSERT(logger.flush(), "Сброс должен пройти успешно");
+        allocations = allocationCount.load();
+        
+        // Записи длиннее ячейки проходят через отдельные блоки и не теряются
+        for (int i = 0; i < 100; ++i) {
+            logger.info("long {} {}", i, longMessage);
+        }
+    }
+    
+    ASSERT(allocations < static_cast<size_t>(numMessages / 100),
+           "В установившемся режиме очередь не должна выделять память на запись");
+    std::string content = readFile(testFile);
+    ASSERT(countLines(content) == static_cast<size_t>(2 * numMessages + 100), "Все записи должны дойти");
+    ASSERT(content.find("long 99 " + longMessage + "\n") != std::string::npos, "Длинная запись должна быть целой");
+    cleanupFile(testFile);
+}
+
+// Тест ограничения частоты и схлопывания повторов
+void testRateLimitAndRepeats() {
+    const std::string testFile = "test_rate_limit.log";
+    cleanupFile(testFile);
+    
+    // Шторм из одного места вызова режется до burst, другое место вызова не затронуто
+    const int stormSize = 10000;
+    uint64_t suppressed = 0;
+    double stormSeconds = 0;
+    {
+        logging::LoggerConfig config;
+        config.enableRotation = false;
+        config.rateLimitPerSecond = 10;
+        logging::Logger logger(testFile, config);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < stormSize; ++i) {
+            logger.warning("storm {}", i);
+        }
+        stormSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        for (int i = 0; i < 5; ++i) {
+            logger.info("other {}", i);
+        }
+        suppressed = logger.getSuppressedCount();
+        ASSERT(logger.flush(), "Сброс должен пройти успешно");
+    }
+    
+    std::string content = readFile(testFile);
+    size_t stormLines = 0;
+    size_t otherLines = 0;
+    std::istringstream stream(content);
+    for (std::string line; std::getline(stream, line);) {
+        stormLines += line.find("] storm ") != std::string::npos;
+        otherLines += line.find("] other ") != std::string::npos;
+    }
+    // Сверх burst ведро пополняется по rateLimitPerSecond: граница зависит от длительности
+    // шторма, а не от скорости машины
+    const size_t refilled = static_cast<size_t>(stormSeconds * 10) + 1;
+    ASSERT(stormLines >= 10 && stormLines <= 10 + refilled, "Из шторма проходит около burst записей");
+    ASSERT(otherLines == 5, "Другое место вызова ограничение не затрагивает");
+    ASSERT(suppressed == static_cast<uint64_t>(stormSize) - stormLines, "Подавленные записи должны учитываться");
+    ASSERT(content.find("[WARNING] " + std::to_string(suppressed) + " similar messages suppressed by rate limit") !=
+           std::string::npos, "Итог подавления должен попасть в журнал с уровнем шторма");
+    cleanupFile(testFile);
+    
+    // Одинаковые записи подряд схлопываются в одну строку-итог
+    {
+        logging::LoggerConfig config;
+        config.enableRotation = false;
+        config.collapseRepeats = true;
+        logging::Logger logger(testFile, config);
+        for (int i = 0; i < 1000; ++i) {
+            logger.error("disk full");
+        }
+        logger.info("recovered");
+        logger.info("tail {}", 1);
+        logger.info("tail {}", 1);
+        logger.info("tail {}", 2);
+        for (int i = 0; i < 5; ++i) {
+            logger.info("idle");
+        }
+        ASSERT(logger.getSuppressedCount() == 999 + 1 + 4, "Повторы должны учитываться как подавленные");
+    }
+    
+    std::vector<std::string> lines;
+    std::istringstream collapsed(readFile(testFile));
+    for (std::string line; std::getline(collapsed, line);) {
+        lines.push_back(line.substr(line.find("] [") + 2));
+    }
+    std::vector<std::string> expected = {
+        "[ERROR] disk full",
+        "[ERROR] last message repeated 999 times",
+        "[INFO] recovered",
+        "[INFO] tail 1",
+        "[INFO] last message repeated 1 times",
+        "[INFO] tail 2",
+        "[INFO] idle",
+        "[INFO] last message repeated 4 times",
+    };
+    ASSERT(lines == expected, "Повторы должны заменяться итогом, порядок записей сохраняется");
+    cleanupFile(testFile);
+}
+
+ // Тест встроенных метрик логгера
+
+void testLoggerStats() {
+    const std::string testFile = "test_logger_stats.log";
+    cleanupFile(testFile);
+    
+    // Синхронный режим: принятые и отфильтрованные записи, байты, сбросы, задержки
+    logging::LoggerStats stats;
+    {
+        logging::LoggerConfig config;
+        config.enableRotation = false;
+        config.defaultLevel = logging::LogLevel::INFO;
+        logging::Logger logger(testFile, config);
+        for (int i = 0; i < 1000; ++i) {
+            logger.info("stats record {}", i);
+        }
+        for (int i = 0; i < 499; ++i) {
+            logger.debug("hidden " + std::to_string(i));
+        }
+        // Не LOG_DEBUG: в Release макрос вырезается и до фильтра не доходит
+        logger.debug("hidden {}", 499);
+        ASSERT(logger.flush(), "Сброс должен пройти успешно");
+        stats = logger.getStats();
+    }
+    const size_t info = static_cast<size_t>(logging::LogLevel::INFO);
+    const size_t debug = static_cast<size_t>(logging::LogLevel::DEBUG);
+    ASSERT(stats.accepted[info] == 1000 && stats.acceptedTotal() == 1000, "Должны учитываться принятые записи");
+    ASSERT(stats.filtered[debug] == 500 && stats.filteredTotal() == 500, "Должны учитываться отфильтрованные записи");
+    ASSERT(stats.droppedTotal() == 0, "Потерь в синхронном режиме быть не должно");
+    ASSERT(stats.bytesWritten == readFile(testFile).size(), "Записанные байты должны совпадать с размером файла");
+    ASSERT(stats.sinkWrites > 0 && stats.sinkWrites <= 1000 && stats.writeErrors == 0, "Должны учитываться записи в вывод");
+    ASSERT(stats.flushes >= 1, "Должны учитываться сбросы");
+    ASSERT(stats.queueCapacity == 0 && stats.queueHighWater == 0, "Без асинхронного режима очереди нет");
+    ASSERT(stats.enqueueLatency.count > 0 && stats.sinkWriteLatency.count > 0, "Задержки должны измеряться");
+    ASSERT(stats.enqueueLatency.quantileNs(0.5) <= stats.enqueueLatency.quantileNs(0.99), "Квантили должны быть упорядочены");
+    ASSERT(stats.enqueueLatency.quantileNs(1.0) <= static_cast<double>(stats.enqueueLatency.maxNs),
+           "Квантиль не должен превышать максимум");
+    cleanupFile(testFile);
+    
+    // Асинхронный режим из нескольких потоков: счётчики потоков сводятся в один снимок
+    const int numThreads = 4;
+    const int perThread = 2000;
+    {
+        logging::LoggerConfig config;
+        config.enableRotation = false;
+        config.enableAsync = true;
+        config.asyncQueueSize = 1024;
+        logging::Logger logger(testFile, config);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < numThreads; ++t) {
+            threads.emplace_back([&logger, t]() {
+                for (int i = 0; i < perThread; ++i) {
+                    logger.warning("thread {} record {}", t, i);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        ASSERT(logger.flush(), "Сброс должен пройти успешно");
+        stats = logger.getStats();
+    }
+    ASSERT(stats.acceptedTotal() == static_cast<uint64_t>(numThreads * perThread), "Счётчики потоков должны суммироваться");
+    ASSERT(stats.queueCapacity >= 1024, "Должна сообщаться ёмкость очереди");
+    ASSERT(stats.queueHighWater > 0 && stats.queueHighWater <= stats.queueCapacity, "Должна учитываться глубина очереди");
+    ASSERT(stats.bytesWritten == readFile(testFile).size(), "Записанные байты должны совпадать с размером файла");
+    cleanupFile(testFile);
+    
+    // Потери при переполнении видны в снимке
+    {
+        logging::LoggerConfig config;
+        config.enableRotation = false;
+        config.enableAsync = true;
+        config.asyncQueueSize = 2;
+        config.overflowPolicy = logging::OverflowPolicy::DROP_NEWEST;
+        logging::Logger logger(testFile, config);
+        for (int i = 0; i < 1000; ++i) {
+            logger.info("overflow {}", i);
+        }
+        stats = logger.getStats();
+        ASSERT(stats.dropped[info] == logger.getDroppedCount(logging::LogLevel::INFO), "Потери должны совпадать со счётчиком");
+    }
+    cleanupFile(testFile);
+    
+    // Сбор метрик отключается конфигурацией
+    {
+        logging::LoggerConfig config;
+        config.enableRotation = false;
+        config.collectStats = false;
+        logging::Logger logger(testFile, config);
+        logger.info("not counted");
+        logger.debug("not counted");
+        stats = logger.getStats();
+    }
+    ASSERT(stats.acceptedTotal() == 0 && stats.filteredTotal() == 0 && stats.bytesWritten == 0,
+           "При collectStats = false счётчики не растут");
+    cleanupFile(testFile);
+}
+
+ // Тест аварийного сброса при падении процесса
+
+// Санитайзеры сами обрабатывают SIGSEGV и завершают процесс своим кодом выхода
+#if defined(__SANITIZE_THREAD__) || defined(__SANITIZE_ADDRESS__)
+constexpr bool kSanitizerOwnsSegv = true;
+#else
+constexpr bool kSanitizerOwnsSegv = false;
+#endif
+
+// Дочерний процесс пишет записи, которые остаются в очереди и буфере, и падает через crash()
+int crashChild(const std::string& filename, logging::LoggerConfig config, int records,
+               const std::function<void()>& crash) {
+    pid_t child = fork();
+    if (child == 0) {
+        struct rlimit noCore{0, 0};
+        setrlimit(RLIMIT_CORE, &noCore); // без дампа памяти в рабочем каталоге
+        config.enableRotation = false;
+        config.flushOnCrash = true;
+        config.fileBufferSize = 1024 * 1024;
+        config.flushIntervalMs = 0;
+        config.flushLevel = logging::LogLevel::FATAL;
+        logging::Logger* logger = new logging::Logger(filename, config); // деструктор не вызывается
+        for (int i = 0; i < records; ++i) {
+            logger->info("crash record {}", i);
+        }
+        crash();
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    return WIFSIGNALED(status) ? WTERMSIG(status) : -1;
+}
+
+void testCrashFlush() {
+    const std::string testFile = "test_crash_flush.log";
+    const int records = 2000;
+    cleanupFile(testFile);
+    
+    // abort() в асинхронном режиме: очередь и буфер файла дописываются до завершения
+    logging::LoggerConfig config;
+    config.enableAsync = true;
+    config.asyncQueueSize = 4096;
+    int signo = crashChild(testFile, config, records, [] { std::abort(); });
+    ASSERT(signo == SIGABRT, "Процесс должен завершиться исходным сигналом");
+    std::string content = readFile(testFile);
+    ASSERT(countLines(content) == static_cast<size_t>(records), "Все записи должны пережить abort()");
+    ASSERT(content.find("] [INFO] crash record 0\n") != std::string::npos &&
+           content.find("] [INFO] crash record " + std::to_string(records - 1) + "\n") != std::string::npos,
+           "Записи должны быть в формате логгера");
+    std::regex line(R"(\[\d{4}-\d{2}-\d{2} \d{2}:\d{2}:\d{2}\.\d{3}\] \[INFO\] crash record \d+)");
+    std::istringstream lines(content);
+    int expected = 0;
+    for (std::string text; std::getline(lines, text); ++expected) {
+        ASSERT(std::regex_match(text, line), "Каждая строка должна быть целой записью: " + text);
+        ASSERT(text.substr(text.rfind(' ') + 1) == std::to_string(expected), "Записи должны идти по порядку");
+    }
+    cleanupFile(testFile);
+    
+    // std::terminate в синхронном режиме: буфер FileOutput
+    signo = crashChild(testFile, logging::LoggerConfig(), records, [] { std::terminate(); });
+    ASSERT(signo == SIGABRT, "После terminate процесс завершается через abort()");
+    ASSERT(countLines(readFile(testFile)) == static_cast<size_t>(records), "Буфер должен пережить std::terminate");
+    cleanupFile(testFile);
+    
+    // SIGSEGV с двоичным форматом: журнал остаётся декодируемым
+    config.recordFormat = logging::RecordFormat::BINARY;
+    signo = crashChild(testFile, config, records, [] { raise(SIGSEGV); });
+    ASSERT(signo == SIGSEGV || kSanitizerOwnsSegv, "Процесс должен завершиться исходным сигналом");
+    bool decoded = false;
+    std::vector<std::string> binaryLines = decodeBinaryLog(testFile, decoded);
+    ASSERT(decoded && binaryLines.size() == static_cast<size_t>(records), "Двоичный журнал должен быть полным");
+    cleanupFile(testFile);
+    
+    // emergencyFlush() без падения: записи уходят в файл один раз, логгер продолжает работу
+    {
+        logging::LoggerConfig buffered;
+        buffered.enableRotation = false;
+        buffered.enableAsync = true;
+        buffered.fileBufferSize = 1024 * 1024;
+        buffered.flushIntervalMs = 0;
+        buffered.flushLevel = logging::LogLevel::FATAL;
+        logging::Logger logger(testFile, buffered);
+        for (int i = 0; i < 100; ++i) {
+            logger.info("before {}", i);
+        }
+        ASSERT(logger.emergencyFlush(), "Аварийный сброс должен пройти успешно");
+        ASSERT(countLines(readFile(testFile)) == 100, "После сброса все записи должны быть в файле");
+        logger.info("after");
+        ASSERT(logger.flush(), "Логгер должен работать после аварийного сброса");
+    }
+    ASSERT(countLines(readFile(testFile)) == 101, "Записи не должны дублироваться");
+    cleanupFile(testFile);
+}
+
+ // Тест полей контекста: имя логгера, tid и теги потока после уровня
+void testContextFields() {
+    const std::string testFile = "test_context_fields.log";
+    cleanupFile(testFile);
+    
+    // Без имени, tid и тегов формат записи прежний
+    {
+        logging::LoggerConfig config;
+        config.enableRotation = false;
+        logging::Logger logger(testFile, config);
+        logger.info("plain");
+    }
+    std::regex plain(R"(^\[[^\]]+\] \[INFO\] plain\n$)");
+    ASSERT(std::regex_match(readFile(testFile), plain), "Без полей контекста формат не должен меняться");
+    cleanupFile(testFile);
+    
+    // Синхронный и асинхронный режим: контекст берётся у потока, вызвавшего log()
+    for (bool async : {false, true}) {
+        {
+            logging::LoggerConfig config;
+            config.enableRotation = false;
+            config.enableAsync = async;
+            config.loggerName = "db main";
+            config.threadIdField = true;
+            logging::Logger logger(testFile, config);
+            logging::LogContext::set("request", "42");
+            logger.info("first");
+            {
+                logging::ScopedLogTag user("user", "alice]x");
+                logging::ScopedLogTag request("request", "43");
+                logger.info("scoped {}", 1);
+            }
+            std::thread other([&logger]() {
+                logging::ScopedLogTag worker("worker", "7");
+                logger.warning("other thread");
+            });
+            other.join();
+            logger.info("after");
+            logging::LogContext::clear();
+            logger.info("cleared");
+            ASSERT(logger.flush(), "Сброс должен пройти успешно");
+        }
+        
+        std::istringstream lines(readFile(testFile));
+        std::string line;
+        std::vector<std::string> fields;
+        std::regex record(R"(^\[[^\]]+\] \[[A-Z]+\] (?:\[([^\]]*)\] )?(.*)$)");
+        while (std::getline(lines, line)) {
+            std::smatch match;
+            ASSERT(std::regex_match(line, match, record), "Строка должна разбираться: " + line);
+            fields.push_back(match[1].str() + "|" + match[2].str());
+        }
+        ASSERT(fields.size() == 5, "Должно быть записано 5 строк");
+        std::smatch tid;
+        ASSERT(std::regex_match(fields[0], tid, std::regex(R"(^logger=db_main tid=(\d+) request=42\|first$)")),
+               "Поля контекста: " + fields[0]);
+        const std::string self = tid[1].str();
+        ASSERT(fields[1] == "logger=db_main tid=" + self + " request=43 user=alice_x|scoped 1",
+               "Теги области видимости: " + fields[1]);
+        ASSERT(std::regex_match(fields[2], std::regex(R"(^logger=db_main tid=(\d+) worker=7\|other thread$)")) &&
+               fields[2].find("tid=" + self + " ") == std::string::npos, "Теги другого потока: " + fields[2]);
+        ASSERT(fields[3] == "logger=db_main tid=" + self + " request=42|after",
+               "После области видимости тег должен восстановиться: " + fields[3]);
+        ASSERT(fields[4] == "logger=db_main tid=" + self + "|cleared", "После clear() тегов быть не должно: " + fields[4]);
+        cleanupFile(testFile);
+    }
+}
+
+ // Тест кадрового протокола: согласование, сжатие, работа со старым сервером
+void testFramedTransport() {
+    namespace framed = logging::framed;
+    
+    // Кодировщик и декодер напрямую: кадры приходят любыми кусками, текст не меняется
+    {
+        framed::FrameEncoder encoder(framed::Codec::DEFLATE);
+        std::string text;
+        for (int i = 0; i < 20000; ++i) {
+            text += "[2026-01-01 00:00:00.000] [INFO] request " + std::to_string(i % 100) + " done\n";
+        }
+        std::string wire;
+        std::vector<framed::FrameEncoder::Boundary> boundaries;
+        ASSERT(encoder.encode(text, wire, boundaries), "Кодирование должно пройти успешно");
+        ASSERT(boundaries.size() > 1 && boundaries.back().wireEnd == wire.size() &&
+               boundaries.back().textEnd == text.size(), "Длинный текст должен резаться на кадры");
+        if (framed::compressionAvailable()) {
+            ASSERT(wire.size() * 5 < text.size(), "Повторяющиеся строки должны сжиматься");
+        }
+        
+        framed::FrameDecoder decoder;
+        std::string decoded;
+        for (size_t offset = 0; offset < wire.size(); offset += 777) {
+            ASSERT(decoder.feed(wire.data() + offset, std::min<size_t>(777, wire.size() - offset), decoded),
+                   "Декодирование должно пройти успешно");
+        }
+        ASSERT(decoded == text, "Текст после декодирования должен совпадать");
+        
+        std::string corrupt = wire;
+        corrupt[4] = static_cast<char>(0x7f); // неизвестный кодек
+        framed::FrameDecoder broken;
+        std::string ignored;
+        ASSERT(!broken.feed(corrupt.data(), corrupt.size(), ignored), "Повреждённый поток должен отвергаться");
+    }
+    
+    // Сервер с кадровым протоколом: записи логгера приходят сжатыми и целиком
+    {
+        TestLogServer server(0, true);
+        logging::LoggerConfig config;
+        config.socketCompression = true;
+        config.enableAsync = true;
+        logging::Logger logger("127.0.0.1", server.port(), config);
+        for (int i = 0; i < 3000; ++i) {
+            logger.info("compressed record {} of the same shape", i);
+        }
+        ASSERT(logger.flush(), "Сброс должен пройти успешно");
+        ASSERT(server.waitForLines(3000, std::chrono::seconds(5)), "Сервер должен получить все записи");
+        auto lines = server.lines();
+        ASSERT(lines.front().find("compressed record 0 ") != std::string::npos &&
+               lines.back().find("compressed record 2999 ") != std::string::npos, "Порядок записей должен сохраняться");
+    }
+    {
+        TestLogServer server(0, true);
+        logging::EnhancedSocketOutput output("127.0.0.1", server.port(), 50, 0, 4 * 1024 * 1024, true);
+        ASSERT(output.isFramed(), "Соединение должно перейти на кадры");
+        for (int i = 0; i < 2000; ++i) {
+            output.writeLog("framed record " + std::to_string(i));
+        }
+        ASSERT(output.waitDrained(std::chrono::seconds(5)), "Буфер должен быть отправлен");
+        ASSERT(server.waitForLines(2000, std::chrono::seconds(5)), "Сервер должен получить все записи");
+        if (framed::compressionAvailable()) {
+            ASSERT(output.sentWireBytes() * 3 < output.sentPayloadBytes(), "В сеть должно уходить меньше байтов");
+        }
+        
+        // Аварийный сброс в кадровом режиме — кадрами без сжатия
+        std::string_view record = "emergency record";
+        ASSERT(output.emergencyWrite(&record, 1, false), "Аварийная запись должна пройти успешно");
+        ASSERT(server.waitForLines(2001, std::chrono::seconds(5)) && server.lines().back() == record,
+               "Аварийная запись должна дойти в том же потоке кадров");
+    }
+    
+    // Старый сервер не отвечает на приветствие: клиент пишет обычный текст
+    {
+        TestLogServer server;
+        logging::EnhancedSocketOutput output("127.0.0.1", server.port(), 50, 0, 4 * 1024 * 1024, true);
+        ASSERT(output.isConnected() && !output.isFramed(), "Без ответа сервера соединение остаётся текстовым");
+        output.writeLog("plain record");
+        ASSERT(output.waitDrained(std::chrono::seconds(5)), "Буфер должен быть отправлен");
+        ASSERT(server.waitForLines(2, std::chrono::seconds(5)), "Сервер должен получить приветствие и запись");
+        auto lines = server.lines();
+        ASSERT(lines[0].rfind(std::string(framed::kHelloPrefix), 0) == 0 && lines[1] == "plain record",
+               "После приветствия должен идти обычный текст");
+    }
+}
+
+ // Тест чтения сегментов ротации: обычные как есть, .gz с распаковкой
+void testLogSegmentReader() {
+    const std::string testFile = "test_segment_reader.log";
+    auto cleanupSegments = [&testFile]() {
+        cleanupFile(testFile);
+        cleanupFile(testFile + ".truncated");
+        for (int i = 1; i <= 2; ++i) {
+            cleanupFile(testFile + "." + std::to_string(i));
+            cleanupFile(testFile + "." + std::to_string(i) + ".gz");
+        }
+    };
+    auto readAll = [](const std::string& name, bool& ok) {
+        logging::LogSegmentReader reader;
+        std::string text;
+        ok = reader.open(name);
+        char buffer[4096];
+        for (int64_t count; ok && (count = reader.read(buffer, sizeof(buffer))) != 0;) {
+            ok = count > 0;
+            if (ok) text.append(buffer, static_cast<size_t>(count));
+        }
+        return text;
+    };
+    cleanupSegments();
+    
+    const std::string line(511, 'S');
+    {
+        logging::EnhancedFileOutput output(testFile, 1, 1, true, 64 * 1024);
+        for (int i = 0; i < 2500; ++i) {
+            ASSERT(output.writeLog(line), "Запись должна пройти успешно");
+        }
+        output.flush();
+        output.rotator().waitIdle();
+    }
+    
+    // Текущий файл читается без изменений
+    bool ok = false;
+    std::string current = readAll(testFile, ok);
+    ASSERT(ok && current == readFile(testFile), "Обычный файл должен читаться как есть");
+    
+    const bool compressed = std::filesystem::exists(testFile + ".1.gz");
+    const std::string segment = testFile + (compressed ? ".1.gz" : ".1");
+    std::string text = readAll(segment, ok);
+    ASSERT(ok, "Сегмент должен читаться без ошибок");
+    ASSERT(!text.empty() && text.size() % (line.size() + 1) == 0 &&
+           text.find_first_not_of("S\n") == std::string::npos, "Сегмент должен содержать записанные строки");
+    
+    if (compressed) {
+        logging::LogSegmentReader reader;
+        ASSERT(reader.open(segment) && reader.compressed(), "Сегмент .gz должен распознаваться как сжатый");
+        
+        // Оборванный .gz — ошибка чтения, а не тихий конец файла
+        std::string gz = readFile(segment);
+        {
+            std::ofstream truncated(testFile + ".truncated", std::ios::binary);
+            truncated.write(gz.data(), static_cast<std::streamsize>(gz.size() / 2));
+        }
+        readAll(testFile + ".truncated", ok);
+        ASSERT(!ok, "Оборванный сжатый сегмент должен давать ошибку");
+    }
+    
+    cleanupSegments();
+}
+
+ // Тест реестра логгеров: общий ленивый вывод и подключение к сборщику в фоне
+void testLoggerRegistry() {
+    const std::string testFile = "test_registry.log";
+    auto exists = [](const std::string& name) { return std::filesystem::exists(name); };
+    cleanupFile(testFile);
+    
+    // Logger(const LoggerConfig&) с lazyOpen: файл создаёт первая запись выше уровня
+    {
+        logging::LoggerConfig config;
+        config.filename = testFile;
+        config.enableRotation = false;
+        config.lazyOpen = true;
+        logging::Logger logger(config);
+        ASSERT(logger.isValid(), "Ленивый логгер должен быть валидным до открытия файла");
+        logger.debug("filtered record");
+        ASSERT(!exists(testFile), "Отфильтрованная запись не должна открывать файл");
+        ASSERT(logger.info("first record"), "Первая запись должна открыть файл");
+        ASSERT(logger.flush() && readFile(testFile).find("first record") != std::string::npos,
+               "Запись должна попасть в файл");
+    }
+    cleanupFile(testFile);
+    {
+        logging::Logger logger{logging::LoggerConfig()};
+        ASSERT(!logger.isValid() && logger.getLastError() == logging::LoggingError::CONFIG_PARSE_ERROR,
+               "Конфигурация без вывода должна давать ошибку");
+    }
+    
+    // Логгеры реестра с одним файлом делят вывод и поток записи
+    auto& registry = logging::LoggerRegistry::instance();
+    registry.clear();
+    {
+        logging::LoggerConfig config;
+        config.filename = testFile;
+        config.enableRotation = false;
+        auto db = registry.get("db", config);
+        config.filename = "./" + testFile; // тот же файл другим путём
+        auto net = registry.get("net", config);
+        ASSERT(db && net && db != net, "Разные имена — разные логгеры");
+        ASSERT(registry.get("db", config) == db && registry.find("net") == net, "Имя должно давать тот же логгер");
+        ASSERT(registry.size() == 2, "В реестре должно быть два логгера");
+        ASSERT(!exists(testFile), "Регистрация не должна открывать файл");
+        
+        net->setDefaultLevel(logging::LogLevel::WARNING);
+        net->info("below the level");
+        constexpr int kThreads = 4;
+        constexpr int kRecords = 500;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; ++t) {
+            threads.emplace_back([&, t] {
+                auto& logger = t % 2 ? *net : *db;
+                for (int i = 0; i < kRecords; ++i) {
+                    logger.warning("thread {} record {}", t, i);
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        ASSERT(registry.flushAll(), "Сброс всех логгеров должен пройти");
+        
+        std::istringstream content(readFile(testFile));
+        int fromDb = 0;
+        int fromNet = 0;
+        for (std::string line; std::getline(content, line);) {
+            ASSERT(line.find("] [WARNING] [logger=") != std::string::npos, "Строки не должны перемешиваться");
+            fromDb += line.find("[logger=db] thread ") != std::string::npos;
+            fromNet += line.find("[logger=net] thread ") != std::string::npos;
+        }
+        ASSERT(fromDb == kThreads / 2 * kRecords && fromNet == kThreads / 2 * kRecords,
+               "Все записи обоих логгеров должны быть в общем файле");
+        
+        registry.remove("db");
+        ASSERT(!registry.find("db") && db->info("still usable"), "Взятый логгер работает и после remove");
+    }
+    registry.clear();
+    ASSERT(registry.size() == 0, "Реестр должен быть пуст после clear");
+    ASSERT(readFile(testFile).find("still usable") != std::string::npos, "Закрытие вывода дописывает очередь");
+    cleanupFile(testFile);
+    
+    // Важную запись общий вывод сбрасывает сам: без flush() она доходит до файла
+    {
+        logging::LoggerConfig config;
+        config.filename = testFile;
+        config.enableRotation = false;
+        config.fileBufferSize = 1024 * 1024;
+        config.flushIntervalMs = 0;
+        auto logger = registry.get("flush", config);
+        ASSERT(logger->info("buffered info") && logger->warning("flushed warning"), "Записи должны приниматься");
+        bool flushed = false;
+        for (int attempt = 0; attempt < 500 && !flushed; ++attempt) {
+            flushed = readFile(testFile).find("flushed warning") != std::string::npos;
+            if (!flushed) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+        ASSERT(flushed && readFile(testFile).find("buffered info") != std::string::npos,
+               "Поток вывода должен сбросить файл после WARNING");
+    }
+    registry.clear();
+    cleanupFile(testFile);
+    
+    // Фоновое подключение: конструктор не ждёт сборщик
+    {
+        TestLogServer server;
+        logging::LoggerConfig config;
+        config.host = "127.0.0.1";
+        config.port = server.port();
+        config.connectInBackground = true;
+        logging::Logger logger(config);
+        ASSERT(logger.info("sent after background connect"), "Запись до подключения должна буферизоваться");
+        ASSERT(server.waitForLines(1, std::chrono::seconds(5)), "Запись должна дойти после подключения");
+    }
+    {
+        // Немаршрутизируемый адрес: синхронное подключение ждало бы таймаута
+        logging::LoggerConfig config;
+        config.host = "10.255.255.1";
+        config.port = 9;
+        config.reconnectIntervalMs = 200;
+        config.maxReconnectAttempts = 1;
+        config.connectInBackground = true;
+        auto started = std::chrono::steady_clock::now();
+        logging::Logger logger(config);
+        ASSERT(std::chrono::steady_clock::now() - started < std::chrono::milliseconds(100),
+               "Конструктор не должен ждать подключения");
+    }
+}
+
 int main() {
     TestRunner runner;
     
@@ -510,6 +2482,31 @@ int main() {
     runner.runTest("Повторное открытие/закрытие", testRepeatedOpenClose);
     runner.runTest("Все уровни логирования", testAllLogLevels);
     runner.runTest("Форматирование времени", testTimestampFormatting);
+    runner.runTest("Асинхронное логирование", testAsyncLogging);
+    runner.runTest("Переключение асинхронного режима", testAsyncToggle);
+    runner.runTest("Политики переполнения очереди", testAsyncOverflowPolicies);
+    runner.runTest("Буферизованная запись в файл", testBufferedFileOutput);
+    runner.runTest("Настройка временной метки", testTimestampConfig);
+    runner.runTest("Форматированная запись", testFormattedLogging);
+    runner.runTest("Макросы LOG_*", testLogMacros);
+    runner.runTest("Смена конфигурации под нагрузкой", testConcurrentReconfiguration);
+    runner.runTest("Ротация журналов", testLogRotation);
+    runner.runTest("Сетевой вывод", testSocketOutput);
+    runner.runTest("Сетевой вывод с переподключением", testEnhancedSocketOutput);
+    runner.runTest("Комбинированная синхронная запись", testCombinedSyncWrites);
+    runner.runTest("Двоичный формат записей", testBinaryRecordFormat);
+    runner.runTest("Вывод через отображение в память", testMappedFileOutput);
+    runner.runTest("Несколько выводов", testMultipleOutputs);
+    runner.runTest("Пакетная запись", testWriteBatch);
+    runner.runTest("Вывод через io_uring", testIoUringOutput);
+    runner.runTest("Пул записей очереди", testRecordArena);
+    runner.runTest("Ограничение частоты и повторы", testRateLimitAndRepeats);
+    runner.runTest("Метрики логгера", testLoggerStats);
+    runner.runTest("Аварийный сброс при падении", testCrashFlush);
+    runner.runTest("Поля контекста записи", testContextFields);
+    runner.runTest("Кадровый протокол со сжатием", testFramedTransport);
+    runner.runTest("Чтение сегментов ротации", testLogSegmentReader);
+    runner.runTest("Реестр логгеров", testLoggerRegistry);
     
     runner.printSummary();
     